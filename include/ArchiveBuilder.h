@@ -0,0 +1,57 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "Task.h"
+
+/**
+ * @brief Class building frame archives from air scan dumps.
+ *
+ * Every air scan dump is added as frame named after its file name without
+ * directory and extension, or as given by 'name=file'. Frames of an existing
+ * archive are kept unless replaced by a frame of the same name. Dumps given
+ * as 'archive:name' are copied from another archive.
+ */
+class ArchiveBuilder : public Task {
+public:
+    /// Class constructor.
+    ArchiveBuilder(Configuration & configuration,
+        const std::string & archiveFile);
+
+    /// Add an air scan dump to the archive.
+    void addDumpFile(const std::string & dumpFile);
+
+    /// Start building the archive.
+    int start(void) final;
+
+private:
+    /// File name of the frame archive.
+    const std::string archiveFile_;
+
+    /// Air scan dumps to be added, optionally prefixed by 'name='.
+    std::vector<std::string> dumpFiles_;
+
+    /// Split a dump file argument into frame name and file name.
+    static bool getFrameName(const std::string & argument, std::string & name,
+        std::string & file);
+};
@@ -0,0 +1,107 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "Task.h"
+#include "Transmitter.h"
+#include "Types.h"
+
+/**
+ * @brief Class measuring the timing fidelity of the transmit path.
+ *
+ * Pulse trains are sent through the regular transmitter with a loopback
+ * backend capturing the actual time of every edge instead of driving the GPIO
+ * pin. The deviation from the scheduled edge times is reported per pulse
+ * train as tab separated values.
+ */
+class Benchmark : public Task {
+public:
+    /// Selection benchmarking all configured targets.
+    static const char * const ALL_TARGETS;
+
+    /// Selection benchmarking a built-in set of synthetic frames.
+    static const char * const SYNTHETIC;
+
+    /// Class constructor.
+    Benchmark(Configuration & configuration, const std::string & selection);
+
+    /// Start the benchmark.
+    int start(void) final;
+
+private:
+    /// Transmitter capturing edge times instead of driving the GPIO pin.
+    class Loopback : public Transmitter {
+    public:
+        /// Class constructor.
+        Loopback(const size_t edgeCount);
+
+        /**
+         * @brief Scheduled times of all captured edges, the last element is
+         *        the scheduled end of the transmission.
+         * @note Unit: nanoseconds
+         */
+        std::vector<int64_t> scheduledNs;
+
+        /**
+         * @brief Actual times of all captured edges, the last element is the
+         *        actual end of the transmission.
+         * @note Unit: nanoseconds
+         */
+        std::vector<int64_t> actualNs;
+
+    protected:
+        /// Do not touch the GPIO pin.
+        void begin(void) final;
+
+        /// Capture the edge time.
+        void write(const bool level, const int64_t deadlineNs) final;
+
+        /// Capture the end time.
+        void end(const int64_t deadlineNs) final;
+    };
+
+    /// Target name, ALL_TARGETS or SYNTHETIC.
+    const std::string selection_;
+
+    /// Benchmark a configured target.
+    bool benchmarkTarget(const std::string & name) const;
+
+    /// Benchmark the synthetic frames.
+    void benchmarkSynthetic(void) const;
+
+    /// Transmit a pulse train through the loopback and report the result.
+    void benchmarkPulses(const std::string & name,
+        const std::vector<Types::Pulse> & pulses, const int32_t sendCommand,
+        const int32_t sendDelayUs) const;
+
+    /// Evaluate and print the captured edges of a transmission.
+    static void report(const std::string & name, const int32_t frames,
+        const Loopback & loopback);
+
+    /// Get the given percentile of sorted values.
+    static int64_t getPercentile(const std::vector<int64_t> & sortedValues,
+        const uint32_t percent);
+};
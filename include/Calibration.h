@@ -0,0 +1,61 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Configuration.h"
+#include "Task.h"
+
+/**
+ * @brief Class measuring the timing characteristics of the host.
+ *
+ * Measures the sleep overshoot, the GPIO write duration and the spin loop rate
+ * and stores them as timing profile, see TimingProfile. The GPIO pin is only
+ * written low, i.e. nothing is transmitted while calibrating.
+ */
+class Calibration : public Task {
+public:
+    /// Class constructor.
+    Calibration(Configuration & configuration);
+
+    /// Start the calibration.
+    int start(void) final;
+
+private:
+    /**
+     * @brief Measure the duration of reading the clock.
+     * @return Average duration (unit: nanoseconds).
+     */
+    static int32_t measureClockRead(void);
+
+    /**
+     * @brief Measure how long sleeps end after their deadline.
+     * @return 99th percentile of the overshoot (unit: nanoseconds).
+     */
+    static int32_t measureSleepOvershoot(void);
+
+    /**
+     * @brief Measure the duration of writing the GPIO pin.
+     * @return Average duration (unit: nanoseconds).
+     */
+    int32_t measureGpioWrite(void) const;
+};
@@ -0,0 +1,188 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Class indexing the activity segments of an air scan dump.
+ *
+ * A segment is a sequence of edges without an idle gap of IDLE_GAP_US or
+ * longer, padded by up to PADDING_US of the surrounding samples, e.g. all
+ * frames of a single button press. The index is stored next to the dump file
+ * and allows replaying or extracting a segment by seeking to its samples
+ * instead of reading the whole dump. It is only used while the modification
+ * time and size of the dump file match the ones stored in the index.
+ *
+ * Format of the index file (native byte order):
+ * - [Header] Signature, version, dump file fingerprint and sample count
+ * - [n * Segment] Segments in ascending order
+ */
+class CaptureIndex {
+public:
+    /// File name suffix appended to the dump file location.
+    static const std::string SUFFIX;
+
+    /// Separator between dump file and selection, e.g. 'scan.asd@2'.
+    static const char SEPARATOR = '@';
+
+    /// File offset of the first sample of a dump file.
+    static const uint64_t SAMPLES_OFFSET = 2U * sizeof(uint32_t);
+
+    /// Range of samples of the dump.
+    struct Segment {
+        /// Index of the first sample.
+        uint64_t firstSample;
+
+        /// Number of samples.
+        uint64_t sampleCount;
+    };
+
+    /// Class constructor.
+    CaptureIndex(const std::string & dumpFile);
+
+    /// Split a replay file into dump file and selection.
+    static bool split(const std::string & file, std::string & dumpFile,
+        std::string & selection);
+
+    /// Start indexing samples taken at the given sampling rate.
+    void begin(const int32_t samplingRateUs);
+
+    /// Add the next sample.
+    void addSample(const bool level) {
+        if ((sampleCount_ > 0U) && (level != level_)) {
+            addEdge();
+        }
+        level_ = level;
+        sampleCount_++;
+    }
+
+    /// Finish indexing after the last sample.
+    void end(void);
+
+    /// Load the index file, fails if it is missing or outdated.
+    bool load(void);
+
+    /// Index the dump file by reading it once.
+    bool build(void);
+
+    /// Write the index file.
+    bool save(void) const;
+
+    /// Load the index file or build it if required.
+    bool open(void);
+
+    /// Select a segment by number or a time range.
+    bool select(const std::string & selection, Segment & segment) const;
+
+    /// Get all segments.
+    const std::vector<Segment> & getSegments(void) const;
+
+    /// Get the sampling rate of the dump.
+    int32_t getSamplingRate(void) const;
+
+private:
+    /// Signature to be used to identify index files.
+    static const uint32_t SIGNATURE = 0xA1C0DE1CU;
+
+    /// Version of the index file format.
+    static const uint32_t VERSION = 1U;
+
+    /**
+     * @brief Minimum duration without edges separating two segments.
+     * @note Unit: microseconds
+     */
+    static const int64_t IDLE_GAP_US = 100000;
+
+    /**
+     * @brief Samples kept before the first and after the last edge of a
+     *        segment.
+     * @note Unit: microseconds
+     */
+    static const int64_t PADDING_US = 10000;
+
+    /// Size of the buffer the dump file is read through.
+    static const size_t READ_BUFFER_SIZE = 65536U;
+
+    /// Index file header.
+    struct Header {
+        /// Signature of the index file.
+        uint32_t signature;
+
+        /// Version of the index file format.
+        uint32_t version;
+
+        /// Modification time of the dump file (seconds).
+        int64_t modificationTimeS;
+
+        /// Modification time of the dump file (nanoseconds).
+        int64_t modificationTimeNs;
+
+        /// Size of the dump file.
+        uint64_t size;
+
+        /// Number of samples of the dump file.
+        uint64_t sampleCount;
+
+        /// Delay between two samples (unit: microseconds).
+        int32_t samplingRateUs;
+
+        /// Number of segments.
+        uint32_t segmentCount;
+    };
+
+    /// File name of the air scan dump.
+    const std::string dumpFile_;
+
+    /**
+     * @brief Delay between two samples.
+     * @note Unit: microseconds
+     */
+    int32_t samplingRateUs_;
+
+    /// Number of samples indexed.
+    uint64_t sampleCount_;
+
+    /// Level of the previous sample.
+    bool level_;
+
+    /// Index of the last edge of the open segment.
+    uint64_t lastEdge_;
+
+    /// Flag whether a segment is open.
+    bool isOpen_;
+
+    /// Segments found.
+    std::vector<Segment> segments_;
+
+    /// Extend the open segment by an edge or open a new one.
+    void addEdge(void);
+
+    /// Close the open segment.
+    void closeSegment(void);
+
+    /// Get the given duration as number of samples.
+    uint64_t getSamples(const int64_t durationUs) const;
+
+    /// Determine the fingerprint of the dump file.
+    bool getFingerprint(Header & header) const;
+};
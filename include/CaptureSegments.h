@@ -0,0 +1,60 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "CaptureIndex.h"
+#include "Configuration.h"
+#include "Task.h"
+
+/**
+ * @brief Class listing the activity segments of an air scan dump or
+ *        extracting one of them into a dump file of its own.
+ *
+ * The segments are taken from the capture index of the dump, which is built
+ * if missing or outdated (see CaptureIndex).
+ */
+class CaptureSegments : public Task {
+public:
+    /// Class constructor.
+    CaptureSegments(Configuration & configuration, const std::string & file,
+        const std::string & dumpFile);
+
+    /// Start listing or extracting.
+    int start(void) final;
+
+private:
+    /// Size of the buffer samples are copied through.
+    static const size_t COPY_BUFFER_SIZE = 65536U;
+
+    /// Air scan dump, optionally followed by '@selection'.
+    const std::string file_;
+
+    /// File name of the dump the selection is extracted to.
+    const std::string dumpFile_;
+
+    /// Print all segments of the index.
+    static void list(const CaptureIndex & index);
+
+    /// Copy the samples of a segment into the dump file.
+    bool extract(const std::string & file, const CaptureIndex & index,
+        const CaptureIndex::Segment & segment) const;
+};
@@ -0,0 +1,46 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Class providing monotonic time stamps and absolute sleeps.
+ *
+ * Sleeping until absolute points in time instead of sleeping for relative
+ * durations prevents sleep overshoots from accumulating over a radio frame.
+ */
+class Clock {
+public:
+    /// Number of nanoseconds per microsecond.
+    static const int64_t NS_PER_US = 1000;
+
+    /// Number of nanoseconds per second.
+    static const int64_t NS_PER_S = 1000000000;
+
+    /**
+     * @brief Get the current monotonic time.
+     * @note Unit: nanoseconds
+     */
+    static int64_t now(void);
+
+    /// Sleep until the given monotonic time.
+    static void sleepUntil(const int64_t timeNs);
+};
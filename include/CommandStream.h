@@ -0,0 +1,53 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "Configuration.h"
+#include "Task.h"
+
+/**
+ * @brief Class executing a stream of commands within a single process.
+ *
+ * Commands are read line by line from a stream, so the configuration is
+ * loaded and the GPIO pins are initialized only once for all of them. A
+ * status line is written to stdout after every command, all other output of
+ * the commands is written to stderr.
+ */
+class CommandStream : public Task {
+public:
+    /// Class constructor.
+    CommandStream(Configuration & configuration, std::istream & stream);
+
+    /// Execute all commands until the end of the stream.
+    int start(void) final;
+
+private:
+    /// Stream providing the commands.
+    std::istream & stream_;
+
+    /// Execute a single command.
+    bool execute(const std::string & command, const std::string & argument);
+
+    /// Execute the given task with the options of the command stream.
+    bool execute(Task && task) const;
+};
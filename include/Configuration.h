@@ -21,24 +21,48 @@
 
 #include <cassert>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include <libconfig.h++>
 
+class TargetIndex;
+
 /// Class managing the program configuration.
 class Configuration {
 public:
     /// Default configuration file location.
     static const std::string DEFAULT_LOCATION;
 
+    /// Class constructor.
+    Configuration(void);
+
+    /// Class destructor.
+    ~Configuration(void);
+
     /// Set the absolute configuration file location.
     void setLocation(const std::string & location);
 
-    /// Load the configuration file.
+    /// Get the absolute configuration file location.
+    const std::string & getLocation(void) const;
+
+    /**
+     * @brief Load the configuration file.
+     * @note The file is parsed upon the first access of a section.
+     */
     bool load(void);
 
     /// Check whether the given section exists.
-    bool isValidSection(const std::string section) const;
+    bool isValidSection(const std::string & section) const;
+
+    /// Get the root section.
+    const libconfig::Setting & getRoot(void) const;
+
+    /// Get the given section, nullptr if it does not exist.
+    const libconfig::Setting * getSection(const std::string & section) const;
+
+    /// Get the index of all resolved targets, built upon first use.
+    const TargetIndex & getTargetIndex(void);
 
     /**
      * @brief Get the requested configuration value.
@@ -49,15 +73,10 @@ public:
      * @return True if the value has been loaded, false otherwise.
      */
     template <typename T>
-    bool getValue(const std::string section, const std::string name,
+    bool getValue(const std::string & section, const std::string & name,
             T & value) const {
-        assert(isLoaded_);
-        try {
-            return configuration_.getRoot()[section.c_str()].lookupValue(
-                name, value);
-        } catch (const libconfig::SettingNotFoundException &) {
-            return false;
-        }
+        const libconfig::Setting * setting = getSection(section);
+        return (setting != nullptr) && setting->lookupValue(name, value);
     }
 
 private:
@@ -67,6 +86,18 @@ private:
     /// Flag to determine whether the configuration has been loaded.
     bool isLoaded_ = false;
 
+    /// Flag to determine whether the configuration file has been parsed.
+    mutable bool isParsed_ = false;
+
+    /// Flag to determine whether parsing the configuration file failed.
+    mutable bool isParseFailed_ = false;
+
     /// Configuration data.
-    libconfig::Config configuration_;
+    mutable libconfig::Config configuration_;
+
+    /// Parse the configuration file unless already done.
+    bool parse(void) const;
+
+    /// Index of all resolved targets.
+    std::unique_ptr<TargetIndex> targetIndex_;
 };
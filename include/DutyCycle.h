@@ -0,0 +1,85 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Class limiting the airtime of every GPIO pin to a duty cycle.
+ *
+ * The airtime budget of a GPIO pin is a token bucket stored in a state file,
+ * shared by all program instances and kept across reboots. The bucket holds
+ * at most the airtime of one duty cycle window and is refilled continuously
+ * at the duty cycle rate. A transmission reserves its airtime upfront: if the
+ * budget is insufficient, the transmission is delayed until it has been
+ * refilled instead of being rejected. Reservations may drive the budget
+ * negative, so instances waiting for the same GPIO pin are scheduled one
+ * after the other. Transmissions of unknown airtime take it in chunks
+ * instead, only while the budget covers them, and must not exceed it.
+ */
+class DutyCycle {
+public:
+    /// Duty cycle window unless configured (unit: seconds).
+    static const int32_t DEFAULT_WINDOW_S = 3600;
+
+    /// Reserve airtime on the given GPIO pin.
+    static bool reserve(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t airtimeNs, int64_t & waitNs);
+
+    /// Take airtime on the given GPIO pin if the budget covers it.
+    static bool take(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t airtimeNs, int64_t & takenNs);
+
+    /// Account the deviation of the actual from the reserved airtime.
+    static bool adjust(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t deltaNs);
+
+private:
+    /// Absolute path prefix of the state files, completed by the GPIO pin.
+    static const std::string STATE_FILE_PREFIX;
+
+    /// Signature and version of the state files.
+    static const uint32_t SIGNATURE;
+
+    /// Layout of a state file.
+    struct State {
+        /// Signature and version of the state file.
+        uint64_t signature;
+
+        /**
+         * @brief Remaining airtime budget, negative if reserved in advance.
+         * @note Unit: nanoseconds
+         */
+        double budgetNs;
+
+        /**
+         * @brief Wall clock time the budget has been updated at.
+         * @note Unit: nanoseconds since the epoch
+         */
+        int64_t updatedNs;
+    };
+
+    /// Lock the state file of the given GPIO pin and refill its budget.
+    static int load(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, State & state);
+
+    /// Write the state file of the given GPIO pin and unlock it.
+    static bool store(const uint8_t gpioPin, const int fd, const State & state);
+};
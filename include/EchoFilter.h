@@ -0,0 +1,66 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "EdgeQueue.h"
+
+/**
+ * @brief Class recognizing the echo of written edges among captured ones.
+ *
+ * A receiver hearing the transmitter captures every written edge again right
+ * after it has been written, i.e. by the next sample. A captured edge is the
+ * echo of a written edge of the same level if it has been captured within
+ * ECHO_SAMPLES sampling periods after it. Every written edge matches at most
+ * one captured edge and is forgotten once this window has passed, so captured
+ * edges never match the written copy of an older edge. Real edges following a
+ * written edge of the same level that closely are ignored as well, so pulse
+ * trains whose period is within a sampling period above the latency cannot be
+ * repeated completely.
+ *
+ * Edges are written in the order they have been captured, a long time after
+ * the edges captured meanwhile. Written edges are therefore kept in a queue
+ * instead of only the last one.
+ */
+class EchoFilter {
+public:
+    /// Class constructor.
+    EchoFilter(const int64_t samplingRateNs);
+
+    /// Remember an edge written to the GPIO pin.
+    void addWritten(const bool level, const int64_t writtenNs);
+
+    /// Check whether a captured edge is the echo of a written edge.
+    bool isEcho(const EdgeQueue::Edge & edge);
+
+private:
+    /// Number of sampling periods an echo is captured within.
+    static const int64_t ECHO_SAMPLES = 1;
+
+    /**
+     * @brief Time after a written edge its echo is captured within.
+     * @note Unit: nanoseconds
+     */
+    const int64_t windowNs_;
+
+    /// Written edges whose echo has not been captured yet, in write order.
+    std::deque<EdgeQueue::Edge> written_;
+};
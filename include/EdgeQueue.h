@@ -0,0 +1,93 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Lock-free queue handing over edges from one thread to another.
+ *
+ * The queue is a ring buffer of fixed capacity allocated upfront. Exactly one
+ * thread may push and exactly one other thread may pop, neither of them ever
+ * blocks: pushing fails if the queue is full, popping if it is empty. The
+ * read and write positions are kept on separate cache lines, so the threads
+ * do not contend for them.
+ */
+class EdgeQueue {
+public:
+    /// Change of a signal level.
+    struct Edge {
+        /**
+         * @brief Monotonic time the level has been sampled at.
+         * @note Unit: nanoseconds
+         */
+        int64_t timeNs;
+
+        /// Signal level, false=low / true=high.
+        bool level;
+    };
+
+    /// Class constructor.
+    EdgeQueue(const size_t capacity);
+
+    /// Append an edge, must only be called by the producing thread.
+    bool push(const Edge & edge) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) == edges_.size()) {
+            return false;
+        }
+        edges_[tail & mask_] = edge;
+        tail_.store(tail + 1U, std::memory_order_release);
+
+        return true;
+    }
+
+    /// Remove the oldest edge, must only be called by the consuming thread.
+    bool pop(Edge & edge) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        edge = edges_[head & mask_];
+        head_.store(head + 1U, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+    /// Size of a cache line, separating the read and write positions.
+    static const size_t CACHE_LINE_SIZE = 64U;
+
+    /// Edge storage, the capacity is a power of two.
+    std::vector<Edge> edges_;
+
+    /// Mask mapping positions to storage indices.
+    const size_t mask_;
+
+    /// Read position, only advanced by the consuming thread.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+
+    /// Write position, only advanced by the producing thread.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+};
@@ -0,0 +1,151 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Encoder.h"
+#include "Types.h"
+
+/**
+ * @brief Namespace for targets embedded into the program at build time.
+ *
+ * `make embed` generates a header from the configuration file which defines
+ * the pulse trains of all targets as constant tables, encoded at compile time.
+ * Targets using user-defined encodings are embedded as pre-encoded tables.
+ * Embedded targets are sent without parsing the configuration file and without
+ * any heap allocation, all other targets are loaded from the configuration.
+ */
+namespace Embedded {
+
+/// Target embedded at build time.
+struct Target {
+    /// Target name.
+    const char * name;
+
+    /// GPIO pin.
+    uint8_t gpioPin;
+
+    /// Number of times the air command will be transmitted.
+    int32_t sendCommand;
+
+    /**
+     * @brief Delay between repeated air command transmissions.
+     * @note Unit: microseconds
+     */
+    int32_t sendDelayUs;
+
+    /**
+     * @brief Maximum edge error of a frame before it is retransmitted.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if frames are not
+     *       checked.
+     */
+    int32_t frameToleranceUs;
+
+    /// Maximum number of retransmitted frames.
+    int32_t maxRetransmissions;
+
+    /**
+     * @brief Time the channel must be idle before every frame.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if the channel is
+     *       not sensed.
+     */
+    int32_t listenBeforeTalkUs;
+
+    /**
+     * @brief Maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t dutyCyclePpm;
+
+    /**
+     * @brief Window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t dutyCycleWindowS;
+
+    /// Pulse train of a single air command transmission.
+    const Types::Pulse * pulses;
+
+    /// Number of pulses of the pulse train.
+    uint32_t pulseCount;
+};
+
+/**
+ * @brief Pulse train with a size known at compile time.
+ * @tparam N Number of pulses.
+ */
+template <size_t N>
+struct PulseTable {
+    /// Pulses of the pulse train.
+    Types::Pulse pulses[N];
+};
+
+/**
+ * @brief Count the pulses of the given air command at compile time.
+ * @param airCode Radio frame encoding type.
+ * @param airCommand Null-terminated sequence of data and sync elements.
+ * @return Number of pulses.
+ */
+constexpr size_t countPulses(const Types::AirCode::AirCode_ airCode,
+        const char * airCommand) {
+    size_t count = 0U;
+    double carryNs = 0.0;
+
+    for (size_t i = 0U; airCommand[i] != '\0'; i++) {
+        count += Encoder::encodeElement(Encoder::getBuiltIn(airCode),
+            airCommand[i], 1, 1, carryNs).count;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Encode the given air command at compile time.
+ * @tparam N Number of pulses, see countPulses().
+ * @copydetails Encoder::encode()
+ */
+template <size_t N>
+constexpr PulseTable<N> encode(const Types::AirCode::AirCode_ airCode,
+        const char * airCommand, const int32_t dataLengthUs,
+        const int32_t syncLengthUs) {
+    PulseTable<N> table = {};
+    size_t count = 0U;
+    double carryNs = 0.0;
+
+    for (size_t i = 0U; airCommand[i] != '\0'; i++) {
+        const Encoder::Element element = Encoder::encodeElement(
+            Encoder::getBuiltIn(airCode), airCommand[i], dataLengthUs,
+            syncLengthUs, carryNs);
+        for (uint32_t pulse = 0U; pulse < element.count; pulse++) {
+            table.pulses[count++] = element.pulses[pulse];
+        }
+    }
+
+    return table;
+}
+
+/// Find the embedded target with the given name, nullptr if not embedded.
+const Target * find(const std::string & name);
+
+} // namespace Embedded
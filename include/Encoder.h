@@ -0,0 +1,218 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+/**
+ * @brief Class translating air commands into pulse trains.
+ *
+ * An encoding defines the pulses of every valid air command element as a
+ * sequence of steps, each step being a signal level and a fraction of either
+ * the data length or the sync length. The built-in encodings are defined as
+ * constant tables, user-defined encodings are parsed from the configuration
+ * (see EncodingIndex) into the very same representation.
+ *
+ * The pulse train of a target is computed once when loading its parameters,
+ * transmitting it afterwards only requires writing the pulse levels. Encoding
+ * is available at compile time as well, this allows embedding pulse trains
+ * into the program (see Embedded).
+ */
+class Encoder {
+public:
+    /// Maximum number of pulses of a single air command element.
+    static constexpr uint32_t MAX_ELEMENT_PULSES = 8U;
+
+    /// Maximum step duration as multiple of the base length.
+    static constexpr uint32_t MAX_STEP_FRACTION = 4U;
+
+    /// Length the duration of a step is relative to.
+    enum Base : uint32_t {
+        DATA_LENGTH = 0U,
+        SYNC_LENGTH = 1U
+    };
+
+    /// Single pulse of an element definition.
+    struct Step {
+        /// Signal level, 0=low / 1=high.
+        uint32_t level;
+
+        /// Numerator of the fraction of the base length.
+        uint32_t numerator;
+
+        /// Denominator of the fraction of the base length.
+        uint32_t denominator;
+
+        /// Base length the fraction is applied to.
+        Base base;
+    };
+
+    /// Definition of a single air command element.
+    struct Symbol {
+        /// Element character as used in air commands.
+        char element;
+
+        /// Number of valid steps.
+        uint32_t stepCount;
+
+        /// Steps of the element.
+        Step steps[MAX_ELEMENT_PULSES];
+    };
+
+    /// Radio frame encoding, i.e. the definitions of all valid elements.
+    struct Encoding {
+        /// Encoding name.
+        const char * name;
+
+        /// Definitions of all valid elements.
+        const Symbol * symbols;
+
+        /// Number of element definitions.
+        uint32_t symbolCount;
+    };
+
+    /// Pulses of a single air command element.
+    struct Element {
+        /// Pulses of the element.
+        Types::Pulse pulses[MAX_ELEMENT_PULSES];
+
+        /// Number of valid pulses.
+        uint32_t count;
+    };
+
+    /// Get the built-in encoding of the given type.
+    static constexpr const Encoding & getBuiltIn(
+            const Types::AirCode::AirCode_ airCode) {
+        return BUILT_IN[airCode];
+    }
+
+    /// Get the elements valid for the given encoding.
+    static std::string getElements(const Encoding & encoding);
+
+    /// Parse a user-defined element definition.
+    static bool parseSymbol(const std::string & definition, Symbol & symbol,
+        std::string & error);
+
+    /// Encode the given air command into a pulse train.
+    static std::vector<Types::Pulse> encode(const Encoding & encoding,
+        const std::string & airCommand, const int32_t dataLengthUs,
+        const int32_t syncLengthUs);
+
+    /**
+     * @brief Encode a single air command element.
+     *
+     * Pulse durations are rounded to nanoseconds, the rounding error is carried
+     * forward to the next pulse. This way an encoded frame always lasts
+     * exactly as long as the sum of its element lengths.
+     *
+     * @param encoding Radio frame encoding.
+     * @param element Data or sync element, elements not defined by the
+     *                encoding result in no pulses.
+     * @param dataLengthUs Pulse length of a single data element (unit:
+     *                     microseconds).
+     * @param syncLengthUs Pulse length of a single sync element (unit:
+     *                     microseconds).
+     * @param carryNs Rounding error carried from the previous pulse to the
+     *                next pulse (unit: nanoseconds), must be 0 at frame start.
+     * @return Pulses of the element.
+     */
+    static constexpr Element encodeElement(const Encoding & encoding,
+            const char element, const int32_t dataLengthUs,
+            const int32_t syncLengthUs, double & carryNs) {
+        Element result = {};
+
+        for (uint32_t i = 0U; i < encoding.symbolCount; i++) {
+            const Symbol & symbol = encoding.symbols[i];
+            if (symbol.element != element) {
+                continue;
+            }
+
+            for (uint32_t j = 0U; j < symbol.stepCount; j++) {
+                const Step & step = symbol.steps[j];
+                const int32_t lengthUs = (step.base == SYNC_LENGTH)
+                    ? syncLengthUs : dataLengthUs;
+                const double exactNs = static_cast<double>(lengthUs) * 1000.0
+                    * step.numerator / step.denominator + carryNs;
+                const uint32_t durationNs = (exactNs > 0.0)
+                    ? static_cast<uint32_t>(exactNs + 0.5) : 0U;
+
+                result.pulses[result.count].level = step.level;
+                result.pulses[result.count].durationNs = durationNs;
+                result.count++;
+                carryNs = exactNs - durationNs;
+            }
+            break;
+        }
+
+        return result;
+    }
+
+private:
+    //                   _           _               _
+    // Manchester:    0)  |_    1) _|     s) _    S)
+    static constexpr Symbol MANCHESTER[] = {
+        { 's', 1U, { { 0U, 1U, 1U, SYNC_LENGTH } } },
+        { 'S', 1U, { { 1U, 1U, 1U, SYNC_LENGTH } } },
+        { '0', 2U, { { 1U, 1U, 2U, DATA_LENGTH },
+            { 0U, 1U, 2U, DATA_LENGTH } } },
+        { '1', 2U, { { 0U, 1U, 2U, DATA_LENGTH },
+            { 1U, 1U, 2U, DATA_LENGTH } } }
+    };
+
+    //                   _           ___
+    // RCO:           0)  |___    1)    |_
+    static constexpr Symbol REMOTE_CONTROLLED_OUTLET[] = {
+        { '0', 2U, { { 1U, 1U, 4U, DATA_LENGTH },
+            { 0U, 3U, 4U, DATA_LENGTH } } },
+        { '1', 2U, { { 1U, 3U, 4U, DATA_LENGTH },
+            { 0U, 1U, 4U, DATA_LENGTH } } }
+    };
+
+    //                   _          _   _
+    // Tormatic:      0)  |__    1)  |_|
+    static constexpr Symbol TORMATIC[] = {
+        { '0', 2U, { { 1U, 1U, 3U, DATA_LENGTH },
+            { 0U, 2U, 3U, DATA_LENGTH } } },
+        { '1', 3U, { { 1U, 1U, 3U, DATA_LENGTH },
+            { 0U, 1U, 3U, DATA_LENGTH }, { 1U, 1U, 3U, DATA_LENGTH } } }
+    };
+
+    //                   _          __
+    // Melitec:       0)  |__    S)   |_
+    static constexpr Symbol MELITEC[] = {
+        { '0', 2U, { { 1U, 1U, 3U, DATA_LENGTH },
+            { 0U, 2U, 3U, DATA_LENGTH } } },
+        { 'S', 2U, { { 1U, 2U, 3U, SYNC_LENGTH },
+            { 0U, 1U, 3U, SYNC_LENGTH } } }
+    };
+
+    /// Built-in encodings, indexed by their encoding type.
+    static constexpr Encoding BUILT_IN[Types::AirCode::MAX] = {
+        { "manchester", MANCHESTER, sizeof(MANCHESTER) / sizeof(Symbol) },
+        { "rco", REMOTE_CONTROLLED_OUTLET,
+            sizeof(REMOTE_CONTROLLED_OUTLET) / sizeof(Symbol) },
+        { "tormatic", TORMATIC, sizeof(TORMATIC) / sizeof(Symbol) },
+        { "melitec", MELITEC, sizeof(MELITEC) / sizeof(Symbol) }
+    };
+};
@@ -0,0 +1,75 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Configuration.h"
+#include "Encoder.h"
+
+/**
+ * @brief Class holding all encodings available to targets.
+ *
+ * Besides the built-in encodings, encodings can be defined in the "encodings"
+ * section of the configuration. Every setting of the section defines an
+ * encoding named after the setting, consisting of a list of element
+ * definitions (see Encoder::parseSymbol()). Example:
+ *
+ *     encodings:
+ *     {
+ *         pt2262 = ( "0: H1/4 L3/4", "1: H3/4 L1/4", "S: H1/32s L31/32s" );
+ *     };
+ */
+class EncodingIndex {
+public:
+    /// Class constructor.
+    EncodingIndex(const Configuration & configuration);
+
+    /// Parse all user-defined encodings of the configuration.
+    void build(void);
+
+    /**
+     * @brief Find the encoding with the given name.
+     * @param name Name of a built-in or user-defined encoding.
+     * @param error Place to store an error description to.
+     * @return Encoding or nullptr if the encoding is unknown or invalid.
+     */
+    const Encoder::Encoding * find(const std::string & name,
+        std::string & error) const;
+
+private:
+    /// Reference of the related configuration instance.
+    const Configuration & configuration_;
+
+    /// Element definitions of all user-defined encodings, indexed by name.
+    std::unordered_map<std::string, std::vector<Encoder::Symbol>> symbols_;
+
+    /// All valid user-defined encodings, indexed by name.
+    std::unordered_map<std::string, Encoder::Encoding> encodings_;
+
+    /// Error descriptions of all invalid encodings, indexed by name.
+    std::unordered_map<std::string, std::string> errors_;
+
+    /// Parse a single user-defined encoding.
+    bool parse(const libconfig::Setting & setting,
+        std::vector<Encoder::Symbol> & symbols, std::string & error) const;
+};
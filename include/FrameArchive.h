@@ -0,0 +1,138 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Class storing many named air scan frames in a single file.
+ *
+ * A frame archive replaces a library of air scan dump files, one per button.
+ * It is memory-mapped and contains a hash table of all frame names, i.e.
+ * replaying a frame neither requires opening a file per frame nor reading the
+ * whole archive. Frames with identical samples are stored only once.
+ *
+ * Format of the archive file (native byte order):
+ * - [Header] Signature, version, number of records and buckets
+ * - [n * 4 bytes] Hash table buckets, index of the record + 1 or 0 if empty
+ * - [n * Record] Frame records
+ * - [n bytes] Names and samples referenced by the records, 1 byte per
+ *   sample, 0=low / 1=high
+ */
+class FrameArchive {
+public:
+    /// Separator between archive file and frame name, e.g. 'remote.asa:on'.
+    static const char SEPARATOR = ':';
+
+    /// Frame of the archive.
+    struct Frame {
+        /// Samples of the frame, 0=low / 1=high.
+        const uint8_t * samples;
+
+        /// Number of samples.
+        uint64_t sampleCount;
+
+        /**
+         * @brief Delay between two samples.
+         * @note Unit: microseconds
+         */
+        int32_t samplingRateUs;
+    };
+
+    /// Class constructor.
+    FrameArchive(const std::string & location);
+
+    /// Class destructor.
+    ~FrameArchive(void);
+
+    /// Split a replay file into archive location and frame name.
+    static bool split(const std::string & file, std::string & location,
+        std::string & name);
+
+    /// Map the archive file.
+    bool open(void);
+
+    /// Look up the frame with the given name.
+    bool find(const std::string & name, Frame & frame) const;
+
+    /// Get the names of all frames in ascending order.
+    std::vector<std::string> getNames(void) const;
+
+    /// Write the archive file for the given frames.
+    bool write(const std::map<std::string, Frame> & frames) const;
+
+private:
+    /// Signature to be used to identify archive files.
+    static const uint32_t SIGNATURE = 0xA1C0A5CAU;
+
+    /// Version of the archive file format.
+    static const uint32_t VERSION = 1U;
+
+    /// Archive file header.
+    struct Header {
+        /// Signature of the archive file.
+        uint32_t signature;
+
+        /// Version of the archive file format.
+        uint32_t version;
+
+        /// Number of records.
+        uint32_t recordCount;
+
+        /// Number of hash table buckets, always a power of two.
+        uint32_t bucketCount;
+    };
+
+    /// Archive file record describing a single frame.
+    struct Record {
+        /// Hash of the frame name.
+        uint64_t nameHash;
+
+        /// File offset and number of samples of the frame.
+        uint64_t samplesOffset, sampleCount;
+
+        /// File offset and length of the frame name.
+        uint32_t nameOffset, nameLength;
+
+        /// Delay between two samples (unit: microseconds).
+        int32_t samplingRateUs;
+
+        /// Padding for the alignment of the next record.
+        uint32_t reserved;
+    };
+
+    /// Location of the archive file.
+    const std::string location_;
+
+    /// Memory-mapped archive file or nullptr.
+    const uint8_t * data_;
+
+    /// Size of the memory-mapped archive file.
+    size_t size_;
+
+    /// Read the record with the given index.
+    bool getRecord(const uint32_t index, Record & record) const;
+
+    /// Check whether the given file range lies within the archive file.
+    bool isValidRange(const uint64_t offset, const uint64_t length) const;
+};
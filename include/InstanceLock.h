@@ -19,25 +19,47 @@
 
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <string>
 
 /**
- * @brief Class to avoid multiple program instances.
+ * @brief Class to avoid multiple program instances accessing the same GPIO pin.
  *
- * A lock file will be created. If another program instance is started in
- * parallel (and the lock file exists) the class will block execution until the
- * lock file has been removed (which is done at program exit automatically).
- * This will prevent accessing shared resources by multiple instances.
+ * A lock file will be created for every GPIO pin. If another program instance
+ * is using the same GPIO pin the class will block execution until the pin has
+ * been released (which is done at program exit automatically). Instances using
+ * different GPIO pins are not serialized.
+ *
+ * Waiting instances are served in FIFO order: every instance draws a ticket
+ * from a counter stored in the lock file and holds an open file description
+ * lock on the byte matching its ticket. An instance waits by blocking on the
+ * bytes of all its predecessors, i.e. it is woken up by the kernel as soon as
+ * every earlier instance released the pin or terminated, no matter in which
+ * order they did.
  */
 class InstanceLock {
 public:
-    /// Create a lock.
-    static void lock(void);
+    /// Acquire the lock of the given GPIO pin, blocking until it is available.
+    static bool lock(const uint8_t gpioPin);
+
+    /// Release the lock of the given GPIO pin.
+    static void unlock(const uint8_t gpioPin);
+
+    /// Release the locks of all GPIO pins.
+    static void unlockAll(void);
 
 private:
-    /// Absolute path of the lock file.
-    static const std::string LOCK_FILE;
+    /// Absolute path prefix of the lock files, completed by the GPIO pin.
+    static const std::string LOCK_FILE_PREFIX;
+
+    /// Offset of the ticket bytes within the lock file.
+    static const off_t TICKET_OFFSET;
+
+    /// Lock file descriptors of all locked GPIO pins.
+    static std::map<uint8_t, int> lockFiles_;
 
-    /// Release the lock.
-    static void unlock(void);
+    /// Apply the given lock type to a byte range of the lock file.
+    static bool setLock(const int fd, const short type, const off_t start,
+        const off_t length, const bool wait);
 };
@@ -0,0 +1,199 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Transmitter.h"
+
+/**
+ * @brief Class collecting operational metrics of all program instances.
+ *
+ * The counters are stored in a state file mapped into the memory of every
+ * instance, so they accumulate over all runs until the next reboot. Counters
+ * are updated with relaxed atomic operations: updates neither lock nor
+ * allocate memory, and are only applied after the time critical part of a
+ * task has finished.
+ *
+ * After every run the counters are exported in the Prometheus text format,
+ * ready to be picked up by the textfile collector of the node exporter. The
+ * export file is replaced atomically, i.e. scrapes never see partial data and
+ * never interact with running transmissions.
+ */
+class Metrics {
+public:
+    /// Enable metrics and export them to the given file.
+    static bool enable(const std::string & file);
+
+    /// Account a target transmission.
+    static void addTransmission(const std::string & target,
+        const Transmitter::Statistics & statistics, const int64_t durationNs);
+
+    /// Account an air scan replay.
+    static void addReplay(const uint64_t samples,
+        const uint32_t missedDeadlines, const int64_t durationNs);
+
+    /// Account an air scan.
+    static void addScan(const uint64_t samples, const int64_t durationNs);
+
+    /// Account the time spent waiting for the instance lock.
+    static void addLockWait(const int64_t waitNs);
+
+    /// Export the metrics to the file given upon enabling.
+    static bool write(void);
+
+private:
+    /// Absolute path of the state file.
+    static const char * const STATE_FILE;
+
+    /// Maximum number of targets with individual metrics.
+    static const size_t MAX_TARGETS = 64U;
+
+    /// Maximum length of a target name, longer names will be truncated.
+    static const size_t MAX_NAME_LENGTH = 64U;
+
+    /// Number of duration histogram buckets, excluding the +Inf bucket.
+    static const size_t DURATION_BUCKETS = 6U;
+
+    /**
+     * @brief Upper bounds of the duration histogram buckets.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t DURATION_BOUNDS_NS[DURATION_BUCKETS];
+
+    /// Atomic counter shared by all instances.
+    typedef std::atomic<uint64_t> Counter;
+
+    /// Histogram of durations.
+    struct Histogram {
+        /// Observations per bucket, the last bucket is +Inf.
+        Counter buckets[DURATION_BUCKETS + 1U];
+
+        /// Sum of all observations (unit: nanoseconds).
+        Counter sumNs;
+    };
+
+    /// Metrics of a single target.
+    struct Target {
+        /// Hash of the target name, 0 if the slot is unused.
+        Counter nameHash;
+
+        /// Non-zero as soon as the name has been stored.
+        std::atomic<uint32_t> isNamed;
+
+        /// Target name, null terminated.
+        char name[MAX_NAME_LENGTH];
+
+        /// Number of transmissions.
+        Counter transmissions;
+
+        /// Number of transmitted frames.
+        Counter frames;
+
+        /// Number of frames exceeding the frame tolerance.
+        Counter badFrames;
+
+        /// Number of retransmitted frames.
+        Counter retransmissions;
+
+        /// Number of missed deadlines.
+        Counter missedDeadlines;
+
+        /// Number of times a frame has been postponed for a busy channel.
+        Counter backoffs;
+
+        /// Number of frames sent into a busy channel after all backoffs.
+        Counter busyFrames;
+
+        /// Time spent transmitting (unit: nanoseconds).
+        Counter durationNs;
+    };
+
+    /// Metric family with one sample per target.
+    struct TargetFamily {
+        /// Metric name.
+        const char * name;
+
+        /// Help text.
+        const char * help;
+
+        /// Counter of the target.
+        Counter Target::*counter;
+
+        /// Flag whether the counter is a duration exported in seconds.
+        bool isDuration;
+    };
+
+    /// Number of metric families with one sample per target.
+    static const size_t TARGET_FAMILY_COUNT = 8U;
+
+    /// Metric families with one sample per target.
+    static const TargetFamily TARGET_FAMILIES[TARGET_FAMILY_COUNT];
+
+    /// Layout of the state file.
+    struct State {
+        /// Time spent waiting for the instance lock.
+        Histogram lockWaits;
+
+        /// Duration of the target transmissions.
+        Histogram transmissions;
+
+        /// Duration of the replays.
+        Histogram replays;
+
+        /// Number of replayed samples.
+        Counter replaySamples;
+
+        /// Number of missed deadlines while replaying.
+        Counter replayMissedDeadlines;
+
+        /// Duration of the air scans.
+        Histogram scans;
+
+        /// Number of scanned samples.
+        Counter scanSamples;
+
+        /// Metrics of the individual targets, open addressing by name hash.
+        Target targets[MAX_TARGETS];
+    };
+
+    /// Mapped state file, nullptr if metrics are disabled.
+    static State * state_;
+
+    /// File to export the metrics to.
+    static std::string file_;
+
+    /// Find or allocate the metrics of the given target.
+    static Target * findTarget(const std::string & name);
+
+    /// Add a duration to the given histogram.
+    static void observe(Histogram & histogram, const int64_t durationNs);
+
+    /// Write the given histogram in the Prometheus text format.
+    static void writeHistogram(std::ostream & metrics, const char * name,
+        const char * help, const Histogram & histogram);
+
+    /// Escape the given string for use as label value.
+    static std::string escape(const char * value);
+};
@@ -0,0 +1,135 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "Encoder.h"
+#include "PulseHistogram.h"
+#include "Task.h"
+
+/**
+ * @brief Class analyzing the pulse widths of an air scan dump.
+ *
+ * The dump is streamed in a single pass, either as samples (see Scan) or as
+ * Value Change Dump of edges (see ValueChangeDump), counting the widths of
+ * high and low pulses in a histogram each. The clusters of both histograms
+ * are fitted to the pulse widths of every built-in encoding, resulting in
+ * the data length and sync length of a target configuration. Memory usage
+ * does not depend on the size of the dump.
+ */
+class PulseAnalysis : public Task {
+public:
+    /// Class constructor.
+    PulseAnalysis(Configuration & configuration, const std::string & dumpFile);
+
+    /// Start the analysis.
+    int start(void) final;
+
+private:
+    /// Size of the buffer the dump file is read through.
+    static const size_t READ_BUFFER_SIZE = 65536U;
+
+    /**
+     * @brief Bin width of Value Change Dumps not stating a sampling rate.
+     * @note Unit: microseconds
+     */
+    static const int32_t DEFAULT_BIN_WIDTH_US = 10;
+
+    /// Minimum share of the pulses of a level for a cluster to be considered.
+    static constexpr double MIN_CLUSTER_SHARE = 0.01;
+
+    /// Maximum relative deviation of a cluster from an encoded pulse width.
+    static constexpr double MATCH_TOLERANCE = 0.2;
+
+    /// Result of fitting the clusters to an encoding.
+    struct Fit {
+        /**
+         * @brief Data length, 0 if none of the data pulse widths matches.
+         * @note Unit: microseconds
+         */
+        int32_t dataLengthUs;
+
+        /**
+         * @brief Sync length, 0 if none of the sync pulse widths matches.
+         * @note Unit: microseconds
+         */
+        int32_t syncLengthUs;
+
+        /// Number of pulse widths of the encoding matched by a cluster.
+        uint32_t matched;
+
+        /// Number of pulse widths of the encoding.
+        uint32_t widths;
+
+        /// Number of clusters not matching any pulse width of the encoding.
+        uint32_t unexplained;
+
+        /// Mean relative deviation of the matched clusters.
+        double deviation;
+    };
+
+    /// File name of the air scan dump.
+    const std::string dumpFile_;
+
+    /// Histogram of the high pulse widths.
+    std::unique_ptr<PulseHistogram> high_;
+
+    /// Histogram of the low pulse widths.
+    std::unique_ptr<PulseHistogram> low_;
+
+    /**
+     * @brief Duration of the dump.
+     * @note Unit: microseconds
+     */
+    uint64_t durationUs_;
+
+    /// Stream the samples of a dump into the histograms.
+    bool readSamples(std::istream & stream);
+
+    /// Stream the edges of a Value Change Dump into the histograms.
+    bool readEdges(std::istream & stream);
+
+    /// Create the histograms with the given bin width.
+    void createHistograms(const int32_t binWidthUs);
+
+    /// Get all pulse widths an encoding can produce on the air.
+    static std::vector<Encoder::Step> getWidths(
+        const Encoder::Encoding & encoding);
+
+    /// Fit the clusters to the pulse widths of an encoding.
+    static Fit fit(const std::vector<Encoder::Step> & widths,
+        const std::vector<PulseHistogram::Cluster> (& clusters)[2]);
+
+    /// Match the clusters to pulse widths of a single base length.
+    static uint32_t match(const std::vector<Encoder::Step> & widths,
+        const Encoder::Base base, double & lengthUs,
+        const std::vector<PulseHistogram::Cluster> (& clusters)[2],
+        std::vector<bool> (& isMatched)[2], double & deviation);
+
+    /// Print the clusters of a histogram.
+    static void printClusters(const char * level,
+        const std::vector<PulseHistogram::Cluster> & clusters,
+        const double shortestUs);
+};
@@ -0,0 +1,125 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Class counting pulse widths and clustering them into peaks.
+ *
+ * The histogram has a fixed number of bins of equal width, so its memory
+ * does not depend on the number of pulses added. Pulses exceeding the last
+ * bin are counted as overlong (usually the gaps between frames).
+ *
+ * Clusters are found by peak finding: neighbouring occupied bins form a
+ * cluster unless they are separated by more empty bins than the relative
+ * jitter allows, or by a valley deep enough to split two peaks.
+ */
+class PulseHistogram {
+public:
+    /// Number of bins.
+    static const uint32_t BINS = 8192U;
+
+    /// Peak of pulse widths.
+    struct Cluster {
+        /**
+         * @brief Mean pulse width.
+         * @note Unit: microseconds
+         */
+        double centerUs;
+
+        /**
+         * @brief Standard deviation of the pulse widths.
+         * @note Unit: microseconds
+         */
+        double spreadUs;
+
+        /// Number of pulses.
+        uint64_t pulses;
+    };
+
+    /// Class constructor.
+    PulseHistogram(const int32_t binWidthUs);
+
+    /// Add a single pulse.
+    void add(const uint64_t durationUs) {
+        const uint64_t bin = (durationUs + binWidthUs_ / 2U) / binWidthUs_;
+
+        if (bin < BINS) {
+            bins_[bin]++;
+        } else {
+            overlong_++;
+            longestUs_ = (durationUs > longestUs_) ? durationUs : longestUs_;
+        }
+        pulses_++;
+    }
+
+    /// Find the clusters of all pulses not exceeding the last bin.
+    std::vector<Cluster> cluster(void) const;
+
+    /// Get the width of a single bin.
+    int32_t getBinWidth(void) const;
+
+    /// Get the number of pulses added.
+    uint64_t getPulses(void) const;
+
+    /// Get the number of pulses exceeding the last bin.
+    uint64_t getOverlong(void) const;
+
+    /// Get the longest pulse exceeding the last bin.
+    uint64_t getLongest(void) const;
+
+private:
+    /**
+     * @brief Maximum gap of empty bins within a cluster relative to the pulse
+     *        width.
+     */
+    static constexpr double MAX_GAP_RATIO = 0.15;
+
+    /**
+     * @brief Maximum count of a valley splitting two peaks relative to the
+     *        lower peak.
+     */
+    static constexpr double VALLEY_RATIO = 0.25;
+
+    /**
+     * @brief Width of a single bin.
+     * @note Unit: microseconds
+     */
+    const uint64_t binWidthUs_;
+
+    /// Number of pulses per bin.
+    std::vector<uint64_t> bins_;
+
+    /// Number of pulses added.
+    uint64_t pulses_;
+
+    /// Number of pulses exceeding the last bin.
+    uint64_t overlong_;
+
+    /**
+     * @brief Longest pulse exceeding the last bin.
+     * @note Unit: microseconds
+     */
+    uint64_t longestUs_;
+
+    /// Compute the statistics of the given bin range.
+    Cluster summarize(const uint32_t first, const uint32_t last) const;
+};
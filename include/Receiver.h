@@ -0,0 +1,119 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Class capturing the signal of a radio receiver in a separate thread.
+ *
+ * The GPIO pin connected to the receiver is sampled on absolute deadlines,
+ * only level changes are stored. Capacity for all edges is allocated upfront,
+ * so capturing does not allocate memory. The captured signal can be read
+ * while capturing: edges are published before the captured time is advanced
+ * past them.
+ */
+class Receiver {
+public:
+    /**
+     * @brief Maximum delay of the received signal behind the transmission.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t MAX_LATENCY_NS = 1000000;
+
+    /// Class constructor.
+    Receiver(const uint8_t gpioPin, const int32_t samplingRateUs,
+        const size_t edgeCapacity);
+
+    /// Get the edge capacity sufficient for capturing the given duration.
+    static size_t getCapacity(const int64_t durationNs,
+        const int32_t samplingRateUs);
+
+    /// Class destructor, stops the capture.
+    ~Receiver(void);
+
+    /// Start capturing in a separate thread.
+    void start(void);
+
+    /// Stop capturing and wait for the thread to finish.
+    void stop(void);
+
+    /// Wait until the signal has been captured up to the given time.
+    bool waitUntilCaptured(const int64_t timeNs) const;
+
+    /// Get the received level at the given time.
+    bool getLevel(const int64_t timeNs) const;
+
+    /// Find the first edge to the given level within the given period.
+    int64_t findEdge(const bool level, const int64_t beginNs,
+        const int64_t endNs) const;
+
+private:
+    /// Captured change of the received level.
+    struct Edge {
+        /**
+         * @brief Monotonic time the level has been sampled at.
+         * @note Unit: nanoseconds
+         */
+        int64_t timeNs;
+
+        /// Received level, false=low / true=high.
+        bool level;
+    };
+
+    /// GPIO pin connected to the receiver.
+    const uint8_t gpioPin_;
+
+    /**
+     * @brief Delay between two samples.
+     * @note Unit: nanoseconds
+     */
+    const int64_t samplingRateNs_;
+
+    /**
+     * @brief Captured edges, the first element is the initial level.
+     * @note Allocated upfront, only written by the capturing thread.
+     */
+    std::vector<Edge> edges_;
+
+    /// Number of valid edges, published by the capturing thread.
+    std::atomic<size_t> edgeCount_;
+
+    /// Monotonic time the signal has been captured up to (unit: ns).
+    std::atomic<int64_t> capturedNs_;
+
+    /// Flag to determine whether the thread shall keep capturing.
+    std::atomic<bool> isRunning_;
+
+    /// Flag to determine whether the thread is still capturing.
+    std::atomic<bool> isCapturing_;
+
+    /// Capturing thread.
+    std::thread thread_;
+
+    /// Capture the receiver GPIO pin until stopped or out of capacity.
+    void run(void);
+
+    /// Get the index of the last edge at or before the given time.
+    size_t findIndex(const int64_t timeNs, const size_t count) const;
+};
@@ -0,0 +1,211 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "EdgeQueue.h"
+#include "Task.h"
+#include "Transmitter.h"
+
+/**
+ * @brief Class repeating the signal of the air scan receiver live.
+ *
+ * A capture thread samples the GPIO pin of the 'scan' section and hands every
+ * edge over to the transmitting thread through a lock-free queue. The
+ * transmitting thread writes every edge to the GPIO pin of the 'replay'
+ * section a fixed latency after it has been captured. Edges captured within a
+ * sampling period after an edge of the same level has been written are
+ * ignored as its echo, see EchoFilter.
+ *
+ * The airtime of the repeated signal is taken from the duty cycle budget of
+ * the GPIO pin in chunks while repeating. Once the budget is exhausted, edges
+ * or frames are dropped and a high level is cut, holding the pin low until
+ * the budget has been refilled by another chunk.
+ *
+ * Optionally only frames matching the pulse train of a configured target are
+ * repeated. Frames are then held back until they are complete, so the latency
+ * must exceed the longest frame. Signals received while repeating a frame are
+ * ignored, as they are most likely the echo of the repeated frame.
+ */
+class Repeater : public Task {
+public:
+    /// Class constructor.
+    Repeater(Configuration & configuration, const int32_t durationMs,
+        const int32_t latencyUs, const bool isFiltered);
+
+    /// Start repeating.
+    int start(void) final;
+
+private:
+    /// Number of edges the queue holds.
+    static const size_t QUEUE_CAPACITY = 4096U;
+
+    /**
+     * @brief Latency unless given, added to the longest frame if filtering.
+     * @note Unit: microseconds
+     */
+    static const int32_t DEFAULT_LATENCY_US = 1000;
+
+    /**
+     * @brief Airtime taken from the duty cycle budget at once.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t AIRTIME_CHUNK_NS = 100000000;
+
+    /**
+     * @brief Delay before taking airtime again once the budget is exhausted.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t AIRTIME_RETRY_NS = 100000000;
+
+    /// Pulse lengths of a target frame, alternating high and low.
+    struct Shape {
+        /// Target name.
+        std::string name;
+
+        /// Pulse lengths starting and ending with high (unit: nanoseconds).
+        std::vector<int64_t> pulsesNs;
+
+        /// Sum of all pulse lengths (unit: nanoseconds).
+        int64_t durationNs;
+    };
+
+    /// Statistics of the repeated signal.
+    struct Statistics {
+        /// Number of repeated edges.
+        uint32_t edges;
+
+        /// Number of repeated frames (if filtering).
+        uint32_t frames;
+
+        /// Number of frames not matching any target (if filtering).
+        uint32_t rejectedFrames;
+
+        /// Number of frames completed after their deadline (if filtering).
+        uint32_t lateFrames;
+
+        /// Number of edges ignored as echo of a repeated frame.
+        uint32_t echoEdges;
+
+        /// Number of missed deadlines.
+        uint32_t missedDeadlines;
+
+        /// Number of edges dropped for an exhausted duty cycle budget.
+        uint32_t droppedEdges;
+
+        /// Number of frames dropped for an exhausted duty cycle budget.
+        uint32_t droppedFrames;
+
+        /// Minimum latency from capturing to writing an edge (unit: ns).
+        int64_t minLatencyNs;
+
+        /// Maximum latency from capturing to writing an edge (unit: ns).
+        int64_t maxLatencyNs;
+
+        /// Sum of the latencies of all edges (unit: nanoseconds).
+        int64_t sumLatencyNs;
+
+        /// Duration of all completed high levels (unit: nanoseconds).
+        int64_t airtimeNs;
+
+        /// Time the current high level has been written at, 0 if low (ns).
+        int64_t risingNs;
+
+        /// Airtime taken from the duty cycle budget (unit: nanoseconds).
+        int64_t grantedNs;
+
+        /// Time to take airtime again at after the budget was exhausted (ns).
+        int64_t retryNs;
+
+        /// Flag to determine whether taking airtime has failed.
+        bool isFailed;
+    };
+
+    /**
+     * @brief Repeating duration.
+     * @note Unit: milliseconds
+     */
+    const int32_t durationMs_;
+
+    /**
+     * @brief Latency from capturing to writing an edge, <=0 for the default.
+     * @note Unit: microseconds
+     */
+    int32_t latencyUs_;
+
+    /// Flag to determine whether only frames of targets are repeated.
+    const bool isFiltered_;
+
+    /// GPIO pin connected to the receiver.
+    uint8_t receiverGpioPin_;
+
+    /**
+     * @brief Delay between two samples of the receiver.
+     * @note Unit: nanoseconds
+     */
+    int64_t samplingRateNs_;
+
+    /// Frame shapes of all valid targets (if filtering).
+    std::vector<Shape> shapes_;
+
+    /**
+     * @brief Shortest low level separating two frames (if filtering).
+     * @note Unit: nanoseconds
+     */
+    int64_t frameGapNs_;
+
+    /// Load the frame shapes of all valid targets.
+    bool loadShapes(void);
+
+    /// Capture the receiver GPIO pin until stopped.
+    void capture(EdgeQueue & queue, const std::atomic<bool> & isRunning,
+        std::atomic<uint32_t> & overruns) const;
+
+    /// Repeat all captured edges until the given time.
+    Statistics repeat(Transmitter & transmitter, EdgeQueue & queue,
+        const int64_t endNs) const;
+
+    /// Repeat only captured frames matching a target until the given time.
+    Statistics repeatFrames(Transmitter & transmitter, EdgeQueue & queue,
+        const int64_t endNs) const;
+
+    /// Transmit a single edge a fixed latency after it has been captured.
+    int64_t transmit(Transmitter & transmitter, const EdgeQueue::Edge & edge,
+        Statistics & statistics) const;
+
+    /// Get the airtime of the repeated signal so far.
+    int64_t getAirtime(const Statistics & statistics) const;
+
+    /// Check whether the airtime left covers the given one, taking more.
+    bool grantAirtime(const int64_t airtimeNs, Statistics & statistics)
+        const;
+
+    /// Check whether a pulse length matches the expected one.
+    bool isMatching(const int64_t pulseNs, const int64_t expectedNs) const;
+
+    /// Print the statistics of the repeated signal.
+    void report(const Statistics & statistics, const uint32_t overruns)
+        const;
+};
@@ -36,6 +36,15 @@ public:
     /// Start replaying the air dump scan.
     int start(void) final;
 
+    /// Load the air scan dump data without replaying it.
+    bool load(void);
+
+    /// Get the loaded air scan dump data.
+    const std::vector<bool> & getData(void) const;
+
+    /// Get the sampling rate of the loaded air scan dump.
+    int32_t getSamplingRate(void) const;
+
 private:
     /// File name of the air scan dump.
     const std::string dumpFile_;
@@ -58,6 +67,9 @@ private:
     /// Perform the air scan replay based on the values stored in 'data_'.
     void airReplay(void) const;
 
-    /// Deserialize the air scan dump data from the dump file.
-    bool deserializeData(void);
+    /// Load the air scan dump data from a frame archive.
+    bool loadFrame(const std::string & location, const std::string & name);
+
+    /// Load a part of the air scan dump data selected by the capture index.
+    bool loadSegment(const std::string & file, const std::string & selection);
 };
@@ -38,6 +38,19 @@ public:
     /// Get the GPIO pin.
     uint8_t getGpioPin(void) const;
 
+    /**
+     * @brief Get the maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t getDutyCycle(void) const;
+
+    /**
+     * @brief Get the window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t getDutyCycleWindow(void) const;
+
 private:
     /// Configuration data.
     const Configuration & configuration_;
@@ -45,6 +58,22 @@ private:
     /// GPIO pin.
     uint8_t gpioPin_;
 
+    /**
+     * @brief Maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t dutyCyclePpm_;
+
+    /**
+     * @brief Window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t dutyCycleWindowS_;
+
     /// Load the GPIO pin from the configuration.
     bool loadGpioPin(void);
+
+    /// Load the optional duty cycle from the configuration.
+    bool loadDutyCycle(void);
 };
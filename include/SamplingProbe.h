@@ -0,0 +1,81 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "Configuration.h"
+#include "Task.h"
+
+/**
+ * @brief Class measuring the shortest sampling rate air scans can sustain.
+ *
+ * The air scan sample loop is run on the GPIO pin of the 'scan' section at
+ * several sampling rates, measuring how late every sample is taken. The
+ * shortest sampling rate whose samples are taken within half a sampling
+ * period, apart from rare outliers, is recommended and stored in the timing
+ * profile (see TimingProfile), where `samplingRate = "auto"` picks it up.
+ * The GPIO pin is only read.
+ */
+class SamplingProbe : public Task {
+public:
+    /// Class constructor.
+    SamplingProbe(Configuration & configuration);
+
+    /// Start the probe.
+    int start(void) final;
+
+private:
+    /// Sampling rates probed, in ascending order (unit: microseconds).
+    static const int32_t SAMPLING_RATES_US[];
+
+    /**
+     * @brief Duration of probing a single sampling rate.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t PROBE_DURATION_NS = 200000000;
+
+    /// Result of probing a single sampling rate.
+    struct Result {
+        /// Median lateness of the samples (unit: nanoseconds).
+        int64_t medianNs;
+
+        /// 99th percentile of the lateness of the samples (unit: nanoseconds).
+        int64_t p99Ns;
+
+        /// Maximum lateness of the samples (unit: nanoseconds).
+        int64_t maxNs;
+
+        /// Number of samples taken a sampling period or more too late.
+        uint32_t slipped;
+
+        /// Number of samples taken.
+        uint32_t samples;
+    };
+
+    /// Measure the average duration of reading the GPIO pin.
+    int64_t measureRead(void) const;
+
+    /// Run the air scan sample loop at the given sampling rate.
+    Result measure(const int32_t samplingRateUs) const;
+
+    /// Check whether the result leaves enough headroom.
+    static bool isSustainable(const Result & result,
+        const int32_t samplingRateUs);
+};
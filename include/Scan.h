@@ -32,21 +32,44 @@ class Scan : public Task {
 public:
     /// Class constructor.
     Scan(Configuration & configuration, const int32_t durationMs,
-        const std::string & dumpFile);
+        const std::string & dumpFile, const int32_t scaleUs,
+        const bool isSummary);
 
     /// Start the air scan.
     int start(void) final;
 
+    /// Set the air scan results instead of scanning.
+    bool setData(const std::vector<bool> & data);
+
+    /// Write the air scan results to stdout or the dump file.
+    void writeData(void) const;
+
 private:
+    /// Size of the output buffer of exported air scans.
+    static const size_t EXPORT_BUFFER_SIZE = 65536U;
+
     /**
      * @brief Air scan duration.
      * @note Unit: milliseconds
      */
     const int32_t durationMs_;
 
-    /// Dump file name or empty string to print scan results on stdout.
+    /**
+     * @brief Dump file name or empty string to print scan results on stdout.
+     *        File names ending with '.vcd' are exported as Value Change Dump.
+     */
     const std::string dumpFile_;
 
+    /**
+     * @brief Duration of a single bar character of the ASCII graph, <=0 to
+     *        fit the longest run.
+     * @note Unit: microseconds
+     */
+    const int32_t scaleUs_;
+
+    /// Print a horizontal summary instead of one row per run.
+    const bool isSummary_;
+
     /// Scan parameters.
     std::unique_ptr<ScanParameters> parameters_;
 
@@ -64,4 +87,7 @@ private:
 
     /// Serialize the air scan results to the dump file.
     void serializeData(void) const;
+
+    /// Export the air scan results to the dump file as Value Change Dump.
+    void exportData(void) const;
 };
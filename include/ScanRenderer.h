@@ -0,0 +1,80 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Class rendering air scan samples as ASCII graph.
+ *
+ * Runs of equal samples are collapsed into a single row annotated with their
+ * duration and a bar quantized to a scale, so the graph stays readable for
+ * scans of any duration. Alternatively a summary of the whole scan is
+ * rendered horizontally into a single line of the terminal width. The graph
+ * is rendered into a string which is written at once.
+ */
+class ScanRenderer {
+public:
+    /// Class constructor.
+    ScanRenderer(const std::vector<bool> & samples,
+        const int32_t samplingRateUs);
+
+    /// Render one row per run of equal samples.
+    std::string renderRuns(const int32_t scaleUs) const;
+
+    /// Render a horizontal summary of the whole scan.
+    std::string renderSummary(const size_t columns) const;
+
+    /// Get the width of the terminal connected to stdout.
+    static size_t getTerminalWidth(void);
+
+private:
+    /// Maximum number of characters of a bar.
+    static const size_t MAX_BAR_LENGTH = 60U;
+
+    /// Terminal width used if it cannot be determined.
+    static const size_t DEFAULT_TERMINAL_WIDTH = 80U;
+
+    /// Run of equal samples.
+    struct Run {
+        /// Signal level of the run.
+        bool level;
+
+        /// Number of samples of the run.
+        size_t samples;
+    };
+
+    /// Samples of the air scan, false=low / true=high.
+    const std::vector<bool> & samples_;
+
+    /**
+     * @brief Time between two samples.
+     * @note Unit: microseconds
+     */
+    const int32_t samplingRateUs_;
+
+    /// Collapse the samples into runs.
+    std::vector<Run> getRuns(void) const;
+
+    /// Format the given duration with a suitable unit.
+    static std::string formatDuration(const int64_t durationUs);
+};
@@ -19,7 +19,8 @@
 
 #pragma once
 
-#include <memory>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "Configuration.h"
@@ -39,21 +40,44 @@ private:
     /// Target section name.
     const std::string name_;
 
-    /// Target parameters.
-    std::unique_ptr<TargetParameters> parameters_;
+    /// Pulse train of a single air command transmission.
+    const Types::Pulse * pulses_;
 
-    /// Control the target.
-    void airControl(void) const;
+    /// Number of pulses of the pulse train.
+    size_t pulseCount_;
 
-    /// Send the air command with Manchester encoding.
-    void sendAirCommandManchester(void) const;
+    /// Number of times the air command will be transmitted.
+    int32_t sendCommand_;
 
-    /// Send the air command with RCO encoding.
-    void sendAirCommandRemoteControlledOutled(void) const;
+    /**
+     * @brief Delay between repeated air command transmissions.
+     * @note Unit: microseconds
+     */
+    int32_t sendDelayUs_;
 
-    /// Send the air command with Tormatic encoding.
-    void sendAirCommandTormatic(void) const;
+    /**
+     * @brief Maximum edge error of a frame before it is retransmitted.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if frames are not
+     *       checked.
+     */
+    int32_t frameToleranceUs_;
 
-    /// Send the air command with Melitec encoding.
-    void sendAirCommandMelitec(void) const;
+    /// Maximum number of retransmitted frames.
+    int32_t maxRetransmissions_;
+
+    /**
+     * @brief Time the channel must be idle before every frame.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if the channel is
+     *       not sensed.
+     */
+    int32_t listenBeforeTalkUs_;
+
+    /// GPIO pin of the receiver sensing the channel.
+    uint8_t senseGpioPin_;
+
+    /// Load the target from the embedded targets or the configuration.
+    bool load(uint8_t & gpioPin);
+
+    /// Control the target by transmitting its pulse train.
+    uint32_t airControl(void) const;
 };
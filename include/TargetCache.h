@@ -0,0 +1,160 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Configuration.h"
+#include "TargetParameters.h"
+
+/**
+ * @brief Class caching the resolved targets of a configuration file.
+ *
+ * The cache file is stored next to the configuration file and holds the
+ * resolved parameters and pulse trains of all targets. It is memory-mapped and
+ * contains a hash table of all target names, i.e. restoring a target neither
+ * requires parsing the configuration file nor reading the whole cache file.
+ * The cache file is only used while the modification time, size and content
+ * hash of the configuration file match the ones stored in the cache file.
+ *
+ * Format of the cache file (native byte order):
+ * - [Header] Signature, version and configuration file fingerprint
+ * - [n * 4 bytes] Hash table buckets, index of the record + 1 or 0 if empty
+ * - [n * Record] Target records
+ * - [n bytes] Strings and pulse trains referenced by the records
+ */
+class TargetCache {
+public:
+    /// Class constructor.
+    TargetCache(const Configuration & configuration);
+
+    /// Class destructor.
+    ~TargetCache(void);
+
+    /// Map the cache file if it matches the configuration file.
+    bool open(void);
+
+    /// Check whether the cache file has been mapped.
+    bool isOpen(void) const;
+
+    /// Restore the parameters of the given target from the cache file.
+    bool find(const std::string & name, TargetParameters & parameters,
+        std::string & error) const;
+
+    /// Get the names of all cached targets.
+    std::vector<std::string> getNames(void) const;
+
+    /// Write the cache file for the given targets.
+    void write(
+        const std::unordered_map<std::string, TargetParameters> & targets,
+        const std::unordered_map<std::string, std::string> & errors) const;
+
+    /// Calculate the FNV-1a hash of the given data.
+    static uint64_t hash(const void * data, const size_t length,
+        uint64_t seed = 0xCBF29CE484222325U);
+
+private:
+    /// File name suffix appended to the configuration file location.
+    static const std::string SUFFIX;
+
+    /// Signature to be used to identify cache files.
+    static const uint32_t SIGNATURE = 0xA1C0CAC4U;
+
+    /// Version of the cache file format.
+    static const uint32_t VERSION = 6U;
+
+    /// Cache file header.
+    struct Header {
+        /// Signature of the cache file.
+        uint32_t signature;
+
+        /// Version of the cache file format.
+        uint32_t version;
+
+        /// Modification time of the configuration file (seconds).
+        int64_t modificationTimeS;
+
+        /// Modification time of the configuration file (nanoseconds).
+        int64_t modificationTimeNs;
+
+        /// Size of the configuration file.
+        uint64_t size;
+
+        /// Content hash of the configuration file.
+        uint64_t hash;
+
+        /// Number of records.
+        uint32_t recordCount;
+
+        /// Number of hash table buckets, always a power of two.
+        uint32_t bucketCount;
+    };
+
+    /// Cache file record describing a single target.
+    struct Record {
+        /// Hash of the target name.
+        uint64_t nameHash;
+
+        /// File offset and length of the target name.
+        uint32_t nameOffset, nameLength;
+
+        /// File offset and length of the error message of invalid targets.
+        uint32_t errorOffset, errorLength;
+
+        /// File offset and length of the encoding name.
+        uint32_t encodingOffset, encodingLength;
+
+        /// File offset and length of the air command.
+        uint32_t airCommandOffset, airCommandLength;
+
+        /// File offset and number of pulses of the pulse train.
+        uint32_t pulsesOffset, pulseCount;
+
+        /// Target parameters, see TargetParameters.
+        int32_t gpioPin, airCode, dataLengthUs, syncLengthUs, sendCommand,
+            sendDelayUs, frameToleranceUs, maxRetransmissions,
+            listenBeforeTalkUs, dutyCyclePpm, dutyCycleWindowS;
+    };
+
+    /// Reference of the related configuration instance.
+    const Configuration & configuration_;
+
+    /// Fingerprint of the configuration file.
+    Header fingerprint_;
+
+    /// Memory-mapped cache file or nullptr.
+    const uint8_t * data_;
+
+    /// Size of the memory-mapped cache file.
+    size_t size_;
+
+    /// Get the cache file location.
+    std::string getLocation(void) const;
+
+    /// Determine the fingerprint of the configuration file.
+    bool loadFingerprint(void);
+
+    /// Check whether the given file range lies within the cache file.
+    bool isValidRange(const uint64_t offset, const uint64_t length) const;
+};
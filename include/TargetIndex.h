@@ -0,0 +1,89 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Configuration.h"
+#include "EncodingIndex.h"
+#include "TargetCache.h"
+#include "TargetParameters.h"
+
+/**
+ * @brief Class holding the resolved parameters of all configured targets.
+ *
+ * The configuration is walked once: every target section is merged with the
+ * "target" defaults section and validated. Afterwards targets can be looked up
+ * by name in constant time without touching the configuration again.
+ *
+ * The resolved targets are stored in the target cache. As long as the cache is
+ * up to date targets are restored from the cache upon lookup instead, without
+ * parsing the configuration file at all.
+ */
+class TargetIndex {
+public:
+    /// Class constructor.
+    TargetIndex(const Configuration & configuration);
+
+    /// Resolve and validate all target sections of the configuration.
+    void build(const bool useCache = true);
+
+    /// Get the names of all targets, including invalid ones.
+    std::vector<std::string> getNames(void) const;
+
+    /**
+     * @brief Find the resolved parameters of the given target.
+     * @note Prints an error message if the target is unknown or invalid.
+     */
+    const TargetParameters * find(const std::string & name) const;
+
+private:
+    /// Names of the sections not describing targets.
+    static const char * const RESERVED_SECTIONS[];
+
+    /// Reference of the related configuration instance.
+    const Configuration & configuration_;
+
+    /// Cache of the resolved targets.
+    TargetCache cache_;
+
+    /// Encodings available to the targets.
+    EncodingIndex encodings_;
+
+    /**
+     * @brief Resolved parameters of all valid targets, indexed by target name.
+     * @note Only contains the targets already restored when using the cache.
+     */
+    mutable std::unordered_map<std::string, TargetParameters> targets_;
+
+    /**
+     * @brief Error messages of all invalid targets, indexed by target name.
+     * @note Only contains the targets already restored when using the cache.
+     */
+    mutable std::unordered_map<std::string, std::string> errors_;
+
+    /// Restore the given target from the cache.
+    void restore(const std::string & name) const;
+
+    /// Check whether the given section name is reserved.
+    static bool isReservedSection(const char * name);
+};
@@ -19,9 +19,12 @@
 
 #pragma once
 
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include "Configuration.h"
+#include "EncodingIndex.h"
 #include "Types.h"
 
 /// Class holding all parameters required for Target tasks.
@@ -37,6 +40,18 @@ public:
      */
     bool load(void);
 
+    /**
+     * @brief Load all required configuration parameters from already resolved
+     *        configuration sections.
+     * @note Must be called before any of the getters.
+     */
+    bool load(const libconfig::Setting * section,
+        const libconfig::Setting * defaults, const EncodingIndex & encodings,
+        std::ostream & errors);
+
+    /// Get the target name.
+    const std::string & getName(void) const;
+
     /// Get the GPIO pin.
     uint8_t getGpioPin(void) const;
 
@@ -52,11 +67,17 @@ public:
      */
     int32_t getSyncLength(void) const;
 
-    /// Get the radio frame encoding type.
+    /**
+     * @brief Get the radio frame encoding type.
+     * @note Types::AirCode::MAX for user-defined encodings.
+     */
     Types::AirCode::AirCode_ getAirCode(void) const;
 
+    /// Get the name of the radio frame encoding.
+    const std::string & getEncoding(void) const;
+
     /// Get the sequence string of data and sync elements to be transmitted.
-    std::string getAirCommand(void) const;
+    const std::string & getAirCommand(void) const;
 
     /// Get the number of times the air command will be transmitted.
     int32_t getSendCommand(void) const;
@@ -67,13 +88,67 @@ public:
      */
     int32_t getSendDelay(void) const;
 
+    /**
+     * @brief Get the maximum edge error of a frame before it is retransmitted.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if frames are not
+     *       checked.
+     */
+    int32_t getFrameTolerance(void) const;
+
+    /// Get the maximum number of retransmitted frames.
+    int32_t getMaxRetransmissions(void) const;
+
+    /**
+     * @brief Get the time the channel must be idle before every frame.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if the channel is
+     *       not sensed.
+     */
+    int32_t getListenBeforeTalk(void) const;
+
+    /**
+     * @brief Get the maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t getDutyCycle(void) const;
+
+    /**
+     * @brief Get the window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t getDutyCycleWindow(void) const;
+
+    /// Get the pulse train of a single air command transmission.
+    const std::vector<Types::Pulse> & getPulses(void) const;
+
 private:
+    /// The target cache restores parameters without loading them.
+    friend class TargetCache;
+
+    /// Maximum number of retransmitted frames unless configured.
+    static const int32_t DEFAULT_MAX_RETRANSMISSIONS = 3;
+
     /// Reference of the related configuration instance.
     const Configuration & configuration_;
 
     /// Reference of the target name.
     const std::string name_;
 
+    /// Target section while loading.
+    const libconfig::Setting * section_;
+
+    /// Target defaults section while loading.
+    const libconfig::Setting * defaults_;
+
+    /// Encodings available while loading.
+    const EncodingIndex * encodings_;
+
+    /// Radio frame encoding while loading.
+    const Encoder::Encoding * encoding_;
+
+    /// Stream receiving error messages while loading.
+    std::ostream * errors_;
+
     /// GPIO pin.
     uint8_t gpioPin_;
 
@@ -89,9 +164,12 @@ private:
      */
     int32_t syncLengthUs_;
 
-    /// Radio frame encoding type.
+    /// Radio frame encoding type, MAX for user-defined encodings.
     Types::AirCode::AirCode_ airCode_;
 
+    /// Name of the radio frame encoding.
+    std::string encodingName_;
+
     /// Sequence string of data and sync elements to be transmitted.
     std::string airCommand_;
 
@@ -105,24 +183,62 @@ private:
     int32_t sendDelayUs_;
 
     /**
-     * @brief Get the requested configuration value from either the given
+     * @brief Maximum edge error of a frame before it is retransmitted.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if frames are not
+     *       checked.
+     */
+    int32_t frameToleranceUs_;
+
+    /// Maximum number of retransmitted frames.
+    int32_t maxRetransmissions_;
+
+    /**
+     * @brief Time the channel must be idle before every frame.
+     * @note Unit: microseconds, Types::INVALID_PARAMETER if the channel is
+     *       not sensed.
+     */
+    int32_t listenBeforeTalkUs_;
+
+    /**
+     * @brief Maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t dutyCyclePpm_;
+
+    /**
+     * @brief Window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t dutyCycleWindowS_;
+
+    /// Pulse train of a single air command transmission.
+    std::vector<Types::Pulse> pulses_;
+
+    /**
+     * @brief Get the requested configuration value from either the target
      *        section or the "target" section.
-     * @copydoc Configuration::getValue()
+     * @tparam T Type of the value.
+     * @param name Configuration name.
+     * @param value Place to store the configuration value to.
+     * @return True if the value has been loaded, false otherwise.
      */
     template <typename T>
-    bool getValue(const std::string section, const std::string name,
-            T & value) const {
-        if (!configuration_.getValue(section, name, value)) {
-            if (!configuration_.getValue("target", name, value)) {
-                std::cerr << "Error: Missing configuration parameter '" << name
-                    << "'" << std::endl;
-                return false;
-            }
+    bool getValue(const char * name, T & value) const {
+        if (((section_ == nullptr) || !section_->lookupValue(name, value))
+                && ((defaults_ == nullptr)
+                    || !defaults_->lookupValue(name, value))) {
+            *errors_ << "Error: Missing configuration parameter '" << name
+                << "'" << std::endl;
+            return false;
         }
 
         return true;
     }
 
+    /// Get the requested setting from either the target or "target" section.
+    const libconfig::Setting * getSetting(const char * name) const;
+
     /// Load the GPIO pin from the configuration.
     bool loadGpioPin(void);
 
@@ -143,4 +259,19 @@ private:
 
     /// Load the send delay parameter from the configuration.
     bool loadSendDelay(void);
+
+    /// Load the optional frame tolerance parameter from the configuration.
+    bool loadFrameTolerance(void);
+
+    /// Load the optional retransmission limit from the configuration.
+    bool loadMaxRetransmissions(void);
+
+    /// Load the optional listen before talk parameter from the configuration.
+    bool loadListenBeforeTalk(void);
+
+    /// Load the optional duty cycle parameters from the configuration.
+    bool loadDutyCycle(void);
+
+    /// Encode the air command into its pulse train.
+    void encodeAirCommand(void);
 };
@@ -36,6 +36,9 @@ public:
     /// Set the GPIO pin.
     void setGpioPin(const uint8_t gpioPin);
 
+    /// Set whether the GPIO pin shall be locked against other instances.
+    void setInstanceLock(const bool instanceLock);
+
     /// Start the task.
     virtual int start(void) = 0;
 
@@ -45,4 +48,32 @@ protected:
 
     /// Reference of the configuration.
     Configuration & configuration_;
+
+    /// Flag to determine whether the GPIO pin shall be locked.
+    bool instanceLock_ = false;
+
+    /**
+     * @brief Maximum share of airtime on the GPIO pin.
+     * @note Unit: parts per million, Types::INVALID_PARAMETER if the airtime
+     *       is not limited.
+     */
+    int32_t dutyCyclePpm_ = Types::INVALID_PARAMETER;
+
+    /**
+     * @brief Window the duty cycle is averaged over.
+     * @note Unit: seconds
+     */
+    int32_t dutyCycleWindowS_ = 0;
+
+    /// Lock the GPIO pin if requested, blocking while other instances use it.
+    bool lockGpioPin(void) const;
+
+    /// Wait until the duty cycle budget of the GPIO pin covers the airtime.
+    bool reserveAirtime(const int64_t airtimeNs) const;
+
+    /// Take airtime from the duty cycle budget without waiting.
+    bool takeAirtime(const int64_t airtimeNs, int64_t & takenNs) const;
+
+    /// Account the deviation of the actual from the reserved airtime.
+    bool adjustAirtime(const int64_t deltaNs) const;
 };
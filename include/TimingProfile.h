@@ -0,0 +1,93 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Class holding the timing characteristics of the host.
+ *
+ * The profile is measured by Calibration and stored in a file. Transmissions
+ * use it to pre-compensate their timing: they wake up earlier by the sleep
+ * overshoot, spin until a clock read before the GPIO pin has to be written
+ * and start writing earlier by the GPIO write duration. Without a profile
+ * file, or with a profile of a different board revision, no compensation is
+ * applied.
+ *
+ * The profile also holds the shortest sampling rate sustainable by air
+ * scans, which is measured by SamplingProbe.
+ */
+class TimingProfile {
+public:
+    /// Profile file location.
+    static const std::string LOCATION;
+
+    /// Class constructor.
+    TimingProfile(const int32_t sleepOvershootNs, const int32_t gpioWriteNs,
+        const int32_t clockReadNs, const int32_t samplingRateUs);
+
+    /// Get the profile of this host, loaded upon first use.
+    static const TimingProfile & get(void);
+
+    /// Save the profile to the profile file.
+    bool save(void) const;
+
+    /**
+     * @brief Get the time a sleep ends after its deadline.
+     * @note Unit: nanoseconds
+     */
+    int32_t getSleepOvershoot(void) const;
+
+    /**
+     * @brief Get the duration of writing a GPIO pin.
+     * @note Unit: nanoseconds
+     */
+    int32_t getGpioWrite(void) const;
+
+    /**
+     * @brief Get the duration of reading the clock, i.e. of a spin loop
+     *        iteration.
+     * @note Unit: nanoseconds
+     */
+    int32_t getClockRead(void) const;
+
+    /**
+     * @brief Get the shortest sampling rate sustainable by air scans.
+     * @note Unit: microseconds, 0 if it has not been measured.
+     */
+    int32_t getSamplingRate(void) const;
+
+private:
+    /// Sleep overshoot (unit: nanoseconds).
+    int32_t sleepOvershootNs_;
+
+    /// GPIO write duration (unit: nanoseconds).
+    int32_t gpioWriteNs_;
+
+    /// Clock read duration (unit: nanoseconds).
+    int32_t clockReadNs_;
+
+    /// Sustainable sampling rate (unit: microseconds), 0 if unknown.
+    int32_t samplingRateUs_;
+
+    /// Load the profile from the profile file.
+    bool load(void);
+};
@@ -0,0 +1,75 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Class measuring the duration of the startup phases.
+ *
+ * The startup code marks the end of every phase. Marks are stored in a fixed
+ * size table without allocating memory and are only reported at program exit
+ * if timing has been enabled, so measuring does not disturb the timing of
+ * transmissions.
+ */
+class Timings {
+public:
+    /**
+     * @brief Enable timing.
+     * @param file File to append the report to, stderr if empty.
+     */
+    static void enable(const std::string & file);
+
+    /// Mark the end of the given phase.
+    static void mark(const char * phase);
+
+    /// Report the duration of all marked phases.
+    static void report(void);
+
+private:
+    /// Maximum number of marks.
+    static const size_t MAX_MARKS = 16U;
+
+    /// Flag to determine whether timing is enabled.
+    static bool isEnabled_;
+
+    /// File to append the report to, stderr if empty.
+    static std::string file_;
+
+    /// Names of the marked phases.
+    static const char * phases_[MAX_MARKS];
+
+    /**
+     * @brief Monotonic times at the end of the marked phases.
+     * @note Unit: nanoseconds
+     */
+    static int64_t timesNs_[MAX_MARKS];
+
+    /// Number of marks.
+    static size_t count_;
+
+    /**
+     * @brief Get the monotonic time the process has been started at.
+     * @note Unit: nanoseconds, resolution of the kernel clock tick.
+     */
+    static int64_t getStartTime(void);
+};
@@ -0,0 +1,100 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Class recording a timeline of transmissions, replays and scans.
+ *
+ * Events are recorded into a buffer allocated upfront when tracing is enabled.
+ * Recording neither allocates memory nor performs any I/O, events exceeding the
+ * buffer are dropped. The timeline is written at program exit in the Chrome
+ * trace event format, which can be viewed with chrome://tracing or the
+ * Perfetto UI.
+ */
+class Trace {
+public:
+    /// Enable tracing and write the timeline to the given file at exit.
+    static void enable(const std::string & file);
+
+    /// Check whether tracing is enabled.
+    static bool isEnabled(void) {
+        return isEnabled_;
+    }
+
+    /// Record a span.
+    static void span(const char * name, const int64_t beginNs,
+        const int64_t endNs, const char * argument = nullptr,
+        const int64_t value = 0);
+
+    /// Record a counter value.
+    static void counter(const char * name, const int64_t timeNs,
+        const int64_t value);
+
+    /// Write the recorded timeline to the file given upon enabling.
+    static bool write(void);
+
+private:
+    /// Maximum number of recorded events.
+    static const size_t MAX_EVENTS = 262144U;
+
+    /// Single recorded event.
+    struct Event {
+        /// Event name, string literal.
+        const char * name;
+
+        /// Argument name, string literal or nullptr.
+        const char * argument;
+
+        /**
+         * @brief Begin of the event.
+         * @note Unit: nanoseconds
+         */
+        int64_t timeNs;
+
+        /**
+         * @brief Duration of spans, -1 for counters.
+         * @note Unit: nanoseconds
+         */
+        int64_t durationNs;
+
+        /// Argument value or counter value.
+        int64_t value;
+    };
+
+    /// Flag to determine whether tracing is enabled.
+    static bool isEnabled_;
+
+    /// File to write the timeline to.
+    static std::string file_;
+
+    /// Recorded events, capacity is reserved upon enabling.
+    static std::vector<Event> events_;
+
+    /// Number of events dropped due to a full buffer.
+    static uint64_t droppedEvents_;
+
+    /// Record the given event.
+    static void record(const Event & event);
+};
@@ -0,0 +1,183 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TimingProfile.h"
+#include "Types.h"
+
+/**
+ * @brief Class transmitting pulse trains on a GPIO pin.
+ *
+ * Every edge is scheduled on an absolute deadline of the monotonic clock,
+ * compensated by the timing profile of the host. The GPIO access is virtual,
+ * allowing derived classes to capture the edges instead of driving the pin.
+ */
+class Transmitter {
+public:
+    /**
+     * @brief Minimum length of a high level indicating a busy channel, also
+     *        the minimum time the channel is sensed before a frame.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t MIN_CARRIER_NS = 150000;
+
+    /// Class constructor.
+    Transmitter(const uint8_t gpioPin);
+
+    /// Statistics of a pulse train transmission.
+    struct Statistics {
+        /// Number of transmitted frames, including retransmissions.
+        uint32_t frames;
+
+        /// Number of frames exceeding the frame tolerance.
+        uint32_t badFrames;
+
+        /// Number of frames transmitted again after a bad frame.
+        uint32_t retransmissions;
+
+        /// Number of missed deadlines.
+        uint32_t missedDeadlines;
+
+        /**
+         * @brief Largest edge error of all frames.
+         * @note Unit: nanoseconds
+         */
+        int64_t maxEdgeErrorNs;
+
+        /// Number of times a frame has been postponed for a busy channel.
+        uint32_t backoffs;
+
+        /// Number of frames sent into a busy channel after all backoffs.
+        uint32_t busyFrames;
+    };
+
+    /// Class destructor.
+    virtual ~Transmitter(void);
+
+    /// Get the airtime of a single pulse train.
+    static int64_t getAirtime(const Types::Pulse * pulses,
+        const size_t pulseCount);
+
+    /// Get the airtime of air scan samples.
+    static int64_t getAirtime(const std::vector<bool> & samples,
+        const int32_t samplingRateUs);
+
+    /// Sense the channel on the given GPIO pin before every frame.
+    void setCarrierSense(const uint8_t gpioPin, const int32_t listenUs);
+
+    /// Transmit a pulse train the given number of times.
+    Statistics transmit(const Types::Pulse * pulses, const size_t pulseCount,
+        const int32_t sendCommand, const int32_t sendDelayUs,
+        const int64_t frameToleranceNs = -1,
+        const uint32_t maxRetransmissions = 0U);
+
+    /// Transmit air scan samples at the given sampling rate.
+    uint32_t transmit(const std::vector<bool> & samples,
+        const int32_t samplingRateUs);
+
+    /// Prepare the GPIO pin for a stream of single edges.
+    void beginStream(void);
+
+    /// Transmit a single edge of a stream at the given deadline.
+    int64_t transmitEdge(const bool level, const int64_t deadlineNs,
+        uint32_t & missedDeadlines);
+
+    /// Release the GPIO pin after a stream of single edges.
+    void endStream(void);
+
+protected:
+    /// GPIO pin to transmit on.
+    const uint8_t gpioPin_;
+
+    /// Timing profile of the host.
+    const TimingProfile & profile_;
+
+    /// Prepare the GPIO pin for transmission.
+    virtual void begin(void);
+
+    /**
+     * @brief Set the GPIO pin to the given level.
+     * @param level Signal level, false=low / true=high.
+     * @param deadlineNs Monotonic time the edge is scheduled for (unit:
+     *                   nanoseconds).
+     */
+    virtual void write(const bool level, const int64_t deadlineNs);
+
+    /**
+     * @brief Release the GPIO pin after transmission.
+     * @param deadlineNs Monotonic time the transmission is scheduled to end
+     *                   at (unit: nanoseconds).
+     */
+    virtual void end(const int64_t deadlineNs);
+
+    /**
+     * @brief Called after every frame of a pulse train transmission.
+     * @param beginNs Monotonic time the frame was scheduled to begin at
+     *                (unit: nanoseconds).
+     * @param endNs Monotonic time the frame was scheduled to end at (unit:
+     *              nanoseconds).
+     * @return True to continue the transmission, false to stop it.
+     */
+    virtual bool frameSent(const int64_t beginNs, const int64_t endNs);
+
+private:
+    /**
+     * @brief Delay between two samples while sensing the channel.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t POLL_INTERVAL_NS = 20000;
+
+    /**
+     * @brief Maximum backoff of a frame if the channel is busy.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t MAX_BACKOFF_NS = 100000000;
+
+    /// Maximum number of backoffs of a frame before it is sent anyway.
+    static const uint32_t MAX_BACKOFFS = 8U;
+
+    /// GPIO pin of the receiver sensing the channel, invalid if not sensed.
+    uint8_t senseGpioPin_;
+
+    /**
+     * @brief Time the channel must be idle before every frame.
+     * @note Unit: nanoseconds
+     */
+    int64_t listenNs_;
+
+    /// Random number generator of the backoffs.
+    std::minstd_rand random_;
+
+    /// Wait until the channel is idle before a frame.
+    int64_t senseCarrier(const int64_t deadlineNs, const int64_t quietNs,
+        Statistics & statistics);
+
+    /// Listen for a carrier on the channel within the given period.
+    int64_t listen(const int64_t beginNs, const int64_t endNs) const;
+
+    /// Wait until the given deadline, counting it if already missed.
+    int64_t waitUntil(const int64_t deadlineNs,
+        uint32_t & missedDeadlines) const;
+};
@@ -0,0 +1,140 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "Encoder.h"
+#include "ScanParameters.h"
+#include "TargetParameters.h"
+#include "Task.h"
+#include "Types.h"
+
+/**
+ * @brief Class sweeping the timing parameters of a target for the shortest
+ *        reliable transmission.
+ *
+ * The data and sync lengths are shortened step by step. Every length is
+ * checked for acceptance either with the air scan receiver or with a
+ * confirmation script, resulting in the smallest send command meeting the
+ * requested reliability. Only a confirmation script observes whether the
+ * device accepts shorter send delays, so they are only tried with a script.
+ * The combination with the least airtime is proposed as configuration
+ * snippet.
+ */
+class Tuning : public Task {
+public:
+    /// Class constructor.
+    Tuning(Configuration & configuration, const std::string & name,
+        const std::string & confirmScript, const int32_t reliabilityPercent);
+
+    /// Start the tuning.
+    int start(void) final;
+
+private:
+    /// Data and sync lengths tried, relative to the configured ones.
+    static const int32_t LENGTH_PERCENTS[];
+
+    /// Send delays tried, relative to the configured one.
+    static const int32_t SEND_DELAY_PERCENTS[];
+
+    /// Number of bursts verified with the receiver per send command.
+    static const int32_t RECEIVER_BURSTS = 20;
+
+    /**
+     * @brief Pause between two bursts verified with the receiver.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t BURST_GAP_NS = 100000000;
+
+    /// Number of confirmed transmissions per combination.
+    static const int32_t CONFIRM_TRIALS = 5;
+
+    /// Timing parameters of a target.
+    struct Candidate {
+        /**
+         * @brief Pulse length of a single data element.
+         * @note Unit: microseconds
+         */
+        int32_t dataLengthUs;
+
+        /**
+         * @brief Pulse length of a single sync element.
+         * @note Unit: microseconds
+         */
+        int32_t syncLengthUs;
+
+        /// Number of times the air command will be transmitted.
+        int32_t sendCommand;
+
+        /**
+         * @brief Delay between repeated air command transmissions.
+         * @note Unit: microseconds
+         */
+        int32_t sendDelayUs;
+
+        /**
+         * @brief Duration of the whole transmission.
+         * @note Unit: nanoseconds
+         */
+        int64_t airtimeNs;
+    };
+
+    /// Target section name.
+    const std::string name_;
+
+    /// Script confirming the acceptance, empty to use the receiver.
+    const std::string confirmScript_;
+
+    /// Minimum ratio of accepted transmissions (unit: percent).
+    const int32_t reliabilityPercent_;
+
+    /// Find the smallest reliable send command using the receiver.
+    int32_t tuneWithReceiver(const ScanParameters & scanParameters,
+        const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds,
+        const Candidate & candidate, const int32_t maxSendCommand,
+        const int64_t maxAirtimeNs) const;
+
+    /// Transmit a burst and check whether any of its frames is received.
+    bool isBurstReceived(const ScanParameters & scanParameters,
+        const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds,
+        const Candidate & candidate) const;
+
+    /// Find the smallest reliable send command using the confirmation script.
+    int32_t tuneWithScript(const std::vector<Types::Pulse> & pulses,
+        const Candidate & candidate, const int32_t minSendCommand,
+        const int32_t maxSendCommand, const int64_t maxAirtimeNs) const;
+
+    /// Run the confirmation script for a transmission.
+    bool confirm(const Candidate & candidate) const;
+
+    /// Print the proposed parameters as configuration snippet.
+    void printSnippet(const Candidate & candidate,
+        const int64_t configuredAirtimeNs) const;
+
+    /// Get the duration of a transmission.
+    static int64_t getAirtime(const std::vector<Types::Pulse> & pulses,
+        const int32_t sendCommand, const int32_t sendDelayUs);
+};
@@ -36,12 +36,30 @@ struct AirCode {
     };
 };
 
+/// Single pulse of a radio frame.
+struct Pulse {
+    /// Signal level, 0=low / 1=high.
+    uint32_t level;
+
+    /**
+     * @brief Duration of the pulse.
+     * @note Unit: nanoseconds
+     */
+    uint32_t durationNs;
+};
+
 /// Signature to be used to identify dump files.
 static const uint32_t DUMP_SIGNATURE = 0xDEADC0DEU;
 
 /// Invalid GPIO pin marker.
 static const uint8_t INVALID_GPIO_PIN = UINT8_MAX;
 
+/**
+ * @brief Maximum data and sync length.
+ * @note Unit: microseconds
+ */
+static const int32_t MAX_PULSE_LENGTH_US = 1000000;
+
 /// Invalid parameter marker.
 static const int32_t INVALID_PARAMETER = INT32_MIN;
 
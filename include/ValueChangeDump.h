@@ -0,0 +1,80 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Class streaming air scan samples as Value Change Dump (IEEE 1364).
+ *
+ * Only edges are written, so the output size depends on the number of edges
+ * rather than on the number of samples. Value Change Dumps can be opened by
+ * logic analyzer tools like PulseView, sigrok-cli (input format 'vcd') or
+ * GTKWave.
+ */
+class ValueChangeDump {
+public:
+    /// Class constructor.
+    ValueChangeDump(std::ostream & stream, const uint8_t gpioPin,
+        const int32_t samplingRateUs);
+
+    /// Check whether the given file name denotes a Value Change Dump.
+    static bool isValueChangeDump(const std::string & file);
+
+    /// Write the header declaring the signal of the GPIO pin.
+    void writeHeader(void);
+
+    /// Write the next sample, only written if it differs from the previous.
+    void writeSample(const bool level) {
+        if ((sample_ == 0U) || (level != level_)) {
+            writeEdge(level);
+        }
+        sample_++;
+    }
+
+    /// Write the end of the dump covering the duration of all samples.
+    void writeEnd(void);
+
+private:
+    /// File name extension of Value Change Dumps.
+    static const std::string EXTENSION;
+
+    /// Stream receiving the dump.
+    std::ostream & stream_;
+
+    /// GPIO pin the samples have been captured from.
+    const uint8_t gpioPin_;
+
+    /**
+     * @brief Time between two samples.
+     * @note Unit: microseconds
+     */
+    const int32_t samplingRateUs_;
+
+    /// Index of the next sample.
+    uint64_t sample_;
+
+    /// Level of the previous sample.
+    bool level_;
+
+    /// Write a level change at the time of the next sample.
+    void writeEdge(const bool level);
+};
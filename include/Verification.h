@@ -0,0 +1,67 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "TargetParameters.h"
+#include "Task.h"
+#include "Verifier.h"
+
+/**
+ * @brief Class verifying target transmissions with the air scan receiver.
+ *
+ * While the target is transmitted, a receiver thread samples the GPIO pin of
+ * the 'scan' section and captures the edges of the received signal. After
+ * every frame the received signal is compared element by element to the air
+ * command: an element has been received correctly if the received level in
+ * the middle of each of its pulses matches the transmitted level. The delay of
+ * the receiver is estimated per frame from its first edge (see Receiver and
+ * Verifier).
+ *
+ * The transmission stops early as soon as the requested number of clean
+ * frames, i.e. frames without any wrong element, has been received.
+ */
+class Verification : public Task {
+public:
+    /// Class constructor.
+    Verification(Configuration & configuration, const std::string & name,
+        const int32_t copies);
+
+    /// Start the verification.
+    int start(void) final;
+
+private:
+    /// Target section name.
+    const std::string name_;
+
+    /// Number of clean frames to stop after, <=0 to never stop early.
+    const int32_t copies_;
+
+    /// Get the index of the pulse following each air command element.
+    bool getElementEnds(const TargetParameters & parameters,
+        std::vector<size_t> & elementEnds) const;
+
+    /// Print the results of all frames.
+    static void report(const Verifier & verifier, const size_t elements);
+};
@@ -0,0 +1,92 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Encoder.h"
+#include "Receiver.h"
+#include "Transmitter.h"
+#include "Types.h"
+
+/**
+ * @brief Class transmitting pulse trains and comparing them to the received
+ *        signal.
+ *
+ * After every frame the received signal is compared element by element to
+ * the air command: an element has been received correctly if the received
+ * level in the middle of each of its pulses matches the transmitted level.
+ * The delay of the receiver is estimated per frame from its first edge. The
+ * transmission stops early as soon as the requested number of clean frames,
+ * i.e. frames without any wrong element, has been received.
+ */
+class Verifier : public Transmitter {
+public:
+    /// Result of a single verified frame.
+    struct Frame {
+        /// Number of wrong elements.
+        uint32_t errors;
+
+        /**
+         * @brief Estimated delay of the received signal.
+         * @note Unit: nanoseconds, -1 if no edge has been received.
+         */
+        int64_t latencyNs;
+    };
+
+    /// Class constructor.
+    Verifier(const uint8_t gpioPin, const Receiver & receiver,
+        const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds, const int32_t copies,
+        const size_t frameCapacity);
+
+    /// Get the index of the pulse following each air command element.
+    static std::vector<size_t> getElementEnds(
+        const Encoder::Encoding & encoding, const std::string & airCommand,
+        const int32_t dataLengthUs, const int32_t syncLengthUs);
+
+    /// Results of all transmitted frames.
+    std::vector<Frame> frames;
+
+    /// Number of frames without any wrong element.
+    int32_t cleanFrames;
+
+protected:
+    /// Compare the frame to the received signal.
+    bool frameSent(const int64_t beginNs, const int64_t endNs) final;
+
+private:
+    /// Receiver capturing the transmitted signal.
+    const Receiver & receiver_;
+
+    /// Pulse train of a single air command transmission.
+    const std::vector<Types::Pulse> & pulses_;
+
+    /// Index of the pulse following each air command element.
+    const std::vector<size_t> & elementEnds_;
+
+    /// Number of clean frames to stop after, <=0 to never stop early.
+    const int32_t copies_;
+
+    /// Estimate the delay of the received signal for a frame.
+    int64_t estimateLatency(const int64_t beginNs) const;
+};
@@ -0,0 +1,137 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+
+#include "ArchiveBuilder.h"
+#include "FrameArchive.h"
+#include "Replay.h"
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param archiveFile File name of the frame archive, created if missing.
+ */
+ArchiveBuilder::ArchiveBuilder(Configuration & configuration,
+        const std::string & archiveFile) :
+        Task(configuration),
+        archiveFile_(archiveFile),
+        dumpFiles_() {
+    // Do nothing
+}
+
+/// @param dumpFile Air scan dump file, optionally prefixed by 'name='.
+void ArchiveBuilder::addDumpFile(const std::string & dumpFile) {
+    dumpFiles_.push_back(dumpFile);
+}
+
+/**
+ * All frames of the resulting archive are written to stdout as tab separated
+ * values.
+ *
+ * @return Program exit code.
+ */
+int ArchiveBuilder::start(void) {
+    FrameArchive archive(archiveFile_);
+    std::map<std::string, FrameArchive::Frame> frames;
+
+    // Keep the frames of an existing archive
+    if (access(archiveFile_.c_str(), F_OK) == 0) {
+        if (!archive.open()) {
+            return EXIT_FAILURE;
+        }
+        for (const std::string & name : archive.getNames()) {
+            archive.find(name, frames[name]);
+        }
+    } else if (dumpFiles_.empty()) {
+        std::cerr << "Error: Frame archive '" << archiveFile_ << "' does not "
+            "exist, no air scan dumps given to create it from" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Add the air scan dumps, their samples must outlive writing the archive
+    std::vector<std::vector<uint8_t>> samples;
+    samples.reserve(dumpFiles_.size());
+    for (const std::string & dumpFile : dumpFiles_) {
+        std::string name;
+        std::string file;
+        if (!getFrameName(dumpFile, name, file)) {
+            return EXIT_FAILURE;
+        }
+
+        Replay replay(configuration_, file);
+        if (!replay.load()) {
+            return EXIT_FAILURE;
+        }
+        samples.emplace_back(replay.getData().begin(), replay.getData().end());
+        frames[name] = { samples.back().data(), samples.back().size(),
+            replay.getSamplingRate() };
+    }
+
+    if (!dumpFiles_.empty() && !archive.write(frames)) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "# name\tsamples\tsamplingRateUs" << std::endl;
+    for (const auto & frame : frames) {
+        std::cout << frame.first << "\t" << frame.second.sampleCount << "\t"
+            << frame.second.samplingRateUs << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @param argument Dump file argument, either 'name=file' or 'file'.
+ * @param name Place to store the frame name to.
+ * @param file Place to store the dump file name to.
+ * @return True if the frame name is valid, false otherwise.
+ */
+bool ArchiveBuilder::getFrameName(const std::string & argument,
+        std::string & name, std::string & file) {
+    const size_t equals = argument.find('=');
+
+    if (equals != std::string::npos) {
+        name = argument.substr(0U, equals);
+        file = argument.substr(equals + 1U);
+    } else {
+        // Strip directory and extension, frames of archives keep their name
+        file = argument;
+        name = argument.substr(argument.rfind('/') + 1U);
+        const size_t separator = name.rfind(FrameArchive::SEPARATOR);
+        const size_t extension = name.rfind('.');
+        if (separator != std::string::npos) {
+            name = name.substr(separator + 1U);
+        } else if ((extension != std::string::npos) && (extension > 0U)) {
+            name = name.substr(0U, extension);
+        }
+    }
+
+    if (name.empty() || (name.find(FrameArchive::SEPARATOR)
+            != std::string::npos)) {
+        std::cerr << "Error: Frame name '" << name << "' of '" << argument
+            << "' is invalid (must not be empty or contain '"
+            << FrameArchive::SEPARATOR << "')" << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,224 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "Benchmark.h"
+#include "Clock.h"
+#include "Encoder.h"
+#include "TargetIndex.h"
+
+const char * const Benchmark::ALL_TARGETS = "all";
+const char * const Benchmark::SYNTHETIC = "synthetic";
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param selection Target name, ALL_TARGETS or SYNTHETIC.
+ */
+Benchmark::Benchmark(Configuration & configuration,
+        const std::string & selection) :
+        Task(configuration),
+        selection_(selection) {
+    // Do nothing
+}
+
+/**
+ * Edge errors are the delays of the actual edges behind their scheduled
+ * times. A deadline is missed if an edge happens after the scheduled time of
+ * the following edge, i.e. the pulse before it has been swallowed completely.
+ * The stretch is the difference of the actual and the scheduled transmission
+ * duration.
+ *
+ * @return Program exit code.
+ */
+int Benchmark::start(void) {
+    std::cout << "# name\tframes\tedges\tp50Ns\tp99Ns\tmaxNs\tstretchNs\t"
+        "missed" << std::endl;
+
+    if (selection_ == SYNTHETIC) {
+        benchmarkSynthetic();
+        return EXIT_SUCCESS;
+    }
+
+    if (selection_ != ALL_TARGETS) {
+        return benchmarkTarget(selection_) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    bool isSuccessful = true;
+    const TargetIndex & targetIndex = configuration_.getTargetIndex();
+    for (const std::string & name : targetIndex.getNames()) {
+        isSuccessful &= benchmarkTarget(name);
+    }
+
+    return isSuccessful ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @param name Target name.
+ * @return True if successful, false if the target is unknown or invalid.
+ */
+bool Benchmark::benchmarkTarget(const std::string & name) const {
+    const TargetParameters * parameters =
+        configuration_.getTargetIndex().find(name);
+    if (parameters == nullptr) {
+        return false;
+    }
+
+    benchmarkPulses(name, parameters->getPulses(),
+        parameters->getSendCommand(), parameters->getSendDelay());
+
+    return true;
+}
+
+/**
+ * Every built-in encoding transmits all of its elements several times at a
+ * short data length, followed by an air scan replay of alternating samples.
+ */
+void Benchmark::benchmarkSynthetic(void) const {
+    const int32_t DATA_LENGTH_US = 300;
+    const int32_t SYNC_LENGTH_US = 3000;
+    const int32_t SEND_COMMAND = 3;
+    const int32_t SEND_DELAY_US = 10000;
+    const int32_t ELEMENT_REPETITIONS = 16;
+    const size_t REPLAY_SAMPLES = 10000U;
+    const int32_t REPLAY_SAMPLING_RATE_US = 100;
+
+    for (auto airCode = 0; airCode < Types::AirCode::MAX; airCode++) {
+        const Encoder::Encoding & encoding = Encoder::getBuiltIn(
+            static_cast<Types::AirCode::AirCode_>(airCode));
+
+        std::string airCommand;
+        for (auto i = 0; i < ELEMENT_REPETITIONS; i++) {
+            airCommand += Encoder::getElements(encoding);
+        }
+
+        benchmarkPulses(std::string(SYNTHETIC) + "-" + encoding.name,
+            Encoder::encode(encoding, airCommand, DATA_LENGTH_US,
+            SYNC_LENGTH_US), SEND_COMMAND, SEND_DELAY_US);
+    }
+
+    std::vector<bool> samples(REPLAY_SAMPLES);
+    for (auto i = 0U; i < samples.size(); i++) {
+        samples[i] = (i % 2U) != 0U;
+    }
+
+    Loopback loopback(samples.size());
+    loopback.transmit(samples, REPLAY_SAMPLING_RATE_US);
+    report(std::string(SYNTHETIC) + "-replay", 1, loopback);
+}
+
+/**
+ * @param name Name to report the result with.
+ * @param pulses Pulse train of a single air command transmission.
+ * @param sendCommand Number of times the pulse train will be transmitted.
+ * @param sendDelayUs Delay between repeated transmissions (unit:
+ *                    microseconds).
+ */
+void Benchmark::benchmarkPulses(const std::string & name,
+        const std::vector<Types::Pulse> & pulses, const int32_t sendCommand,
+        const int32_t sendDelayUs) const {
+    // Pulses plus the low edges between the repetitions
+    Loopback loopback((pulses.size() + 1U) * sendCommand);
+
+    loopback.transmit(pulses.data(), pulses.size(), sendCommand, sendDelayUs);
+    report(name, sendCommand, loopback);
+}
+
+/**
+ * @param name Name to report the result with.
+ * @param frames Number of transmitted frames.
+ * @param loopback Loopback holding the captured edges.
+ */
+void Benchmark::report(const std::string & name, const int32_t frames,
+        const Loopback & loopback) {
+    const size_t edges = loopback.actualNs.size() - 1U;
+    std::vector<int64_t> errorsNs;
+    uint32_t missed = 0U;
+
+    errorsNs.reserve(edges);
+    for (auto i = 0U; i < edges; i++) {
+        errorsNs.push_back(std::abs(loopback.actualNs[i]
+            - loopback.scheduledNs[i]));
+        if (loopback.actualNs[i] > loopback.scheduledNs[i + 1U]) {
+            missed++;
+        }
+    }
+    std::sort(errorsNs.begin(), errorsNs.end());
+
+    const int64_t stretchNs =
+        (loopback.actualNs.back() - loopback.actualNs.front())
+        - (loopback.scheduledNs.back() - loopback.scheduledNs.front());
+
+    std::cout << name << "\t" << frames << "\t" << edges << "\t"
+        << getPercentile(errorsNs, 50U) << "\t"
+        << getPercentile(errorsNs, 99U) << "\t"
+        << (errorsNs.empty() ? 0 : errorsNs.back()) << "\t"
+        << stretchNs << "\t" << missed << std::endl;
+}
+
+/**
+ * @param sortedValues Values sorted in ascending order.
+ * @param percent Percentile to get, 0-100.
+ * @return Percentile using the nearest rank method, 0 if there are no values.
+ */
+int64_t Benchmark::getPercentile(const std::vector<int64_t> & sortedValues,
+        const uint32_t percent) {
+    if (sortedValues.empty()) {
+        return 0;
+    }
+
+    size_t rank = (sortedValues.size() * percent + 99U) / 100U;
+    return sortedValues.at((rank > 0U) ? rank - 1U : 0U);
+}
+
+/**
+ * Capacity for all edges is reserved upfront, so capturing an edge does not
+ * allocate memory.
+ *
+ * @param edgeCount Expected number of edges.
+ */
+Benchmark::Loopback::Loopback(const size_t edgeCount) :
+        Transmitter(Types::INVALID_GPIO_PIN) {
+    scheduledNs.reserve(edgeCount + 1U);
+    actualNs.reserve(edgeCount + 1U);
+}
+
+void Benchmark::Loopback::begin(void) {
+    // Do nothing
+}
+
+/**
+ * @param deadlineNs Monotonic time the edge is scheduled for (unit:
+ *                   nanoseconds).
+ */
+void Benchmark::Loopback::write(const bool, const int64_t deadlineNs) {
+    actualNs.push_back(Clock::now());
+    scheduledNs.push_back(deadlineNs);
+}
+
+/**
+ * @param deadlineNs Monotonic time the transmission is scheduled to end at
+ *                   (unit: nanoseconds).
+ */
+void Benchmark::Loopback::end(const int64_t deadlineNs) {
+    actualNs.push_back(Clock::now());
+    scheduledNs.push_back(deadlineNs);
+}
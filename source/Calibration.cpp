@@ -0,0 +1,135 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include <wiringPi.h>
+
+#include "Calibration.h"
+#include "Clock.h"
+#include "TimingProfile.h"
+
+/// @param configuration Reference of the configuration.
+Calibration::Calibration(Configuration & configuration) :
+        Task(configuration) {
+    // Do nothing
+}
+
+/// @return Program exit code.
+int Calibration::start(void) {
+    // Get GPIO from the target defaults unless overridden from the command
+    // line
+    if (gpioPin_ == Types::INVALID_GPIO_PIN) {
+        int gpioPin;
+        if (!configuration_.getValue("target", "gpioPin", gpioPin)) {
+            std::cerr << "Error: Configuration error (section target): "
+                "gpioPin is undefined, use parameter '-g'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        gpioPin_ = static_cast<uint8_t>(gpioPin);
+    }
+    if (!isValidGpioPin(gpioPin_)) {
+        std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Calibrating timing of board revision " << piBoardRev()
+        << "..." << std::endl;
+
+    const int32_t clockReadNs = measureClockRead();
+    const int32_t sleepOvershootNs = measureSleepOvershoot();
+    const int32_t gpioWriteNs = measureGpioWrite();
+
+    std::cout << "Sleep overshoot: " << sleepOvershootNs << "ns" << std::endl
+        << "GPIO write: " << gpioWriteNs << "ns" << std::endl
+        << "Spin loop: " << ((clockReadNs > 0) ? 1000 / clockReadNs : 1000)
+        << " iterations per microsecond" << std::endl;
+
+    // Keep the sampling rate measured by the probe
+    if (!TimingProfile(sleepOvershootNs, gpioWriteNs, clockReadNs,
+            TimingProfile::get().getSamplingRate()).save()) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Timing profile written to " << TimingProfile::LOCATION
+        << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/// @return Average clock read duration (unit: nanoseconds).
+int32_t Calibration::measureClockRead(void) {
+    const int32_t ITERATIONS = 100000;
+
+    const int64_t beginNs = Clock::now();
+    for (auto i = 0; i < ITERATIONS; i++) {
+        Clock::now();
+    }
+
+    return static_cast<int32_t>((Clock::now() - beginNs) / ITERATIONS);
+}
+
+/**
+ * Sleeps of varying length cover the typical pulse lengths. The 99th
+ * percentile is used, so the spin loop absorbs nearly all wake-up jitter.
+ *
+ * @return Sleep overshoot (unit: nanoseconds).
+ */
+int32_t Calibration::measureSleepOvershoot(void) {
+    const int32_t ITERATIONS = 2000;
+    const int64_t MAX_SLEEP_NS = 2000000;
+    const int64_t SLEEP_STEP_NS = 50000;
+    std::vector<int64_t> overshootsNs;
+
+    overshootsNs.reserve(ITERATIONS);
+    for (auto i = 0; i < ITERATIONS; i++) {
+        const int64_t deadlineNs = Clock::now()
+            + (i * SLEEP_STEP_NS) % MAX_SLEEP_NS + SLEEP_STEP_NS;
+        Clock::sleepUntil(deadlineNs);
+        overshootsNs.push_back(Clock::now() - deadlineNs);
+    }
+    std::sort(overshootsNs.begin(), overshootsNs.end());
+
+    return static_cast<int32_t>(overshootsNs.at(ITERATIONS * 99 / 100));
+}
+
+/**
+ * The GPIO pin is only written low, so nothing is transmitted.
+ *
+ * @return Average GPIO write duration (unit: nanoseconds).
+ */
+int32_t Calibration::measureGpioWrite(void) const {
+    const int32_t ITERATIONS = 100000;
+
+    pinMode(gpioPin_, OUTPUT);
+    const int64_t beginNs = Clock::now();
+    for (auto i = 0; i < ITERATIONS; i++) {
+        digitalWrite(gpioPin_, LOW);
+    }
+    const int64_t durationNs = Clock::now() - beginNs;
+    pinMode(gpioPin_, INPUT);
+
+    return static_cast<int32_t>(durationNs / ITERATIONS);
+}
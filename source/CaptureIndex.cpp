@@ -0,0 +1,372 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <utility>
+
+#include "CaptureIndex.h"
+#include "Types.h"
+
+const std::string CaptureIndex::SUFFIX = ".idx";
+
+/// @param dumpFile File name of the air scan dump.
+CaptureIndex::CaptureIndex(const std::string & dumpFile) :
+        dumpFile_(dumpFile),
+        samplingRateUs_(Types::INVALID_PARAMETER),
+        sampleCount_(0U),
+        level_(false),
+        lastEdge_(0U),
+        isOpen_(false),
+        segments_() {
+    // Do nothing
+}
+
+/**
+ * Only replay files whose part before the separator names an existing file
+ * are split, this way neither dump files nor archived frames containing the
+ * separator are affected.
+ *
+ * @param file Replay file, either a dump file or 'dump@selection'.
+ * @param dumpFile Place to store the dump file name to.
+ * @param selection Place to store the selection to, see select().
+ * @return True if the replay file selects a part of a dump, false otherwise.
+ */
+bool CaptureIndex::split(const std::string & file, std::string & dumpFile,
+        std::string & selection) {
+    const size_t separator = file.rfind(SEPARATOR);
+
+    if ((separator == std::string::npos) || (separator == 0U)
+            || (separator + 1U == file.length())
+            || (access(file.c_str(), F_OK) == 0)
+            || (access(file.substr(0U, separator).c_str(), F_OK) != 0)) {
+        return false;
+    }
+    dumpFile = file.substr(0U, separator);
+    selection = file.substr(separator + 1U);
+
+    return true;
+}
+
+/// @param samplingRateUs Delay between two samples (unit: microseconds).
+void CaptureIndex::begin(const int32_t samplingRateUs) {
+    samplingRateUs_ = samplingRateUs;
+    sampleCount_ = 0U;
+    level_ = false;
+    lastEdge_ = 0U;
+    isOpen_ = false;
+    segments_.clear();
+}
+
+void CaptureIndex::end(void) {
+    if (isOpen_) {
+        closeSegment();
+    }
+}
+
+/**
+ * The sample count must match the size of the dump file and segments not
+ * lying within these samples are rejected as well, this way a corrupted index
+ * never makes a replay seek beyond the dump.
+ *
+ * @return True if an up to date index file has been loaded, false otherwise.
+ */
+bool CaptureIndex::load(void) {
+    Header fingerprint;
+    Header header;
+
+    if (!getFingerprint(fingerprint)) {
+        return false;
+    }
+
+    std::ifstream indexFile(dumpFile_ + SUFFIX, std::ios::in
+        | std::ios::binary);
+    if (!indexFile.read(reinterpret_cast<char *>(&header), sizeof(header))
+            || (header.signature != SIGNATURE)
+            || (header.version != VERSION)
+            || (header.modificationTimeS != fingerprint.modificationTimeS)
+            || (header.modificationTimeNs != fingerprint.modificationTimeNs)
+            || (header.size != fingerprint.size)
+            || (header.samplingRateUs <= 0)
+            || (header.size < SAMPLES_OFFSET)
+            || (header.sampleCount != header.size - SAMPLES_OFFSET)
+            || (header.segmentCount > header.sampleCount)) {
+        return false;
+    }
+
+    std::vector<Segment> segments(header.segmentCount);
+    if (!indexFile.read(reinterpret_cast<char *>(segments.data()),
+            segments.size() * sizeof(Segment))) {
+        return false;
+    }
+    for (const Segment & segment : segments) {
+        if ((segment.sampleCount > header.sampleCount)
+                || (segment.firstSample > header.sampleCount
+                    - segment.sampleCount)) {
+            return false;
+        }
+    }
+
+    samplingRateUs_ = header.samplingRateUs;
+    sampleCount_ = header.sampleCount;
+    segments_ = std::move(segments);
+    isOpen_ = false;
+
+    return true;
+}
+
+/**
+ * Format of the dump file, see Scan:
+ * - [4 bytes] Signature
+ * - [4 bytes] Sampling rate (unit: microseconds)
+ * - [n bytes] Sample data, 1 byte each, 0=low / 1=high
+ *
+ * @return True if successful, false otherwise.
+ */
+bool CaptureIndex::build(void) {
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    std::ifstream dumpFile(dumpFile_, std::ios::in | std::ios::binary);
+    uint32_t signature;
+    int32_t samplingRateUs;
+
+    if (!dumpFile.is_open()) {
+        std::cerr << "Error: Dump file '" << dumpFile_ << "' cannot be opened "
+            "for reading: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!dumpFile.read(reinterpret_cast<char *>(&signature),
+            sizeof(signature)) || (signature != Types::DUMP_SIGNATURE)) {
+        std::cerr << "Error: Given file is not an air scan dump (signature "
+            "mismatch)" << std::endl;
+        return false;
+    }
+    if (!dumpFile.read(reinterpret_cast<char *>(&samplingRateUs),
+            sizeof(samplingRateUs)) || (samplingRateUs <= 0)) {
+        std::cerr << "Error: Given air scan dump seems corrupted (invalid "
+            "sampling rate)" << std::endl;
+        return false;
+    }
+
+    begin(samplingRateUs);
+    while (dumpFile.read(buffer.data(), buffer.size())
+            || (dumpFile.gcount() > 0)) {
+        const size_t count = static_cast<size_t>(dumpFile.gcount());
+
+        for (size_t i = 0U; i < count; i++) {
+            if ((buffer[i] < 0) || (buffer[i] > 1)) {
+                std::cerr << "Error: Given air scan dump seems corrupted "
+                    "(invalid data value " << +buffer[i] << ")" << std::endl;
+                return false;
+            }
+            addSample(buffer[i] == 1);
+        }
+    }
+    end();
+
+    return true;
+}
+
+/**
+ * The index file is written to a temporary file first and renamed afterwards,
+ * this way concurrent replays never read a partially written index.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool CaptureIndex::save(void) const {
+    Header header;
+
+    if (!getFingerprint(header)) {
+        return false;
+    }
+    header.sampleCount = sampleCount_;
+    header.samplingRateUs = samplingRateUs_;
+    header.segmentCount = segments_.size();
+
+    const std::string location = dumpFile_ + SUFFIX;
+    const std::string temporaryLocation = location + "."
+        + std::to_string(getpid());
+    std::ofstream indexFile(temporaryLocation, std::ios::out
+        | std::ios::binary | std::ios::trunc);
+    if (!indexFile.is_open()) {
+        return false;
+    }
+
+    indexFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    indexFile.write(reinterpret_cast<const char *>(segments_.data()),
+        segments_.size() * sizeof(Segment));
+    indexFile.close();
+
+    if (!indexFile || (rename(temporaryLocation.c_str(), location.c_str())
+            != 0)) {
+        unlink(temporaryLocation.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Failing to save a built index is silently ignored, the dump file will be
+ * indexed again next time.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool CaptureIndex::open(void) {
+    if (load()) {
+        return true;
+    }
+    if (!build()) {
+        return false;
+    }
+    save();
+
+    return true;
+}
+
+/**
+ * @param selection Either the number of a segment starting at 1, or a time
+ *                  range given as '<from>-<to>' in milliseconds since the
+ *                  beginning of the dump.
+ * @param segment Range of samples to be set.
+ * @return True if successful, false otherwise.
+ */
+bool CaptureIndex::select(const std::string & selection,
+        Segment & segment) const {
+    const int64_t MICROSECONDS_PER_MILLISECOND = 1000;
+    const char * begin = selection.c_str();
+    char * end;
+
+    const int64_t number = strtoll(begin, &end, 10);
+    if ((end != begin) && (*end == '\0') && (number > 0)) {
+        if (static_cast<uint64_t>(number) > segments_.size()) {
+            std::cerr << "Error: Segment " << number << " does not exist, "
+                "the air scan dump contains " << segments_.size()
+                << " segments" << std::endl;
+            return false;
+        }
+        segment = segments_[number - 1];
+        return true;
+    }
+
+    // Otherwise the selection must be a time range
+    int64_t toMs = -1;
+    if ((end != begin) && (*end == '-')) {
+        const char * to = end + 1;
+        toMs = strtoll(to, &end, 10);
+        toMs = (end != to) ? toMs : -1;
+    }
+    if ((number < 0) || (toMs <= number) || (*end != '\0')) {
+        std::cerr << "Error: Selection '" << selection << "' is invalid, "
+            "must be a segment number or a time range '<from ms>-<to ms>'"
+            << std::endl;
+        return false;
+    }
+
+    const uint64_t first = static_cast<uint64_t>(number
+        * MICROSECONDS_PER_MILLISECOND / samplingRateUs_);
+    const uint64_t last = std::min(sampleCount_, static_cast<uint64_t>(toMs
+        * MICROSECONDS_PER_MILLISECOND / samplingRateUs_));
+    if (first >= last) {
+        std::cerr << "Error: Time range '" << selection << "' lies beyond the "
+            "air scan dump of " << sampleCount_ * samplingRateUs_
+            / MICROSECONDS_PER_MILLISECOND << "ms" << std::endl;
+        return false;
+    }
+    segment = { first, last - first };
+
+    return true;
+}
+
+/// @return Segments in ascending order.
+const std::vector<CaptureIndex::Segment> & CaptureIndex::getSegments(
+        void) const {
+    return segments_;
+}
+
+/// @return Delay between two samples (unit: microseconds).
+int32_t CaptureIndex::getSamplingRate(void) const {
+    return samplingRateUs_;
+}
+
+/**
+ * The first segment after an idle gap starts PADDING_US before its first edge
+ * but never overlaps the previous segment.
+ */
+void CaptureIndex::addEdge(void) {
+    const uint64_t edge = sampleCount_;
+
+    if (isOpen_ && (edge - lastEdge_ >= getSamples(IDLE_GAP_US))) {
+        closeSegment();
+    }
+    if (!isOpen_) {
+        const uint64_t padding = getSamples(PADDING_US);
+        uint64_t first = (edge > padding) ? edge - padding : 0U;
+        if (!segments_.empty()) {
+            first = std::max(first, segments_.back().firstSample
+                + segments_.back().sampleCount);
+        }
+        segments_.push_back({ first, 0U });
+        isOpen_ = true;
+    }
+    lastEdge_ = edge;
+}
+
+void CaptureIndex::closeSegment(void) {
+    const uint64_t last = std::min(sampleCount_,
+        lastEdge_ + getSamples(PADDING_US));
+
+    segments_.back().sampleCount = last - segments_.back().firstSample;
+    isOpen_ = false;
+}
+
+/**
+ * @param durationUs Duration (unit: microseconds).
+ * @return Number of samples covering the duration, at least 1.
+ */
+uint64_t CaptureIndex::getSamples(const int64_t durationUs) const {
+    return std::max(static_cast<uint64_t>(durationUs / samplingRateUs_),
+        uint64_t(1U));
+}
+
+/**
+ * @param header Header to store the fingerprint of the dump file to.
+ * @return True if the fingerprint has been determined, false otherwise.
+ */
+bool CaptureIndex::getFingerprint(Header & header) const {
+    struct stat status;
+
+    if (stat(dumpFile_.c_str(), &status) != 0) {
+        return false;
+    }
+
+    header = {};
+    header.signature = SIGNATURE;
+    header.version = VERSION;
+    header.modificationTimeS = status.st_mtim.tv_sec;
+    header.modificationTimeNs = status.st_mtim.tv_nsec;
+    header.size = status.st_size;
+
+    return true;
+}
@@ -0,0 +1,162 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <sys/stat.h>
+
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <vector>
+
+#include "CaptureSegments.h"
+#include "Types.h"
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param file Air scan dump, optionally followed by '@selection' to extract
+ *             the selection.
+ * @param dumpFile File name of the dump the selection is extracted to.
+ */
+CaptureSegments::CaptureSegments(Configuration & configuration,
+        const std::string & file, const std::string & dumpFile) :
+        Task(configuration),
+        file_(file),
+        dumpFile_(dumpFile) {
+    // Do nothing
+}
+
+/// @return Program exit code.
+int CaptureSegments::start(void) {
+    std::string file = file_;
+    std::string selection;
+
+    CaptureIndex::split(file_, file, selection);
+    if (!selection.empty() && dumpFile_.empty()) {
+        std::cerr << "Error: Extracting '" << selection << "' requires "
+            "parameter '-d'" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    CaptureIndex index(file);
+    if (!index.open()) {
+        return EXIT_FAILURE;
+    }
+    if (selection.empty()) {
+        list(index);
+        return EXIT_SUCCESS;
+    }
+
+    CaptureIndex::Segment segment;
+    if (!index.select(selection, segment)
+            || !extract(file, index, segment)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Selection '" << selection << "' extracted successfully to "
+        "file '" << dumpFile_ << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * The segments are written to stdout as tab separated values.
+ *
+ * @param index Capture index of the dump.
+ */
+void CaptureSegments::list(const CaptureIndex & index) {
+    const uint64_t samplingRateUs = index.getSamplingRate();
+    const uint64_t MICROSECONDS_PER_MILLISECOND = 1000U;
+
+    std::cout << "# segment\tstartMs\tdurationMs\tfirstSample\tsamples"
+        << std::endl;
+    for (size_t i = 0U; i < index.getSegments().size(); i++) {
+        const CaptureIndex::Segment & segment = index.getSegments()[i];
+
+        std::cout << i + 1U << "\t" << segment.firstSample * samplingRateUs
+            / MICROSECONDS_PER_MILLISECOND << "\t" << segment.sampleCount
+            * samplingRateUs / MICROSECONDS_PER_MILLISECOND << "\t"
+            << segment.firstSample << "\t" << segment.sampleCount << std::endl;
+    }
+}
+
+/**
+ * Format of the extracted dump file, see Scan:
+ * - [4 bytes] Signature
+ * - [4 bytes] Sampling rate (unit: microseconds)
+ * - [n bytes] Sample data, 1 byte each, 0=low / 1=high
+ *
+ * The dump file is refused if it is the air scan dump itself, opening it for
+ * writing would truncate the samples before they are read.
+ *
+ * @param file File name of the air scan dump to extract from.
+ * @param index Capture index of the dump.
+ * @param segment Samples to be extracted.
+ * @return True if successful, false otherwise.
+ */
+bool CaptureSegments::extract(const std::string & file,
+        const CaptureIndex & index,
+        const CaptureIndex::Segment & segment) const {
+    struct stat sourceStatus;
+    struct stat dumpStatus;
+    if ((stat(file.c_str(), &sourceStatus) == 0)
+            && (stat(dumpFile_.c_str(), &dumpStatus) == 0)
+            && (sourceStatus.st_dev == dumpStatus.st_dev)
+            && (sourceStatus.st_ino == dumpStatus.st_ino)) {
+        std::cerr << "Error: Dump file '" << dumpFile_ << "' is the air scan "
+            "dump to extract from" << std::endl;
+        return false;
+    }
+
+    std::ifstream sourceFile(file, std::ios::in | std::ios::binary);
+    std::ofstream dumpFile(dumpFile_, std::ios::out | std::ios::binary
+        | std::ios::trunc);
+    if (!dumpFile.is_open()) {
+        std::cerr << "Error: Dump file '" << dumpFile_ << "' cannot be opened "
+            "for writing: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const int32_t samplingRateUs = index.getSamplingRate();
+    dumpFile.write(reinterpret_cast<const char *>(&Types::DUMP_SIGNATURE),
+        sizeof(Types::DUMP_SIGNATURE));
+    dumpFile.write(reinterpret_cast<const char *>(&samplingRateUs),
+        sizeof(samplingRateUs));
+
+    std::vector<char> buffer(COPY_BUFFER_SIZE);
+    uint64_t remaining = segment.sampleCount;
+    sourceFile.seekg(CaptureIndex::SAMPLES_OFFSET + segment.firstSample);
+    while (remaining > 0U) {
+        const size_t count = (remaining < buffer.size())
+            ? static_cast<size_t>(remaining) : buffer.size();
+        if (!sourceFile.read(buffer.data(), count)
+                || !dumpFile.write(buffer.data(), count)) {
+            std::cerr << "Error: Unable to copy samples to dump file: "
+                << strerror(errno) << std::endl;
+            return false;
+        }
+        remaining -= count;
+    }
+
+    dumpFile.close();
+    if (!dumpFile) {
+        std::cerr << "Error: Unable to write dump file: " << strerror(errno)
+            << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <time.h>
+
+#include "Clock.h"
+
+/// @return Current monotonic time (unit: nanoseconds).
+int64_t Clock::now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * NS_PER_S + time.tv_nsec;
+}
+
+/// @param timeNs Monotonic time to wake up at (unit: nanoseconds).
+void Clock::sleepUntil(const int64_t timeNs) {
+    struct timespec time;
+
+    time.tv_sec = timeNs / NS_PER_S;
+    time.tv_nsec = timeNs % NS_PER_S;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr)
+            == EINTR) {
+        // Sleep again after signal interruptions
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+#include "Clock.h"
+#include "CommandStream.h"
+#include "InstanceLock.h"
+#include "Replay.h"
+#include "Target.h"
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param stream Stream providing one command per line.
+ */
+CommandStream::CommandStream(Configuration & configuration,
+        std::istream & stream) :
+        Task(configuration),
+        stream_(stream) {
+    // Do nothing
+}
+
+/**
+ * Empty lines and lines starting with '#' are skipped. Every other line is
+ * answered by a status line consisting of 'ok' or 'error', the line number
+ * and the execution time in microseconds, separated by spaces.
+ *
+ * @return Program exit code, failure if any command has failed.
+ */
+int CommandStream::start(void) {
+    const char * const WHITESPACE = " \t\r";
+    std::string line;
+    uint32_t lineNumber = 0U;
+    bool isSuccess = true;
+
+    while (std::getline(stream_, line)) {
+        lineNumber++;
+
+        // Split the line into command and argument
+        const size_t commandBegin = line.find_first_not_of(WHITESPACE);
+        if ((commandBegin == std::string::npos)
+                || (line[commandBegin] == '#')) {
+            continue;
+        }
+        const size_t commandEnd = line.find_first_of(WHITESPACE,
+            commandBegin);
+        const std::string command = line.substr(commandBegin,
+            commandEnd - commandBegin);
+        std::string argument;
+        const size_t argumentBegin = line.find_first_not_of(WHITESPACE,
+            commandEnd);
+        if (argumentBegin != std::string::npos) {
+            const size_t argumentEnd = line.find_last_not_of(WHITESPACE);
+            argument = line.substr(argumentBegin,
+                argumentEnd + 1U - argumentBegin);
+        }
+
+        const int64_t beginNs = Clock::now();
+        const bool isExecuted = execute(command, argument);
+        const int64_t durationNs = Clock::now() - beginNs;
+
+        std::cout << (isExecuted ? "ok " : "error ") << lineNumber << " "
+            << durationNs / Clock::NS_PER_US << std::endl;
+        isSuccess = isSuccess && isExecuted;
+    }
+
+    return isSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Available commands are 't <target>' to execute a target, 'r <file>' to
+ * replay an air scan dump and 'sleep <us>' to pause.
+ *
+ * @param command Command name.
+ * @param argument Command argument, empty if none has been given.
+ * @return True if successful, false otherwise.
+ */
+bool CommandStream::execute(const std::string & command,
+        const std::string & argument) {
+    if (argument.empty()) {
+        std::cerr << "Error: Command '" << command << "' requires an argument"
+            << std::endl;
+        return false;
+    }
+
+    if (command == "t") {
+        return execute(Target(configuration_, argument));
+    } else if (command == "r") {
+        return execute(Replay(configuration_, argument));
+    } else if (command == "sleep") {
+        char * end;
+        errno = 0;
+        const long long durationUs = strtoll(argument.c_str(), &end, 10);
+        if ((errno != 0) || (*end != '\0') || (durationUs < 0)) {
+            std::cerr << "Error: Sleep duration '" << argument
+                << "' is invalid" << std::endl;
+            return false;
+        }
+        Clock::sleepUntil(Clock::now() + durationUs * Clock::NS_PER_US);
+        return true;
+    }
+
+    std::cerr << "Error: Unknown command '" << command << "'" << std::endl;
+    return false;
+}
+
+/**
+ * The GPIO pin is unlocked after the task, so other instances are served
+ * between the commands of the stream. Everything the task writes to stdout
+ * is redirected to stderr, this way stdout carries the status lines only.
+ *
+ * @param task Task to be executed.
+ * @return True if successful, false otherwise.
+ */
+bool CommandStream::execute(Task && task) const {
+    task.setGpioPin(gpioPin_);
+    task.setInstanceLock(instanceLock_);
+
+    std::streambuf * const output = std::cout.rdbuf(std::cerr.rdbuf());
+    const bool isSuccess = (task.start() == EXIT_SUCCESS);
+    std::cout.rdbuf(output);
+    InstanceLock::unlockAll();
+
+    return isSuccess;
+}
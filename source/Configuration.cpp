@@ -17,33 +17,48 @@
  * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <unistd.h>
+
 #include <cassert>
 #include <iostream>
 
 #include "Configuration.h"
+#include "TargetIndex.h"
 
 const std::string Configuration::DEFAULT_LOCATION = "/etc/aircontrol.conf";
 
+Configuration::Configuration(void) :
+        targetIndex_(nullptr) {
+    // Do nothing
+}
+
+Configuration::~Configuration(void) {
+    // Do nothing
+}
+
 /// @param location Absolute configuration file location.
 void Configuration::setLocation(const std::string & location) {
     location_ = location;
 }
 
-/// @return True if the configuration has been loaded, false otherwise.
+/// @return Absolute configuration file location.
+const std::string & Configuration::getLocation(void) const {
+    return location_;
+}
+
+/**
+ * Parsing is deferred until the first section access, this way targets can be
+ * served from the target cache without parsing the configuration file at all.
+ *
+ * @return True if the configuration has been loaded, false otherwise.
+ */
 bool Configuration::load(void) {
     assert(!isLoaded_);
 
-    try {
-        configuration_.readFile(location_.c_str());
-    } catch (const libconfig::FileIOException & exception) {
+    if (access(location_.c_str(), R_OK) != 0) {
         std::cerr << "Configuration error (" << location_
             << "): file not found" << std::endl;
         return false;
-    } catch (const libconfig::ParseException & exception) {
-        std::cerr << "Configuration error (" << exception.getFile() << ":"
-            << exception.getLine() << "): " << exception.getError()
-            << std::endl;
-        return false;
     }
 
     isLoaded_ = true;
@@ -54,13 +69,72 @@ bool Configuration::load(void) {
  * @param section Configuration section to be checked.
  * @return True if the given section exists, false otherwise.
  */
-bool Configuration::isValidSection(const std::string section) const {
+bool Configuration::isValidSection(const std::string & section) const {
+    return getSection(section) != nullptr;
+}
+
+/**
+ * @return Root section containing all other sections, empty if the
+ *         configuration file cannot be parsed.
+ */
+const libconfig::Setting & Configuration::getRoot(void) const {
+    parse();
+    return configuration_.getRoot();
+}
+
+/**
+ * @param section Name of the section.
+ * @return Pointer to the section or nullptr if it does not exist.
+ */
+const libconfig::Setting * Configuration::getSection(
+        const std::string & section) const {
+    const libconfig::Setting & root = getRoot();
+    if (!root.exists(section)) {
+        return nullptr;
+    }
+
+    return &root[section];
+}
+
+/**
+ * The index is built once, subsequent calls only return it.
+ *
+ * @return Index of all resolved targets.
+ */
+const TargetIndex & Configuration::getTargetIndex(void) {
+    assert(isLoaded_);
+
+    if (targetIndex_ == nullptr) {
+        targetIndex_ = std::make_unique<TargetIndex>(*this);
+        targetIndex_->build();
+    }
+
+    return *targetIndex_;
+}
+
+/// @return True if the configuration file has been parsed, false otherwise.
+bool Configuration::parse(void) const {
     assert(isLoaded_);
 
+    if (isParsed_ || isParseFailed_) {
+        return isParsed_;
+    }
+
     try {
-        configuration_.lookup(section);
-        return true;
-    } catch (const libconfig::SettingNotFoundException &) {
+        configuration_.readFile(location_.c_str());
+    } catch (const libconfig::FileIOException & exception) {
+        std::cerr << "Configuration error (" << location_
+            << "): file not found" << std::endl;
+        isParseFailed_ = true;
+        return false;
+    } catch (const libconfig::ParseException & exception) {
+        std::cerr << "Configuration error (" << exception.getFile() << ":"
+            << exception.getLine() << "): " << exception.getError()
+            << std::endl;
+        isParseFailed_ = true;
         return false;
     }
+
+    isParsed_ = true;
+    return true;
 }
@@ -0,0 +1,199 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+
+#include "Clock.h"
+#include "DutyCycle.h"
+
+const std::string DutyCycle::STATE_FILE_PREFIX =
+    "/var/tmp/aircontrol-dutycycle-gpio";
+
+const uint32_t DutyCycle::SIGNATURE = 0x31435544U;
+
+/**
+ * A single transmission longer than the whole window waits for a full
+ * budget.
+ *
+ * @param gpioPin GPIO pin to transmit on.
+ * @param dutyCyclePpm Duty cycle limit (unit: parts per million).
+ * @param windowS Duty cycle window (unit: seconds).
+ * @param airtimeNs Airtime of the transmission (unit: nanoseconds).
+ * @param waitNs Place to store the time to wait before transmitting to
+ *               (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool DutyCycle::reserve(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t airtimeNs, int64_t & waitNs) {
+    const double rate = dutyCyclePpm / 1e6;
+    const double capacityNs = static_cast<double>(windowS) * Clock::NS_PER_S
+        * rate;
+    const double requiredNs = std::min(static_cast<double>(airtimeNs),
+        capacityNs);
+    State state;
+
+    const int fd = load(gpioPin, dutyCyclePpm, windowS, state);
+    if (fd < 0) {
+        return false;
+    }
+
+    waitNs = (state.budgetNs < requiredNs) ? static_cast<int64_t>(
+        (requiredNs - state.budgetNs) / rate) : 0;
+    state.budgetNs -= airtimeNs;
+
+    return store(gpioPin, fd, state);
+}
+
+/**
+ * Never waits and never overdraws the budget: the airtime, at most that of
+ * the whole window, is either taken completely or not at all.
+ *
+ * @param gpioPin GPIO pin to transmit on.
+ * @param dutyCyclePpm Duty cycle limit (unit: parts per million).
+ * @param windowS Duty cycle window (unit: seconds).
+ * @param airtimeNs Airtime to take (unit: nanoseconds).
+ * @param takenNs Place to store the airtime taken to, 0 if the budget is
+ *                insufficient (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool DutyCycle::take(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t airtimeNs, int64_t & takenNs) {
+    const double capacityNs = static_cast<double>(windowS) * Clock::NS_PER_S
+        * dutyCyclePpm / 1e6;
+    State state;
+
+    takenNs = 0;
+    const int fd = load(gpioPin, dutyCyclePpm, windowS, state);
+    if (fd < 0) {
+        return false;
+    }
+
+    const int64_t requiredNs = static_cast<int64_t>(std::min(
+        static_cast<double>(airtimeNs), capacityNs));
+    if (state.budgetNs >= requiredNs) {
+        takenNs = requiredNs;
+        state.budgetNs -= takenNs;
+    }
+
+    return store(gpioPin, fd, state);
+}
+
+/**
+ * @param gpioPin GPIO pin transmitted on.
+ * @param dutyCyclePpm Duty cycle limit (unit: parts per million).
+ * @param windowS Duty cycle window (unit: seconds).
+ * @param deltaNs Actual minus reserved airtime (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool DutyCycle::adjust(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, const int64_t deltaNs) {
+    State state;
+
+    if (deltaNs == 0) {
+        return true;
+    }
+    const int fd = load(gpioPin, dutyCyclePpm, windowS, state);
+    if (fd < 0) {
+        return false;
+    }
+
+    state.budgetNs -= deltaNs;
+
+    return store(gpioPin, fd, state);
+}
+
+/**
+ * The state file is locked until it is stored. A missing or invalid state
+ * file results in a full budget. The wall clock is used, as the budget spans
+ * reboots; a clock stepping backwards does not refill the budget.
+ *
+ * @param gpioPin GPIO pin to transmit on.
+ * @param dutyCyclePpm Duty cycle limit (unit: parts per million).
+ * @param windowS Duty cycle window (unit: seconds).
+ * @param state Place to store the refilled state to.
+ * @return Locked file descriptor of the state file, -1 on error.
+ */
+int DutyCycle::load(const uint8_t gpioPin, const int32_t dutyCyclePpm,
+        const int32_t windowS, State & state) {
+    const std::string stateFile = STATE_FILE_PREFIX + std::to_string(gpioPin);
+    const double rate = dutyCyclePpm / 1e6;
+    const double capacityNs = static_cast<double>(windowS) * Clock::NS_PER_S
+        * rate;
+
+    const int fd = open(stateFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open duty cycle state file ("
+            << stateFile << "): " << strerror(errno) << std::endl;
+        return -1;
+    }
+    while (flock(fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            std::cerr << "Error: Unable to lock duty cycle state file ("
+                << stateFile << "): " << strerror(errno) << std::endl;
+            close(fd);
+            return -1;
+        }
+    }
+
+    struct timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    const int64_t nowNs = time.tv_sec * Clock::NS_PER_S + time.tv_nsec;
+
+    // Refill the budget since the last update
+    if ((pread(fd, &state, sizeof(state), 0) != sizeof(state))
+            || (state.signature != SIGNATURE)) {
+        state.signature = SIGNATURE;
+        state.budgetNs = capacityNs;
+        state.updatedNs = nowNs;
+    }
+    const int64_t elapsedNs = std::max(nowNs - state.updatedNs, int64_t(0));
+    state.budgetNs = std::min(state.budgetNs + elapsedNs * rate, capacityNs);
+    state.updatedNs = std::max(nowNs, state.updatedNs);
+
+    return fd;
+}
+
+/**
+ * @param gpioPin GPIO pin of the state file.
+ * @param fd Locked file descriptor of the state file, closed afterwards.
+ * @param state State to write.
+ * @return True if successful, false otherwise.
+ */
+bool DutyCycle::store(const uint8_t gpioPin, const int fd,
+        const State & state) {
+    const bool isWritten =
+        (pwrite(fd, &state, sizeof(state), 0) == sizeof(state));
+    if (!isWritten) {
+        std::cerr << "Error: Unable to write duty cycle state file ("
+            << STATE_FILE_PREFIX << +gpioPin << "): " << strerror(errno)
+            << std::endl;
+    }
+    close(fd);
+
+    return isWritten;
+}
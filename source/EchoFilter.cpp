@@ -0,0 +1,61 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "EchoFilter.h"
+
+/// @param samplingRateNs Delay between two samples (unit: nanoseconds).
+EchoFilter::EchoFilter(const int64_t samplingRateNs) :
+        windowNs_(ECHO_SAMPLES * samplingRateNs),
+        written_() {
+    // Do nothing
+}
+
+/**
+ * @param level Signal level, false=low / true=high.
+ * @param writtenNs Monotonic time the edge has been written at (unit:
+ *                  nanoseconds).
+ */
+void EchoFilter::addWritten(const bool level, const int64_t writtenNs) {
+    written_.push_back({ writtenNs, level });
+}
+
+/**
+ * Captured edges must be checked in the order they have been captured. A
+ * matching written edge is consumed, as it is echoed only once.
+ *
+ * @param edge Captured edge.
+ * @return True if the edge is an echo and must not be repeated, false
+ *         otherwise.
+ */
+bool EchoFilter::isEcho(const EdgeQueue::Edge & edge) {
+    // Forget written edges whose echo would have been captured already
+    while (!written_.empty()
+            && (written_.front().timeNs + windowNs_ < edge.timeNs)) {
+        written_.pop_front();
+    }
+
+    for (auto written = written_.begin(); (written != written_.end())
+            && (written->timeNs <= edge.timeNs); written++) {
+        if (written->level == edge.level) {
+            written_.erase(written);
+            return true;
+        }
+    }
+
+    return false;
+}
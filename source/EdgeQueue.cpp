@@ -0,0 +1,43 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "EdgeQueue.h"
+
+/**
+ * @brief Round the given capacity up to the next power of two.
+ * @param capacity Requested capacity, must be >0.
+ * @return Power of two not smaller than the requested capacity.
+ */
+static size_t roundCapacity(const size_t capacity) {
+    size_t rounded = 1U;
+
+    while (rounded < capacity) {
+        rounded <<= 1U;
+    }
+
+    return rounded;
+}
+
+/// @param capacity Minimum number of edges, rounded up to a power of two.
+EdgeQueue::EdgeQueue(const size_t capacity) :
+        edges_(roundCapacity(capacity)),
+        mask_(edges_.size() - 1U),
+        head_(0U),
+        tail_(0U) {
+    // Do nothing
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "Embedded.h"
+
+#ifdef EMBED_TARGETS
+#include "EmbeddedTargets.h"
+#endif
+
+/**
+ * @param name Target name.
+ * @return Embedded target or nullptr if the target has not been embedded.
+ */
+const Embedded::Target * Embedded::find(const std::string & name) {
+#ifdef EMBED_TARGETS
+    // The generated targets are sorted by name
+    const auto target = std::lower_bound(std::begin(EmbeddedTargets::TARGETS),
+        std::end(EmbeddedTargets::TARGETS), name.c_str(),
+        [](const Target & target, const char * name) {
+            return strcmp(target.name, name) < 0;
+        });
+    if ((target != std::end(EmbeddedTargets::TARGETS))
+            && (strcmp(target->name, name.c_str()) == 0)) {
+        return target;
+    }
+#else
+    (void)name;
+#endif
+
+    return nullptr;
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <sstream>
+
+#include "Encoder.h"
+
+constexpr uint32_t Encoder::MAX_ELEMENT_PULSES;
+constexpr uint32_t Encoder::MAX_STEP_FRACTION;
+constexpr Encoder::Symbol Encoder::MANCHESTER[];
+constexpr Encoder::Symbol Encoder::REMOTE_CONTROLLED_OUTLET[];
+constexpr Encoder::Symbol Encoder::TORMATIC[];
+constexpr Encoder::Symbol Encoder::MELITEC[];
+constexpr Encoder::Encoding Encoder::BUILT_IN[];
+
+/**
+ * @param encoding Radio frame encoding.
+ * @return All element characters defined by the encoding.
+ */
+std::string Encoder::getElements(const Encoding & encoding) {
+    std::string elements;
+
+    for (uint32_t i = 0U; i < encoding.symbolCount; i++) {
+        elements += encoding.symbols[i].element;
+    }
+
+    return elements;
+}
+
+/**
+ * Syntax of an element definition: "<element>: <step> [<step> ...]" whereas
+ * every step consists of the signal level (H or L), the fraction of the base
+ * length (e.g. 1/3 or 1) and an optional suffix 's' selecting the sync length
+ * instead of the data length as base length. Example: "1: H3/4 L1/4"
+ *
+ * @param definition Element definition.
+ * @param symbol Place to store the parsed definition to.
+ * @param error Place to store an error description to.
+ * @return True if successful, false otherwise.
+ */
+bool Encoder::parseSymbol(const std::string & definition, Symbol & symbol,
+        std::string & error) {
+    symbol = {};
+
+    if ((definition.length() < 2U) || (definition.at(1) != ':')) {
+        error = "element definition '" + definition + "' must start with "
+            "'<element>:'";
+        return false;
+    }
+    symbol.element = definition.at(0);
+
+    std::istringstream steps(definition.substr(2U));
+    std::string token;
+    while (steps >> token) {
+        Step step = {};
+        const char * position = token.c_str();
+        char * end;
+
+        if (symbol.stepCount == MAX_ELEMENT_PULSES) {
+            error = "element '" + std::string(1, symbol.element) + "' has "
+                "more than " + std::to_string(MAX_ELEMENT_PULSES) + " steps";
+            return false;
+        }
+
+        // Signal level
+        if ((*position != 'H') && (*position != 'L')) {
+            error = "step '" + token + "' must start with H or L";
+            return false;
+        }
+        step.level = (*position == 'H') ? 1U : 0U;
+        position++;
+
+        // Fraction of the base length
+        step.numerator = strtoul(position, &end, 10);
+        step.denominator = 1U;
+        if (*end == '/') {
+            position = end + 1;
+            step.denominator = strtoul(position, &end, 10);
+        }
+        if ((end == position) || (step.numerator == 0U)
+                || (step.denominator == 0U)
+                || (step.numerator
+                    > (MAX_STEP_FRACTION * step.denominator))) {
+            error = "step '" + token + "' has an invalid fraction";
+            return false;
+        }
+
+        // Base length
+        step.base = DATA_LENGTH;
+        if (*end == 's') {
+            step.base = SYNC_LENGTH;
+            end++;
+        }
+        if (*end != '\0') {
+            error = "step '" + token + "' has trailing characters";
+            return false;
+        }
+
+        symbol.steps[symbol.stepCount++] = step;
+    }
+
+    if (symbol.stepCount == 0U) {
+        error = "element '" + std::string(1, symbol.element) + "' has no "
+            "steps";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @param encoding Radio frame encoding.
+ * @param airCommand Sequence of data and sync elements, must be valid for the
+ *                   given encoding.
+ * @param dataLengthUs Pulse length of a single data element (unit:
+ *                     microseconds).
+ * @param syncLengthUs Pulse length of a single sync element (unit:
+ *                     microseconds).
+ * @return Pulse train of a single air command transmission.
+ */
+std::vector<Types::Pulse> Encoder::encode(const Encoding & encoding,
+        const std::string & airCommand, const int32_t dataLengthUs,
+        const int32_t syncLengthUs) {
+    std::vector<Types::Pulse> pulses;
+    double carryNs = 0.0;
+
+    pulses.reserve(airCommand.length() * 2U);
+    for (const char element : airCommand) {
+        const Element encoded = encodeElement(encoding, element, dataLengthUs,
+            syncLengthUs, carryNs);
+        pulses.insert(pulses.end(), encoded.pulses,
+            encoded.pulses + encoded.count);
+    }
+
+    return pulses;
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EncodingIndex.h"
+
+/// @param configuration Reference of the configuration.
+EncodingIndex::EncodingIndex(const Configuration & configuration) :
+        configuration_(configuration),
+        symbols_(),
+        encodings_(),
+        errors_() {
+    // Do nothing
+}
+
+void EncodingIndex::build(void) {
+    symbols_.clear();
+    encodings_.clear();
+    errors_.clear();
+
+    const libconfig::Setting * section = configuration_.getSection(
+        "encodings");
+    if (section == nullptr) {
+        return;
+    }
+
+    for (auto i = 0; i < section->getLength(); i++) {
+        const libconfig::Setting & setting = (*section)[i];
+        const std::string name = setting.getName();
+        std::vector<Encoder::Symbol> symbols;
+        std::string error;
+        std::string unused;
+
+        if (find(name, unused) != nullptr) {
+            errors_[name] = "encoding '" + name + "' is already defined";
+        } else if (!parse(setting, symbols, error)) {
+            errors_[name] = "encoding '" + name + "' is invalid: " + error;
+        } else {
+            // The element definitions must not be touched afterwards
+            std::vector<Encoder::Symbol> & stored = symbols_[name];
+            stored = std::move(symbols);
+            const auto encoding = encodings_.emplace(name, Encoder::Encoding());
+            encoding.first->second = { encoding.first->first.c_str(),
+                stored.data(), static_cast<uint32_t>(stored.size()) };
+        }
+    }
+}
+
+/**
+ * @param name Name of a built-in or user-defined encoding.
+ * @param error Place to store an error description to.
+ * @return Encoding or nullptr if the encoding is unknown or invalid.
+ */
+const Encoder::Encoding * EncodingIndex::find(const std::string & name,
+        std::string & error) const {
+    for (auto airCode = 0; airCode < Types::AirCode::MAX; airCode++) {
+        const Encoder::Encoding & encoding = Encoder::getBuiltIn(
+            static_cast<Types::AirCode::AirCode_>(airCode));
+        if (name == encoding.name) {
+            return &encoding;
+        }
+    }
+
+    const auto encoding = encodings_.find(name);
+    if (encoding != encodings_.end()) {
+        return &encoding->second;
+    }
+
+    const auto encodingError = errors_.find(name);
+    if (encodingError != errors_.end()) {
+        error = encodingError->second;
+    } else {
+        error = "encoding '" + name + "' is unknown";
+    }
+
+    return nullptr;
+}
+
+/**
+ * @param setting Configuration setting holding the element definitions.
+ * @param symbols Place to store the element definitions to.
+ * @param error Place to store an error description to.
+ * @return True if successful, false otherwise.
+ */
+bool EncodingIndex::parse(const libconfig::Setting & setting,
+        std::vector<Encoder::Symbol> & symbols, std::string & error) const {
+    if ((!setting.isList() && !setting.isArray())
+            || (setting.getLength() == 0)) {
+        error = "list of element definitions expected";
+        return false;
+    }
+
+    for (auto i = 0; i < setting.getLength(); i++) {
+        Encoder::Symbol symbol;
+
+        if (!setting[i].isString()) {
+            error = "element definitions must be strings";
+            return false;
+        }
+        if (!Encoder::parseSymbol(setting[i].c_str(), symbol, error)) {
+            return false;
+        }
+
+        for (const Encoder::Symbol & defined : symbols) {
+            if (defined.element == symbol.element) {
+                error = "element '" + std::string(1, symbol.element)
+                    + "' is defined twice";
+                return false;
+            }
+        }
+        symbols.push_back(symbol);
+    }
+
+    return true;
+}
@@ -0,0 +1,325 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+#include "FrameArchive.h"
+#include "TargetCache.h"
+
+/// @param location Location of the archive file.
+FrameArchive::FrameArchive(const std::string & location) :
+        location_(location),
+        data_(nullptr),
+        size_(0U) {
+    // Do nothing
+}
+
+FrameArchive::~FrameArchive(void) {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t *>(data_), size_);
+    }
+}
+
+/**
+ * Replay files naming an existing file are never split, this way dump files
+ * containing the separator can still be replayed.
+ *
+ * @param file Replay file, either a dump file or 'archive:name'.
+ * @param location Place to store the archive location to.
+ * @param name Place to store the frame name to.
+ * @return True if the replay file refers to an archived frame, false
+ *         otherwise.
+ */
+bool FrameArchive::split(const std::string & file, std::string & location,
+        std::string & name) {
+    const size_t separator = file.rfind(SEPARATOR);
+
+    if ((separator == std::string::npos) || (separator == 0U)
+            || (separator + 1U == file.length())
+            || (access(file.c_str(), F_OK) == 0)) {
+        return false;
+    }
+    location = file.substr(0U, separator);
+    name = file.substr(separator + 1U);
+
+    return true;
+}
+
+/// @return True if the archive file has been mapped, false otherwise.
+bool FrameArchive::open(void) {
+    if (data_ != nullptr) {
+        return true;
+    }
+
+    const int fd = ::open(location_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Error: Frame archive '" << location_ << "' cannot be "
+            "opened for reading: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if ((fstat(fd, &status) != 0)
+            || (static_cast<size_t>(status.st_size) < sizeof(Header))) {
+        close(fd);
+        std::cerr << "Error: Given file is not a frame archive (too short)"
+            << std::endl;
+        return false;
+    }
+
+    void * data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd,
+        0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: Frame archive '" << location_ << "' cannot be "
+            "mapped: " << strerror(errno) << std::endl;
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(data);
+    size_ = status.st_size;
+
+    Header header;
+    memcpy(&header, data_, sizeof(header));
+    const uint64_t tableSize = sizeof(Header)
+        + uint64_t(header.bucketCount) * sizeof(uint32_t)
+        + uint64_t(header.recordCount) * sizeof(Record);
+    if ((header.signature != SIGNATURE) || (header.version != VERSION)
+            || (header.bucketCount == 0U)
+            || ((header.bucketCount & (header.bucketCount - 1U)) != 0U)
+            || (header.recordCount >= header.bucketCount)
+            || !isValidRange(0U, tableSize)) {
+        std::cerr << "Error: Given file is not a frame archive (signature or "
+            "version mismatch)" << std::endl;
+        munmap(data, size_);
+        data_ = nullptr;
+        size_ = 0U;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @param name Frame name.
+ * @param frame Frame to be set, its samples point into the mapped archive and
+ *              stay valid as long as the archive instance.
+ * @return True if the frame has been found, false otherwise.
+ */
+bool FrameArchive::find(const std::string & name, Frame & frame) const {
+    Header header;
+
+    if (data_ == nullptr) {
+        return false;
+    }
+    memcpy(&header, data_, sizeof(header));
+
+    const uint8_t * buckets = data_ + sizeof(Header);
+    const uint64_t nameHash = TargetCache::hash(name.data(), name.length());
+
+    // Linear probing, the table always contains empty buckets
+    for (uint32_t probe = 0U; probe < header.bucketCount; probe++) {
+        const uint32_t bucket = (nameHash + probe)
+            & (header.bucketCount - 1U);
+        uint32_t slot;
+        memcpy(&slot, buckets + bucket * sizeof(slot), sizeof(slot));
+
+        Record record;
+        if ((slot == 0U) || !getRecord(slot - 1U, record)) {
+            return false;
+        }
+        if ((record.nameHash != nameHash)
+                || (record.nameLength != name.length())
+                || (memcmp(data_ + record.nameOffset, name.data(),
+                    name.length()) != 0)) {
+            continue;
+        }
+
+        frame.samples = data_ + record.samplesOffset;
+        frame.sampleCount = record.sampleCount;
+        frame.samplingRateUs = record.samplingRateUs;
+
+        return true;
+    }
+
+    return false;
+}
+
+/// @return Names of all frames in ascending order.
+std::vector<std::string> FrameArchive::getNames(void) const {
+    std::vector<std::string> names;
+    Header header;
+
+    if (data_ == nullptr) {
+        return names;
+    }
+    memcpy(&header, data_, sizeof(header));
+
+    names.reserve(header.recordCount);
+    for (uint32_t i = 0U; i < header.recordCount; i++) {
+        Record record;
+        if (getRecord(i, record)) {
+            names.emplace_back(reinterpret_cast<const char *>(data_)
+                + record.nameOffset, record.nameLength);
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    return names;
+}
+
+/**
+ * The archive file is written to a temporary file first and renamed
+ * afterwards, this way concurrent replays never map a partially written
+ * archive. Frames may refer to the samples of the mapped archive itself.
+ *
+ * @param frames Frames to be archived, indexed by name.
+ * @return True if successful, false otherwise.
+ */
+bool FrameArchive::write(const std::map<std::string, Frame> & frames) const {
+    Header header = {};
+    header.signature = SIGNATURE;
+    header.version = VERSION;
+    header.recordCount = frames.size();
+    header.bucketCount = 1U;
+    while (header.bucketCount < header.recordCount * 2U) {
+        header.bucketCount *= 2U;
+    }
+
+    std::vector<uint32_t> buckets(header.bucketCount, 0U);
+    std::vector<Record> records;
+    std::string strings;
+    const size_t stringsOffset = sizeof(Header)
+        + header.bucketCount * sizeof(uint32_t)
+        + header.recordCount * sizeof(Record);
+
+    // Store identical samples only once, indexed by their content hash
+    std::unordered_multimap<uint64_t, const Record *> stored;
+    records.reserve(frames.size());
+    for (const auto & frame : frames) {
+        const std::string & name = frame.first;
+        const Frame & samples = frame.second;
+        Record record = {};
+
+        record.nameHash = TargetCache::hash(name.data(), name.length());
+        record.nameOffset = stringsOffset + strings.length();
+        record.nameLength = name.length();
+        strings.append(name);
+        record.sampleCount = samples.sampleCount;
+        record.samplingRateUs = samples.samplingRateUs;
+
+        const uint64_t samplesHash = TargetCache::hash(samples.samples,
+            samples.sampleCount);
+        const auto range = stored.equal_range(samplesHash);
+        const auto duplicate = std::find_if(range.first, range.second,
+            [&](const std::pair<const uint64_t, const Record *> & entry) {
+                return (entry.second->sampleCount == samples.sampleCount)
+                    && (memcmp(strings.data() + entry.second->samplesOffset
+                        - stringsOffset, samples.samples,
+                        samples.sampleCount) == 0);
+            });
+        if (duplicate != range.second) {
+            record.samplesOffset = duplicate->second->samplesOffset;
+        } else {
+            record.samplesOffset = stringsOffset + strings.length();
+            strings.append(reinterpret_cast<const char *>(samples.samples),
+                samples.sampleCount);
+        }
+        records.push_back(record);
+        if (duplicate == range.second) {
+            stored.emplace(samplesHash, &records.back());
+        }
+
+        uint32_t bucket = record.nameHash & (header.bucketCount - 1U);
+        while (buckets[bucket] != 0U) {
+            bucket = (bucket + 1U) & (header.bucketCount - 1U);
+        }
+        buckets[bucket] = records.size();
+    }
+
+    // Write the archive file
+    const std::string temporaryLocation = location_ + "."
+        + std::to_string(getpid());
+    std::ofstream archiveFile(temporaryLocation, std::ios::out
+        | std::ios::binary | std::ios::trunc);
+    if (!archiveFile.is_open()) {
+        std::cerr << "Error: Frame archive '" << temporaryLocation << "' "
+            "cannot be opened for writing: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    archiveFile.write(reinterpret_cast<const char *>(&header),
+        sizeof(header));
+    archiveFile.write(reinterpret_cast<const char *>(buckets.data()),
+        buckets.size() * sizeof(uint32_t));
+    archiveFile.write(reinterpret_cast<const char *>(records.data()),
+        records.size() * sizeof(Record));
+    archiveFile.write(strings.data(), strings.length());
+    archiveFile.close();
+
+    if (!archiveFile || (rename(temporaryLocation.c_str(), location_.c_str())
+            != 0)) {
+        std::cerr << "Error: Frame archive '" << location_ << "' cannot be "
+            "written: " << strerror(errno) << std::endl;
+        unlink(temporaryLocation.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @param index Index of the record.
+ * @param record Record to be set.
+ * @return True if the record and the ranges it refers to are valid, false
+ *         otherwise.
+ */
+bool FrameArchive::getRecord(const uint32_t index, Record & record) const {
+    Header header;
+    memcpy(&header, data_, sizeof(header));
+
+    if (index >= header.recordCount) {
+        return false;
+    }
+    memcpy(&record, data_ + sizeof(Header)
+        + header.bucketCount * sizeof(uint32_t) + index * sizeof(Record),
+        sizeof(record));
+
+    return isValidRange(record.nameOffset, record.nameLength)
+        && isValidRange(record.samplesOffset, record.sampleCount)
+        && (record.samplingRateUs > 0);
+}
+
+/**
+ * @param offset File offset of the range.
+ * @param length Length of the range.
+ * @return True if the range lies within the archive file, false otherwise.
+ */
+bool FrameArchive::isValidRange(const uint64_t offset,
+        const uint64_t length) const {
+    return (offset <= size_) && (length <= size_ - offset);
+}
@@ -17,48 +17,146 @@
  * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <sys/file.h>
+#include <fcntl.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <cerrno>
 #include <iostream>
 
+#include "Clock.h"
 #include "InstanceLock.h"
+#include "Metrics.h"
+#include "Trace.h"
 
-const std::string InstanceLock::LOCK_FILE = "/tmp/aircontrol.lock";
+const std::string InstanceLock::LOCK_FILE_PREFIX = "/tmp/aircontrol-gpio";
 
-void InstanceLock::lock(void) {
-    struct flock lock;
-    int fd;
+const off_t InstanceLock::TICKET_OFFSET = sizeof(uint64_t);
 
-    lock.l_type = F_WRLCK;
-    lock.l_whence = SEEK_SET;
-    lock.l_start = 0;
-    lock.l_len = 0;
+std::map<uint8_t, int> InstanceLock::lockFiles_;
+
+/**
+ * @param gpioPin GPIO pin to be locked.
+ * @return True if the lock has been acquired, false otherwise.
+ */
+bool InstanceLock::lock(const uint8_t gpioPin) {
+    const std::string lockFile = LOCK_FILE_PREFIX + std::to_string(gpioPin)
+        + ".lock";
+
+    if (lockFiles_.count(gpioPin) != 0U) {
+        return true;
+    }
 
     // Try to create the lock file
-    fd = open(LOCK_FILE.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+    const int fd = open(lockFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+        S_IRUSR | S_IWUSR);
     if (fd < 0) {
-        std::cerr << "Unable to create lock file (" << LOCK_FILE << ")."
-            << std::endl;
-        exit(EXIT_FAILURE);
+        std::cerr << "Error: Unable to create lock file (" << lockFile << "): "
+            << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Draw a ticket and occupy its byte while the counter is locked, this way
+    // all successors are guaranteed to find the byte locked
+    uint64_t ticket = 0U;
+    if (!setLock(fd, F_WRLCK, 0, sizeof(ticket), true)) {
+        close(fd);
+        return false;
+    }
+    if (pread(fd, &ticket, sizeof(ticket), 0) != sizeof(ticket)) {
+        ticket = 0U;
+    }
+    const uint64_t nextTicket = ticket + 1U;
+    const bool isTicketValid = (pwrite(fd, &nextTicket, sizeof(nextTicket), 0)
+            == sizeof(nextTicket))
+        && setLock(fd, F_WRLCK, TICKET_OFFSET + ticket, 1, false);
+    setLock(fd, F_UNLCK, 0, sizeof(ticket), false);
+    if (!isTicketValid) {
+        std::cerr << "Error: Unable to draw ticket from lock file ("
+            << lockFile << "): " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
     }
 
-    // Try to acquire the lock
-    if (fcntl(fd, F_SETLK, &lock) < 0) {
-        std::cout << "Another instance of this program is running, waiting..."
-            << std::endl;
+    // Wait for all predecessors to release the GPIO pin, waiting for the
+    // direct predecessor only would let a successor of a terminated waiter
+    // acquire the pin while it is still in use
+    int64_t waitNs = 0;
+    if ((ticket > 0U)
+            && !setLock(fd, F_RDLCK, TICKET_OFFSET, ticket, false)) {
+        std::cout << "GPIO pin " << +gpioPin << " is used by another instance "
+            "of this program, waiting..." << std::endl;
 
-        while (fcntl(fd, F_SETLK, &lock) < 0) {
-            usleep(100*1000);
+        const int64_t beginNs = Clock::now();
+        if (!setLock(fd, F_RDLCK, TICKET_OFFSET, ticket, true)) {
+            close(fd);
+            return false;
         }
+        const int64_t endNs = Clock::now();
+        waitNs = endNs - beginNs;
+        Trace::span("lock wait", beginNs, endNs, "gpioPin", gpioPin);
+
+        std::cout << "GPIO pin " << +gpioPin << " acquired after waiting "
+            << waitNs / 1000000 << "ms" << std::endl;
+    }
+    if (ticket > 0U) {
+        setLock(fd, F_UNLCK, TICKET_OFFSET, ticket, false);
+    }
+    Metrics::addLockWait(waitNs);
+
+    // The lock is released when the file is closed, at the latest upon
+    // program termination
+    lockFiles_[gpioPin] = fd;
+
+    return true;
+}
+
+/// @param gpioPin GPIO pin to be unlocked.
+void InstanceLock::unlock(const uint8_t gpioPin) {
+    const auto lockFile = lockFiles_.find(gpioPin);
+
+    if (lockFile != lockFiles_.end()) {
+        close(lockFile->second);
+        lockFiles_.erase(lockFile);
     }
+}
 
-    // Ensure the lock gets released upon program termination
-    atexit(unlock);
+void InstanceLock::unlockAll(void) {
+    for (const auto & lockFile : lockFiles_) {
+        close(lockFile.second);
+    }
+    lockFiles_.clear();
 }
 
-void InstanceLock::unlock(void) {
-    unlink(LOCK_FILE.c_str());
+/**
+ * @param fd Lock file descriptor.
+ * @param type Lock type (F_RDLCK, F_WRLCK or F_UNLCK).
+ * @param start Offset of the first byte to be locked.
+ * @param length Number of bytes to be locked.
+ * @param wait True to block until the lock can be applied.
+ * @return True if the lock has been applied, false otherwise.
+ */
+bool InstanceLock::setLock(const int fd, const short type, const off_t start,
+        const off_t length, const bool wait) {
+    struct flock lock;
+
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = start;
+    lock.l_len = length;
+
+    while (fcntl(fd, wait ? F_OFD_SETLKW : F_OFD_SETLK, &lock) < 0) {
+        if (!wait || (errno != EINTR)) {
+            if (wait) {
+                std::cerr << "Error: Unable to lock GPIO pin: "
+                    << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+    }
+
+    return true;
 }
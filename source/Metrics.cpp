@@ -0,0 +1,385 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Clock.h"
+#include "Metrics.h"
+
+const char * const Metrics::STATE_FILE = "/tmp/aircontrol-metrics.v4";
+
+const int64_t Metrics::DURATION_BOUNDS_NS[DURATION_BUCKETS] = {
+    1000000, 10000000, 100000000, 1000000000, 10000000000, 60000000000
+};
+
+const Metrics::TargetFamily Metrics::TARGET_FAMILIES[TARGET_FAMILY_COUNT] = {
+    { "aircontrol_transmissions_total", "Number of target transmissions.",
+        &Target::transmissions, false },
+    { "aircontrol_frames_total", "Number of radio frames sent per target.",
+        &Target::frames, false },
+    { "aircontrol_bad_frames_total", "Number of radio frames exceeding the "
+        "frame tolerance per target.", &Target::badFrames, false },
+    { "aircontrol_retransmissions_total", "Number of radio frames "
+        "retransmitted per target.", &Target::retransmissions, false },
+    { "aircontrol_missed_deadlines_total", "Number of pulses ending before "
+        "they have been started.", &Target::missedDeadlines, false },
+    { "aircontrol_backoffs_total", "Number of radio frames postponed for a "
+        "busy channel per target.", &Target::backoffs, false },
+    { "aircontrol_busy_frames_total", "Number of radio frames sent into a "
+        "busy channel per target.", &Target::busyFrames, false },
+    { "aircontrol_transmit_seconds_total", "Time spent transmitting per "
+        "target.", &Target::durationNs, true }
+};
+
+Metrics::State * Metrics::state_ = nullptr;
+
+std::string Metrics::file_;
+
+/**
+ * Failures are reported but do not prevent the task from being executed.
+ *
+ * @param file File to export the metrics to, e.g. within the directory of
+ *             the node exporter textfile collector.
+ * @return True if metrics have been enabled, false otherwise.
+ */
+bool Metrics::enable(const std::string & file) {
+    if (state_ != nullptr) {
+        file_ = file;
+        return true;
+    }
+
+    // Counters are shared through memory, this requires lock-free atomics
+    if (!Counter().is_lock_free()) {
+        std::cerr << "Error: Metrics are not supported on this platform "
+            "(no lock-free 64 bit atomics)" << std::endl;
+        return false;
+    }
+
+    const int fd = open(STATE_FILE, O_RDWR | O_CREAT | O_CLOEXEC,
+        S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        std::cerr << "Error: Unable to open metrics state file ("
+            << STATE_FILE << "): " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A new state file is zero filled, concurrent instances extend it to the
+    // same size
+    struct stat status;
+    if ((fstat(fd, &status) != 0) || ((static_cast<size_t>(status.st_size)
+            < sizeof(State)) && (ftruncate(fd, sizeof(State)) != 0))) {
+        std::cerr << "Error: Unable to initialize metrics state file ("
+            << STATE_FILE << "): " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void * data = mmap(nullptr, sizeof(State), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Error: Unable to map metrics state file ("
+            << STATE_FILE << "): " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    state_ = static_cast<State *>(data);
+    file_ = file;
+
+    return true;
+}
+
+/**
+ * @param target Target name.
+ * @param statistics Statistics of the transmission.
+ * @param durationNs Duration of the transmission (unit: nanoseconds).
+ */
+void Metrics::addTransmission(const std::string & target,
+        const Transmitter::Statistics & statistics, const int64_t durationNs) {
+    Target * metrics = findTarget(target);
+    if (metrics == nullptr) {
+        return;
+    }
+    observe(state_->transmissions, durationNs);
+
+    metrics->transmissions.fetch_add(1U, std::memory_order_relaxed);
+    metrics->frames.fetch_add(statistics.frames, std::memory_order_relaxed);
+    metrics->badFrames.fetch_add(statistics.badFrames,
+        std::memory_order_relaxed);
+    metrics->retransmissions.fetch_add(statistics.retransmissions,
+        std::memory_order_relaxed);
+    metrics->missedDeadlines.fetch_add(statistics.missedDeadlines,
+        std::memory_order_relaxed);
+    metrics->backoffs.fetch_add(statistics.backoffs,
+        std::memory_order_relaxed);
+    metrics->busyFrames.fetch_add(statistics.busyFrames,
+        std::memory_order_relaxed);
+    metrics->durationNs.fetch_add(durationNs, std::memory_order_relaxed);
+}
+
+/**
+ * @param samples Number of replayed samples.
+ * @param missedDeadlines Number of missed deadlines.
+ * @param durationNs Duration of the replay (unit: nanoseconds).
+ */
+void Metrics::addReplay(const uint64_t samples,
+        const uint32_t missedDeadlines, const int64_t durationNs) {
+    if (state_ == nullptr) {
+        return;
+    }
+
+    observe(state_->replays, durationNs);
+    state_->replaySamples.fetch_add(samples, std::memory_order_relaxed);
+    state_->replayMissedDeadlines.fetch_add(missedDeadlines,
+        std::memory_order_relaxed);
+}
+
+/**
+ * @param samples Number of scanned samples.
+ * @param durationNs Duration of the air scan (unit: nanoseconds).
+ */
+void Metrics::addScan(const uint64_t samples, const int64_t durationNs) {
+    if (state_ == nullptr) {
+        return;
+    }
+
+    observe(state_->scans, durationNs);
+    state_->scanSamples.fetch_add(samples, std::memory_order_relaxed);
+}
+
+/// @param waitNs Time spent waiting (unit: nanoseconds).
+void Metrics::addLockWait(const int64_t waitNs) {
+    if (state_ == nullptr) {
+        return;
+    }
+
+    observe(state_->lockWaits, waitNs);
+}
+
+/**
+ * The metrics are written to a temporary file first and renamed afterwards,
+ * this way readers never see a partially written file.
+ *
+ * @return True if successful or metrics are disabled, false otherwise.
+ */
+bool Metrics::write(void) {
+    if (state_ == nullptr) {
+        return true;
+    }
+
+    const double NS_PER_S = Clock::NS_PER_S;
+    const std::memory_order relaxed = std::memory_order_relaxed;
+    std::ostringstream metrics;
+
+    // Targets
+    for (const TargetFamily & family : TARGET_FAMILIES) {
+        metrics << "# HELP " << family.name << " " << family.help
+            << std::endl
+            << "# TYPE " << family.name << " counter" << std::endl;
+        for (const Target & target : state_->targets) {
+            if (target.isNamed.load(std::memory_order_acquire) == 0U) {
+                continue;
+            }
+            const uint64_t value = (target.*family.counter).load(relaxed);
+            metrics << family.name << "{target=\"" << escape(target.name)
+                << "\"} ";
+            if (family.isDuration) {
+                metrics << value / NS_PER_S;
+            } else {
+                metrics << value;
+            }
+            metrics << std::endl;
+        }
+    }
+    writeHistogram(metrics, "aircontrol_transmission_seconds", "Duration of "
+        "the target transmissions.", state_->transmissions);
+
+    // Replays
+    writeHistogram(metrics, "aircontrol_replay_seconds", "Duration of the air "
+        "scan replays.", state_->replays);
+    metrics << "# HELP aircontrol_replay_samples_total Number of replayed "
+        "samples." << std::endl
+        << "# TYPE aircontrol_replay_samples_total counter" << std::endl
+        << "aircontrol_replay_samples_total "
+        << state_->replaySamples.load(relaxed) << std::endl
+        << "# HELP aircontrol_replay_missed_deadlines_total Number of samples "
+        "ending before they have been started." << std::endl
+        << "# TYPE aircontrol_replay_missed_deadlines_total counter"
+        << std::endl
+        << "aircontrol_replay_missed_deadlines_total "
+        << state_->replayMissedDeadlines.load(relaxed) << std::endl;
+
+    // Scans
+    writeHistogram(metrics, "aircontrol_scan_seconds", "Duration of the air "
+        "scans.", state_->scans);
+    metrics << "# HELP aircontrol_scan_samples_total Number of scanned samples."
+        << std::endl
+        << "# TYPE aircontrol_scan_samples_total counter" << std::endl
+        << "aircontrol_scan_samples_total "
+        << state_->scanSamples.load(relaxed) << std::endl;
+
+    // Lock waits
+    writeHistogram(metrics, "aircontrol_lock_wait_seconds", "Time spent "
+        "waiting for the instance lock.", state_->lockWaits);
+
+    // Write the export file
+    const std::string temporaryFile = file_ + "." + std::to_string(getpid());
+    std::ofstream exportFile(temporaryFile, std::ios::out | std::ios::trunc);
+    if (!exportFile.is_open()) {
+        std::cerr << "Error: Unable to open metrics file (" << temporaryFile
+            << "): " << strerror(errno) << std::endl;
+        return false;
+    }
+    exportFile << metrics.str();
+    exportFile.close();
+    if (!exportFile) {
+        std::cerr << "Error: Unable to write metrics file (" << temporaryFile
+            << ")" << std::endl;
+        unlink(temporaryFile.c_str());
+        return false;
+    }
+    if (rename(temporaryFile.c_str(), file_.c_str()) != 0) {
+        const int error = errno;
+        unlink(temporaryFile.c_str());
+        std::cerr << "Error: Unable to write metrics file (" << file_
+            << "): " << strerror(error) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Slots are claimed by the first instance accounting a target. If all slots
+ * are taken the target is not accounted.
+ *
+ * @param name Target name.
+ * @return Metrics of the target, nullptr if unavailable.
+ */
+Metrics::Target * Metrics::findTarget(const std::string & name) {
+    if (state_ == nullptr) {
+        return nullptr;
+    }
+
+    // FNV-1a, 0 marks unused slots
+    uint64_t hash = 0xCBF29CE484222325U;
+    for (const char character : name) {
+        hash = (hash ^ static_cast<uint8_t>(character)) * 0x100000001B3U;
+    }
+    if (hash == 0U) {
+        hash = 1U;
+    }
+
+    for (auto i = 0U; i < MAX_TARGETS; i++) {
+        Target & target = state_->targets[(hash + i) % MAX_TARGETS];
+
+        uint64_t slotHash = target.nameHash.load(std::memory_order_relaxed);
+        if (slotHash == hash) {
+            return &target;
+        }
+        if ((slotHash == 0U) && target.nameHash.compare_exchange_strong(
+                slotHash, hash, std::memory_order_relaxed)) {
+            strncpy(target.name, name.c_str(), MAX_NAME_LENGTH - 1U);
+            target.isNamed.store(1U, std::memory_order_release);
+            return &target;
+        }
+        if (slotHash == hash) {
+            return &target;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @param histogram Histogram to be updated.
+ * @param durationNs Observed duration (unit: nanoseconds).
+ */
+void Metrics::observe(Histogram & histogram, const int64_t durationNs) {
+    size_t bucket = 0U;
+    while ((bucket < DURATION_BUCKETS)
+            && (durationNs > DURATION_BOUNDS_NS[bucket])) {
+        bucket++;
+    }
+
+    histogram.buckets[bucket].fetch_add(1U, std::memory_order_relaxed);
+    histogram.sumNs.fetch_add(durationNs, std::memory_order_relaxed);
+}
+
+/**
+ * Histogram buckets are cumulative in the Prometheus text format.
+ *
+ * @param metrics Stream to write the histogram to.
+ * @param name Metric name.
+ * @param help Help text.
+ * @param histogram Histogram to be written.
+ */
+void Metrics::writeHistogram(std::ostream & metrics, const char * name,
+        const char * help, const Histogram & histogram) {
+    const double NS_PER_S = Clock::NS_PER_S;
+    uint64_t count = 0U;
+
+    metrics << "# HELP " << name << " " << help << std::endl
+        << "# TYPE " << name << " histogram" << std::endl;
+    for (auto i = 0U; i <= DURATION_BUCKETS; i++) {
+        count += histogram.buckets[i].load(std::memory_order_relaxed);
+        metrics << name << "_bucket{le=\"";
+        if (i < DURATION_BUCKETS) {
+            metrics << DURATION_BOUNDS_NS[i] / NS_PER_S;
+        } else {
+            metrics << "+Inf";
+        }
+        metrics << "\"} " << count << std::endl;
+    }
+    metrics << name << "_sum "
+        << histogram.sumNs.load(std::memory_order_relaxed) / NS_PER_S
+        << std::endl
+        << name << "_count " << count << std::endl;
+}
+
+/**
+ * @param value Null terminated label value.
+ * @return Label value with backslashes, double quotes and line feeds escaped.
+ */
+std::string Metrics::escape(const char * value) {
+    std::string escaped;
+
+    for (; *value != '\0'; value++) {
+        if (*value == '\n') {
+            escaped += "\\n";
+        } else {
+            if ((*value == '\\') || (*value == '"')) {
+                escaped += '\\';
+            }
+            escaped += *value;
+        }
+    }
+
+    return escaped;
+}
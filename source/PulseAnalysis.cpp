@@ -0,0 +1,561 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+
+#include "PulseAnalysis.h"
+#include "Timings.h"
+#include "Types.h"
+#include "ValueChangeDump.h"
+
+/**
+ * @param a First number.
+ * @param b Second number.
+ * @return Greatest common divisor of both numbers.
+ */
+static uint32_t getGreatestCommonDivisor(uint32_t a, uint32_t b) {
+    while (b != 0U) {
+        const uint32_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+}
+
+/**
+ * @param pulse Pulse the fraction of the step is added to, kept reduced.
+ * @param step Step to be added.
+ */
+static void addFraction(Encoder::Step & pulse, const Encoder::Step & step) {
+    pulse.numerator = pulse.numerator * step.denominator
+        + step.numerator * pulse.denominator;
+    pulse.denominator *= step.denominator;
+
+    const uint32_t divisor = getGreatestCommonDivisor(pulse.numerator,
+        pulse.denominator);
+    pulse.numerator /= divisor;
+    pulse.denominator /= divisor;
+}
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param dumpFile File name of the air scan dump.
+ */
+PulseAnalysis::PulseAnalysis(Configuration & configuration,
+        const std::string & dumpFile) :
+        Task(configuration),
+        dumpFile_(dumpFile),
+        high_(nullptr),
+        low_(nullptr),
+        durationUs_(0U) {
+    // Do nothing
+}
+
+/**
+ * The clusters of both levels and the fits of all built-in encodings are
+ * written to stdout as tab separated values, followed by the settings of the
+ * best fitting encoding.
+ *
+ * @return Program exit code, failure if no encoding fits the pulse widths.
+ */
+int PulseAnalysis::start(void) {
+    std::ifstream dumpFile;
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+
+    dumpFile.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    dumpFile.open(dumpFile_, std::ios::in | std::ios::binary);
+    if (!dumpFile.is_open()) {
+        std::cerr << "Error: Dump file '" << dumpFile_ << "' cannot be opened "
+            "for reading: " << strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!(ValueChangeDump::isValueChangeDump(dumpFile_)
+            ? readEdges(dumpFile) : readSamples(dumpFile))) {
+        return EXIT_FAILURE;
+    }
+    Timings::mark("dump");
+
+    // Consider only clusters holding a noticeable share of their level
+    std::vector<PulseHistogram::Cluster> clusters[2];
+    uint64_t ignored = 0U;
+    double shortestUs = 0.0;
+    for (uint32_t level = 0U; level < 2U; level++) {
+        const PulseHistogram & histogram = (level == 1U) ? *high_ : *low_;
+
+        for (const auto & cluster : histogram.cluster()) {
+            if (cluster.pulses
+                    < MIN_CLUSTER_SHARE * histogram.getPulses()) {
+                ignored += cluster.pulses;
+                continue;
+            }
+            clusters[level].push_back(cluster);
+            if ((shortestUs == 0.0) || (cluster.centerUs < shortestUs)) {
+                shortestUs = cluster.centerUs;
+            }
+        }
+    }
+    if (shortestUs == 0.0) {
+        std::cerr << "Error: Given air scan dump contains no pulses"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "# Duration: " << durationUs_ / 1000U << "ms, bin width "
+        << high_->getBinWidth() << "us, " << high_->getPulses() << " high and "
+        << low_->getPulses() << " low pulses" << std::endl
+        << "# level\tcenterUs\tspreadUs\tpulses\tratio" << std::endl;
+    printClusters("high", clusters[1], shortestUs);
+    printClusters("low", clusters[0], shortestUs);
+    for (const PulseHistogram * histogram : { high_.get(), low_.get() }) {
+        if (histogram->getOverlong() > 0U) {
+            std::cout << "# " << histogram->getOverlong() << " "
+                << ((histogram == high_.get()) ? "high" : "low")
+                << " pulses longer than " << PulseHistogram::BINS
+                * histogram->getBinWidth() << "us (up to "
+                << histogram->getLongest() << "us)" << std::endl;
+        }
+    }
+    if (ignored > 0U) {
+        std::cout << "# " << ignored << " pulses in minor clusters ignored"
+            << std::endl;
+    }
+
+    // Fit the clusters to every built-in encoding, the best fit explains the
+    // most pulse widths with the least deviation
+    std::cout << "# encoding\tdataLengthUs\tsyncLengthUs\tmatched\t"
+        "unexplained\tdeviation" << std::endl;
+    const Encoder::Encoding * bestEncoding = nullptr;
+    Fit best = {};
+    for (auto airCode = 0; airCode < Types::AirCode::MAX; airCode++) {
+        const Encoder::Encoding & encoding = Encoder::getBuiltIn(
+            static_cast<Types::AirCode::AirCode_>(airCode));
+        const Fit result = fit(getWidths(encoding), clusters);
+
+        std::cout << encoding.name << "\t" << result.dataLengthUs << "\t"
+            << result.syncLengthUs << "\t" << result.matched << "/"
+            << result.widths << "\t" << result.unexplained << "\t"
+            << std::fixed << std::setprecision(1) << result.deviation * 100.0
+            << "%" << std::endl;
+
+        const double share = double(result.matched) / result.widths;
+        const double bestShare = (bestEncoding != nullptr)
+            ? double(best.matched) / best.widths : 0.0;
+        if ((result.matched > 0U) && ((bestEncoding == nullptr)
+                || (share > bestShare) || ((share == bestShare)
+                && ((result.unexplained < best.unexplained)
+                || ((result.unexplained == best.unexplained)
+                && (result.deviation < best.deviation)))))) {
+            bestEncoding = &encoding;
+            best = result;
+        }
+    }
+
+    if (bestEncoding == nullptr) {
+        std::cerr << "Error: None of the encodings fits the pulse widths"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Recommended: airCode = \"" << bestEncoding->name
+        << "\"; dataLength = " << best.dataLengthUs << ";";
+    if (best.syncLengthUs > 0) {
+        std::cout << " syncLength = " << best.syncLengthUs << ";";
+    }
+    std::cout << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Format of the stream, see Scan:
+ * - [4 bytes] Signature
+ * - [4 bytes] Sampling rate (unit: microseconds)
+ * - [n bytes] Sample data, 1 byte each, 0=low / 1=high
+ *
+ * The first and the last pulse are incomplete and thus not counted.
+ *
+ * @param stream Stream positioned at the beginning of the dump.
+ * @return True if successful, false otherwise.
+ */
+bool PulseAnalysis::readSamples(std::istream & stream) {
+    uint32_t signature;
+    int32_t samplingRateUs;
+
+    if (!stream.read(reinterpret_cast<char *>(&signature), sizeof(signature))
+            || (signature != Types::DUMP_SIGNATURE)) {
+        std::cerr << "Error: Given file is not an air scan dump (signature "
+            "mismatch)" << std::endl;
+        return false;
+    }
+    if (!stream.read(reinterpret_cast<char *>(&samplingRateUs),
+            sizeof(samplingRateUs)) || (samplingRateUs <= 0)) {
+        std::cerr << "Error: Given air scan dump seems corrupted (invalid "
+            "sampling rate)" << std::endl;
+        return false;
+    }
+    createHistograms(samplingRateUs);
+
+    std::vector<char> block(READ_BUFFER_SIZE);
+    uint64_t samples = 0U;
+    uint64_t runSamples = 0U;
+    bool isFirst = true;
+    char level = 0;
+    while (stream.read(block.data(), block.size()) || (stream.gcount() > 0)) {
+        const size_t count = static_cast<size_t>(stream.gcount());
+
+        for (size_t i = 0U; i < count; i++) {
+            const char data = block[i];
+            if ((data < 0) || (data > 1)) {
+                std::cerr << "Error: Given air scan dump seems corrupted "
+                    "(invalid data value " << +data << ")" << std::endl;
+                return false;
+            }
+
+            if ((runSamples > 0U) && (data != level)) {
+                if (!isFirst) {
+                    ((level == 1) ? high_ : low_)->add(
+                        runSamples * samplingRateUs);
+                }
+                isFirst = false;
+                runSamples = 0U;
+            }
+            level = data;
+            runSamples++;
+        }
+        samples += count;
+    }
+    durationUs_ = samples * samplingRateUs;
+
+    return true;
+}
+
+/**
+ * Only Value Change Dumps with a timescale of 1us are supported, which is
+ * what ValueChangeDump writes. The first signal declared is analyzed, the
+ * histogram bin width is the sampling rate stated by aircontrol.
+ *
+ * @param stream Stream positioned at the beginning of the dump.
+ * @return True if successful, false otherwise.
+ */
+bool PulseAnalysis::readEdges(std::istream & stream) {
+    const std::string SAMPLING_RATE = "sampling rate ";
+    int32_t binWidthUs = DEFAULT_BIN_WIDTH_US;
+    std::string identifier;
+    std::string line;
+
+    // Parse the declarations
+    bool isTimescaleValid = false;
+    while (std::getline(stream, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+
+        if (keyword == "$comment") {
+            const size_t position = line.find(SAMPLING_RATE);
+            if (position != std::string::npos) {
+                binWidthUs = std::max(1, atoi(line.c_str() + position
+                    + SAMPLING_RATE.length()));
+            }
+        } else if (keyword == "$timescale") {
+            std::string value;
+            std::string unit;
+            tokens >> value >> unit;
+            isTimescaleValid = (value == "1us")
+                || ((value == "1") && (unit == "us"));
+        } else if ((keyword == "$var") && identifier.empty()) {
+            std::string type;
+            std::string size;
+            tokens >> type >> size >> identifier;
+        } else if (keyword == "$enddefinitions") {
+            break;
+        }
+    }
+    if (!isTimescaleValid) {
+        std::cerr << "Error: Given Value Change Dump is not supported "
+            "(timescale must be 1 us)" << std::endl;
+        return false;
+    } else if (identifier.empty()) {
+        std::cerr << "Error: Given Value Change Dump declares no signal"
+            << std::endl;
+        return false;
+    }
+    createHistograms(binWidthUs);
+
+    // Count the time between the value changes of the signal
+    uint64_t timeUs = 0U;
+    uint64_t runStartUs = 0U;
+    bool hasLevel = false;
+    bool isFirst = true;
+    bool level = false;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && (line.back() == '\r')) {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        } else if (line[0] == '#') {
+            timeUs = strtoull(line.c_str() + 1, nullptr, 10);
+            continue;
+        } else if (((line[0] != '0') && (line[0] != '1'))
+                || (line.compare(1, std::string::npos, identifier) != 0)) {
+            continue;
+        }
+
+        const bool value = (line[0] == '1');
+        if (hasLevel && (value != level)) {
+            if (!isFirst) {
+                (level ? high_ : low_)->add(timeUs - runStartUs);
+            }
+            isFirst = false;
+        }
+        if (!hasLevel || (value != level)) {
+            runStartUs = timeUs;
+        }
+        level = value;
+        hasLevel = true;
+    }
+    durationUs_ = timeUs;
+
+    return true;
+}
+
+/// @param binWidthUs Width of a single histogram bin (unit: microseconds).
+void PulseAnalysis::createHistograms(const int32_t binWidthUs) {
+    high_ = std::make_unique<PulseHistogram>(binWidthUs);
+    low_ = std::make_unique<PulseHistogram>(binWidthUs);
+}
+
+/**
+ * Adjacent steps of the same level merge into a single pulse on the air, so
+ * the pulse widths are collected from all sequences of three elements,
+ * omitting the first and the last pulse of each sequence. Pulses mixing
+ * data length and sync length steps are omitted as they do not determine
+ * either length.
+ *
+ * @param encoding Radio frame encoding.
+ * @return Distinct pulse widths as fractions of their base length.
+ */
+std::vector<Encoder::Step> PulseAnalysis::getWidths(
+        const Encoder::Encoding & encoding) {
+    std::vector<Encoder::Step> widths;
+    const uint32_t count = encoding.symbolCount;
+
+    for (uint32_t sequence = 0U; sequence < count * count * count;
+            sequence++) {
+        // Merge the steps of the sequence into pulses, summing the fractions
+        // of each base length separately
+        const Encoder::Symbol * symbols[3] = {
+            &encoding.symbols[sequence / (count * count)],
+            &encoding.symbols[(sequence / count) % count],
+            &encoding.symbols[sequence % count] };
+        std::vector<Encoder::Step> dataPulses;
+        std::vector<Encoder::Step> syncPulses;
+        for (const Encoder::Symbol * symbol : symbols) {
+            for (uint32_t i = 0U; i < symbol->stepCount; i++) {
+                const Encoder::Step & step = symbol->steps[i];
+
+                if (dataPulses.empty()
+                        || (dataPulses.back().level != step.level)) {
+                    dataPulses.push_back({ step.level, 0U, 1U,
+                        Encoder::DATA_LENGTH });
+                    syncPulses.push_back({ step.level, 0U, 1U,
+                        Encoder::SYNC_LENGTH });
+                }
+                addFraction((step.base == Encoder::SYNC_LENGTH)
+                    ? syncPulses.back() : dataPulses.back(), step);
+            }
+        }
+
+        // Collect the complete pulses of a single base length
+        for (size_t i = 1U; i + 1U < dataPulses.size(); i++) {
+            const bool isData = (dataPulses[i].numerator > 0U);
+            if (isData == (syncPulses[i].numerator > 0U)) {
+                continue;
+            }
+            const Encoder::Step & width = isData
+                ? dataPulses[i] : syncPulses[i];
+            if (std::none_of(widths.begin(), widths.end(),
+                    [&width](const Encoder::Step & known) {
+                        return (known.level == width.level)
+                            && (known.numerator == width.numerator)
+                            && (known.denominator == width.denominator)
+                            && (known.base == width.base);
+                    })) {
+                widths.push_back(width);
+            }
+        }
+    }
+
+    return widths;
+}
+
+/**
+ * Every cluster is tried as each of the data pulse widths, keeping the data
+ * length matching the most pulse widths with the least deviation. The sync
+ * length is determined the same way from the clusters left unmatched.
+ *
+ * @param widths Pulse widths of the encoding, see getWidths().
+ * @param clusters Clusters of the low and the high pulses.
+ * @return Fit of the best data length and sync length.
+ */
+PulseAnalysis::Fit PulseAnalysis::fit(const std::vector<Encoder::Step> & widths,
+        const std::vector<PulseHistogram::Cluster> (& clusters)[2]) {
+    Fit result = {};
+    std::vector<bool> isMatched[2] = {
+        std::vector<bool>(clusters[0].size(), false),
+        std::vector<bool>(clusters[1].size(), false) };
+    double deviationSum = 0.0;
+
+    result.widths = static_cast<uint32_t>(widths.size());
+    for (const Encoder::Base base : { Encoder::DATA_LENGTH,
+            Encoder::SYNC_LENGTH }) {
+        uint32_t bestMatched = 0U;
+        double bestDeviation = 0.0;
+        double bestLengthUs = 0.0;
+        std::vector<bool> bestIsMatched[2] = { isMatched[0], isMatched[1] };
+
+        for (const Encoder::Step & width : widths) {
+            if (width.base != base) {
+                continue;
+            }
+            const auto & candidates = clusters[width.level];
+            for (size_t i = 0U; i < candidates.size(); i++) {
+                if (isMatched[width.level][i]) {
+                    continue;
+                }
+
+                double lengthUs = candidates[i].centerUs * width.denominator
+                    / width.numerator;
+                std::vector<bool> candidateIsMatched[2] = { isMatched[0],
+                    isMatched[1] };
+                double deviation = 0.0;
+                const uint32_t matched = match(widths, base, lengthUs,
+                    clusters, candidateIsMatched, deviation);
+                if ((matched > bestMatched) || ((matched == bestMatched)
+                        && (deviation < bestDeviation))) {
+                    bestMatched = matched;
+                    bestDeviation = deviation;
+                    bestLengthUs = lengthUs;
+                    bestIsMatched[0] = candidateIsMatched[0];
+                    bestIsMatched[1] = candidateIsMatched[1];
+                }
+            }
+        }
+
+        const int32_t lengthUs = static_cast<int32_t>(bestLengthUs + 0.5);
+        if (base == Encoder::DATA_LENGTH) {
+            result.dataLengthUs = lengthUs;
+        } else {
+            result.syncLengthUs = lengthUs;
+        }
+        result.matched += bestMatched;
+        deviationSum += bestDeviation;
+        isMatched[0] = bestIsMatched[0];
+        isMatched[1] = bestIsMatched[1];
+    }
+
+    for (const auto & level : isMatched) {
+        result.unexplained += static_cast<uint32_t>(
+            std::count(level.begin(), level.end(), false));
+    }
+    result.deviation = (result.matched > 0U)
+        ? deviationSum / result.matched : 0.0;
+
+    return result;
+}
+
+/**
+ * Every pulse width is matched to the nearest cluster of its level.
+ *
+ * @param widths Pulse widths of the encoding, see getWidths().
+ * @param base Base length of the pulse widths to be matched.
+ * @param lengthUs Candidate base length (unit: microseconds), replaced by
+ *                 the least squares estimate of the matched clusters.
+ * @param clusters Clusters of the low and the high pulses.
+ * @param isMatched Flags of the matched clusters of both levels, updated.
+ * @param deviation Sum of the relative deviations of the matched clusters
+ *                  from the candidate base length.
+ * @return Number of matched pulse widths.
+ */
+uint32_t PulseAnalysis::match(const std::vector<Encoder::Step> & widths,
+        const Encoder::Base base, double & lengthUs,
+        const std::vector<PulseHistogram::Cluster> (& clusters)[2],
+        std::vector<bool> (& isMatched)[2], double & deviation) {
+    uint32_t matched = 0U;
+    double centerSum = 0.0;
+    double fractionSum = 0.0;
+
+    for (const Encoder::Step & width : widths) {
+        if (width.base != base) {
+            continue;
+        }
+
+        const double fraction = double(width.numerator) / width.denominator;
+        const double expectedUs = lengthUs * fraction;
+        const auto & candidates = clusters[width.level];
+        size_t nearest = candidates.size();
+        for (size_t i = 0U; i < candidates.size(); i++) {
+            if ((nearest == candidates.size()) || (std::fabs(
+                    candidates[i].centerUs - expectedUs) < std::fabs(
+                    candidates[nearest].centerUs - expectedUs))) {
+                nearest = i;
+            }
+        }
+        if (nearest == candidates.size()) {
+            continue;
+        }
+
+        const double error = std::fabs(candidates[nearest].centerUs
+            - expectedUs) / expectedUs;
+        if (error <= MATCH_TOLERANCE) {
+            matched++;
+            deviation += error;
+            centerSum += candidates[nearest].centerUs * fraction;
+            fractionSum += fraction * fraction;
+            isMatched[width.level][nearest] = true;
+        }
+    }
+    if (matched > 0U) {
+        lengthUs = centerSum / fractionSum;
+    }
+
+    return matched;
+}
+
+/**
+ * @param level Name of the signal level.
+ * @param clusters Clusters of the level.
+ * @param shortestUs Center of the shortest cluster of both levels, the ratio
+ *                   of all clusters is relative to (unit: microseconds).
+ */
+void PulseAnalysis::printClusters(const char * level,
+        const std::vector<PulseHistogram::Cluster> & clusters,
+        const double shortestUs) {
+    for (const auto & cluster : clusters) {
+        std::cout << level << "\t" << std::fixed << std::setprecision(0)
+            << cluster.centerUs << "\t" << cluster.spreadUs << "\t"
+            << cluster.pulses << "\t" << std::setprecision(2)
+            << cluster.centerUs / shortestUs << std::endl;
+    }
+}
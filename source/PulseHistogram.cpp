@@ -0,0 +1,137 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cmath>
+
+#include "PulseHistogram.h"
+
+/// @param binWidthUs Width of a single bin (unit: microseconds), must be >0.
+PulseHistogram::PulseHistogram(const int32_t binWidthUs) :
+        binWidthUs_(static_cast<uint64_t>(binWidthUs)),
+        bins_(BINS, 0U),
+        pulses_(0U),
+        overlong_(0U),
+        longestUs_(0U) {
+    // Do nothing
+}
+
+/**
+ * A valley splits two peaks if it holds at most a quarter of the pulses of
+ * the lower peak. Peaks of fewer than MIN_SPLIT_PULSES pulses are never
+ * split, as their bins are dominated by chance.
+ *
+ * @return Clusters in ascending order of their pulse widths.
+ */
+std::vector<PulseHistogram::Cluster> PulseHistogram::cluster(void) const {
+    const uint64_t MIN_SPLIT_PULSES = 10U;
+    std::vector<Cluster> clusters;
+    uint32_t first = 0U;
+    uint32_t last = 0U;
+    uint32_t peak = 0U;
+    uint32_t valley = 0U;
+    bool isOpen = false;
+
+    for (uint32_t bin = 0U; bin < BINS; bin++) {
+        const uint64_t count = bins_[bin];
+        if (count == 0U) {
+            continue;
+        }
+
+        // Close the cluster if the gap exceeds the jitter of its widths
+        const uint32_t maxGap = std::max(1U,
+            static_cast<uint32_t>(last * MAX_GAP_RATIO));
+        if (isOpen && (bin - last > maxGap)) {
+            clusters.push_back(summarize(first, last));
+            isOpen = false;
+        }
+        if (!isOpen) {
+            first = bin;
+            peak = bin;
+            valley = bin;
+            isOpen = true;
+        } else if ((valley != peak) && (std::min(bins_[peak], count)
+                >= MIN_SPLIT_PULSES) && (bins_[valley]
+                <= VALLEY_RATIO * std::min(bins_[peak], count))) {
+            // Split at the valley between two peaks
+            clusters.push_back(summarize(first, valley));
+            first = valley + 1U;
+            peak = bin;
+            valley = bin;
+        } else if (count > bins_[peak]) {
+            peak = bin;
+            valley = bin;
+        } else if ((valley == peak) || (count < bins_[valley])) {
+            valley = bin;
+        }
+        last = bin;
+    }
+    if (isOpen) {
+        clusters.push_back(summarize(first, last));
+    }
+
+    return clusters;
+}
+
+/// @return Width of a single bin (unit: microseconds).
+int32_t PulseHistogram::getBinWidth(void) const {
+    return static_cast<int32_t>(binWidthUs_);
+}
+
+/// @return Number of pulses added, including the overlong ones.
+uint64_t PulseHistogram::getPulses(void) const {
+    return pulses_;
+}
+
+/// @return Number of pulses exceeding the last bin.
+uint64_t PulseHistogram::getOverlong(void) const {
+    return overlong_;
+}
+
+/**
+ * @return Longest pulse exceeding the last bin (unit: microseconds), 0 if
+ *         there is none.
+ */
+uint64_t PulseHistogram::getLongest(void) const {
+    return longestUs_;
+}
+
+/**
+ * @param first First bin of the cluster.
+ * @param last Last bin of the cluster.
+ * @return Statistics of the pulses of the bins.
+ */
+PulseHistogram::Cluster PulseHistogram::summarize(const uint32_t first,
+        const uint32_t last) const {
+    Cluster cluster = {};
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+
+    for (uint32_t bin = first; bin <= last; bin++) {
+        const double widthUs = static_cast<double>(bin * binWidthUs_);
+
+        cluster.pulses += bins_[bin];
+        sum += bins_[bin] * widthUs;
+        sumOfSquares += bins_[bin] * widthUs * widthUs;
+    }
+    cluster.centerUs = sum / cluster.pulses;
+    cluster.spreadUs = std::sqrt(std::max(0.0, sumOfSquares / cluster.pulses
+        - cluster.centerUs * cluster.centerUs));
+
+    return cluster;
+}
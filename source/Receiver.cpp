@@ -0,0 +1,178 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cassert>
+
+#include <wiringPi.h>
+
+#include "Clock.h"
+#include "Receiver.h"
+
+/**
+ * Capacity for all edges is allocated upfront, so capturing an edge does not
+ * allocate memory.
+ *
+ * @param gpioPin GPIO pin connected to the receiver.
+ * @param samplingRateUs Delay between two samples (unit: microseconds).
+ * @param edgeCapacity Maximum number of captured edges.
+ */
+Receiver::Receiver(const uint8_t gpioPin,
+        const int32_t samplingRateUs, const size_t edgeCapacity) :
+        gpioPin_(gpioPin),
+        samplingRateNs_(samplingRateUs * Clock::NS_PER_US),
+        edges_(edgeCapacity),
+        edgeCount_(0U),
+        capturedNs_(0),
+        isRunning_(false),
+        isCapturing_(false),
+        thread_() {
+    // Do nothing
+}
+
+/**
+ * At most one edge is captured per sample. A second of margin covers the
+ * capture running before and after the transmission.
+ *
+ * @param durationNs Duration of the transmission (unit: nanoseconds).
+ * @param samplingRateUs Delay between two samples (unit: microseconds).
+ * @return Edge capacity.
+ */
+size_t Receiver::getCapacity(const int64_t durationNs,
+        const int32_t samplingRateUs) {
+    return static_cast<size_t>((durationNs + Clock::NS_PER_S)
+        / (samplingRateUs * Clock::NS_PER_US)) + 1U;
+}
+
+Receiver::~Receiver(void) {
+    stop();
+}
+
+void Receiver::start(void) {
+    assert(!thread_.joinable());
+
+    pinMode(gpioPin_, INPUT);
+    isRunning_.store(true);
+    isCapturing_.store(true);
+    thread_ = std::thread(&Receiver::run, this);
+}
+
+void Receiver::stop(void) {
+    isRunning_.store(false);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+/**
+ * @param timeNs Monotonic time (unit: nanoseconds).
+ * @return True if the signal has been captured up to the given time, false
+ *         if the capture has ended before.
+ */
+bool Receiver::waitUntilCaptured(const int64_t timeNs) const {
+    while (capturedNs_.load(std::memory_order_acquire) < timeNs) {
+        if (!isCapturing_.load(std::memory_order_acquire)) {
+            return capturedNs_.load(std::memory_order_acquire) >= timeNs;
+        }
+        Clock::sleepUntil(Clock::now() + samplingRateNs_);
+    }
+
+    return true;
+}
+
+/**
+ * @param timeNs Monotonic time (unit: nanoseconds).
+ * @return Received level, false=low / true=high.
+ */
+bool Receiver::getLevel(const int64_t timeNs) const {
+    const size_t count = edgeCount_.load(std::memory_order_acquire);
+    if (count == 0U) {
+        return false;
+    }
+
+    return edges_[findIndex(timeNs, count)].level;
+}
+
+/**
+ * @param level Level the signal changes to, false=low / true=high.
+ * @param beginNs Monotonic begin of the period (unit: nanoseconds).
+ * @param endNs Monotonic end of the period (unit: nanoseconds).
+ * @return Monotonic time of the edge (unit: nanoseconds), -1 if there is no
+ *         such edge.
+ */
+int64_t Receiver::findEdge(const bool level,
+        const int64_t beginNs, const int64_t endNs) const {
+    const size_t count = edgeCount_.load(std::memory_order_acquire);
+
+    // The first element is the initial level, not an edge
+    for (auto i = (count > 0U) ? findIndex(beginNs, count) + 1U : 0U;
+            (i < count) && (edges_[i].timeNs <= endNs); i++) {
+        if (edges_[i].level == level) {
+            return edges_[i].timeNs;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Samples are taken on absolute deadlines, but only level changes are
+ * stored. Every edge is published before the captured time is advanced past
+ * it.
+ */
+void Receiver::run(void) {
+    int64_t deadlineNs = Clock::now();
+    size_t count = 0U;
+    bool level = false;
+
+    while (isRunning_.load(std::memory_order_relaxed)
+            && (count < edges_.size())) {
+        const bool sample = digitalRead(gpioPin_) > 0;
+        const int64_t sampleNs = Clock::now();
+
+        if ((count == 0U) || (sample != level)) {
+            edges_[count].timeNs = sampleNs;
+            edges_[count].level = sample;
+            level = sample;
+            count++;
+            edgeCount_.store(count, std::memory_order_release);
+        }
+        capturedNs_.store(sampleNs, std::memory_order_release);
+
+        deadlineNs += samplingRateNs_;
+        Clock::sleepUntil(deadlineNs);
+    }
+
+    isCapturing_.store(false, std::memory_order_release);
+}
+
+/**
+ * @param timeNs Monotonic time (unit: nanoseconds).
+ * @param count Number of valid edges, must be >0.
+ * @return Index of the last edge at or before the given time, 0 if the time
+ *         is before the first edge.
+ */
+size_t Receiver::findIndex(const int64_t timeNs,
+        const size_t count) const {
+    const auto edge = std::upper_bound(edges_.begin(), edges_.begin() + count,
+        timeNs, [](const int64_t time, const Edge & edge) {
+            return time < edge.timeNs;
+        });
+
+    return (edge == edges_.begin()) ? 0U : (edge - edges_.begin()) - 1U;
+}
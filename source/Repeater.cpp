@@ -0,0 +1,517 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <functional>
+#include <iostream>
+#include <thread>
+
+#include <wiringPi.h>
+
+#include "Clock.h"
+#include "EchoFilter.h"
+#include "Receiver.h"
+#include "ReplayParameters.h"
+#include "Repeater.h"
+#include "ScanParameters.h"
+#include "TargetIndex.h"
+#include "Timings.h"
+#include "Trace.h"
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param durationMs Repeating duration (unit: milliseconds).
+ * @param latencyUs Latency from capturing to writing an edge (unit:
+ *                  microseconds), <=0 for the default.
+ * @param isFiltered True to repeat only frames matching a target.
+ */
+Repeater::Repeater(Configuration & configuration, const int32_t durationMs,
+        const int32_t latencyUs, const bool isFiltered) :
+        Task(configuration),
+        durationMs_(durationMs),
+        latencyUs_(latencyUs),
+        isFiltered_(isFiltered),
+        receiverGpioPin_(Types::INVALID_GPIO_PIN),
+        samplingRateNs_(0),
+        shapes_(),
+        frameGapNs_(0) {
+    // Do nothing
+}
+
+/**
+ * The GPIO pin of the 'replay' section is used for transmitting, the GPIO pin
+ * of the 'scan' section for receiving. Only the transmitting GPIO pin is
+ * locked.
+ *
+ * @return Program exit code.
+ */
+int Repeater::start(void) {
+    ScanParameters scanParameters(configuration_);
+    if (!scanParameters.load()) {
+        return EXIT_FAILURE;
+    }
+    receiverGpioPin_ = scanParameters.getGpioPin();
+    samplingRateNs_ = scanParameters.getSamplingRate() * Clock::NS_PER_US;
+    if (isFiltered_ && !loadShapes()) {
+        return EXIT_FAILURE;
+    } else if (latencyUs_ <= 0) {
+        latencyUs_ = DEFAULT_LATENCY_US;
+    }
+    Timings::mark("parameters");
+
+    // Get GPIO and duty cycle from the 'replay' section, the GPIO pin unless
+    // overridden from the command line
+    ReplayParameters replayParameters(configuration_);
+    if (!replayParameters.load()) {
+        return EXIT_FAILURE;
+    }
+    dutyCyclePpm_ = replayParameters.getDutyCycle();
+    dutyCycleWindowS_ = replayParameters.getDutyCycleWindow();
+    if (gpioPin_ == Types::INVALID_GPIO_PIN) {
+        gpioPin_ = replayParameters.getGpioPin();
+    } else if (!isValidGpioPin(gpioPin_)) {
+        std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (gpioPin_ == receiverGpioPin_) {
+        std::cerr << "Error: Transmitter and receiver must not use the same "
+            "GPIO pin " << +gpioPin_ << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
+    // Capture in a separate thread, transmit in this one
+    EdgeQueue queue(QUEUE_CAPACITY);
+    std::atomic<bool> isRunning(true);
+    std::atomic<uint32_t> overruns(0U);
+    Transmitter transmitter(gpioPin_);
+
+    pinMode(receiverGpioPin_, INPUT);
+    transmitter.beginStream();
+    std::thread capturer(&Repeater::capture, this, std::ref(queue),
+        std::cref(isRunning), std::ref(overruns));
+    const int64_t NS_PER_MS = 1000 * Clock::NS_PER_US;
+    const int64_t endNs = Clock::now() + durationMs_ * NS_PER_MS;
+    const Statistics statistics = isFiltered_
+        ? repeatFrames(transmitter, queue, endNs)
+        : repeat(transmitter, queue, endNs);
+    isRunning.store(false, std::memory_order_relaxed);
+    capturer.join();
+    transmitter.endStream();
+
+    report(statistics, overruns.load(std::memory_order_relaxed));
+
+    // Return the airtime taken but not used
+    if (!adjustAirtime(getAirtime(statistics) - statistics.grantedNs)) {
+        return EXIT_FAILURE;
+    }
+
+    return statistics.isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Pulse trains are normalized by merging consecutive pulses of the same level
+ * and by removing leading and trailing low pulses. The latency defaults to
+ * the longest frame plus the default latency and must exceed the longest
+ * frame.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool Repeater::loadShapes(void) {
+    const TargetIndex & targetIndex = configuration_.getTargetIndex();
+    int64_t longestNs = 0;
+    int64_t longestLowNs = 0;
+
+    for (const std::string & name : targetIndex.getNames()) {
+        const TargetParameters * parameters = targetIndex.find(name);
+        if (parameters == nullptr) {
+            continue;
+        }
+
+        Shape shape = { name, {}, 0 };
+        bool level = false;
+        for (const Types::Pulse & pulse : parameters->getPulses()) {
+            if ((pulse.level != 0U) == level && !shape.pulsesNs.empty()) {
+                shape.pulsesNs.back() += pulse.durationNs;
+            } else if ((pulse.level != 0U) || !shape.pulsesNs.empty()) {
+                shape.pulsesNs.push_back(pulse.durationNs);
+                level = (pulse.level != 0U);
+            }
+        }
+        if (!level && !shape.pulsesNs.empty()) {
+            shape.pulsesNs.pop_back();
+        }
+        if (shape.pulsesNs.empty()) {
+            continue;
+        }
+
+        for (size_t i = 0U; i < shape.pulsesNs.size(); i++) {
+            shape.durationNs += shape.pulsesNs[i];
+            if ((i % 2U == 1U) && (shape.pulsesNs[i] > longestLowNs)) {
+                longestLowNs = shape.pulsesNs[i];
+            }
+        }
+        if (shape.durationNs > longestNs) {
+            longestNs = shape.durationNs;
+        }
+        shapes_.push_back(shape);
+    }
+
+    if (shapes_.empty()) {
+        std::cerr << "Error: No valid target to filter frames by" << std::endl;
+        return false;
+    }
+
+    // Any low level longer than within a frame separates two frames
+    frameGapNs_ = longestLowNs + longestLowNs / 4 + 2 * samplingRateNs_ + 1;
+
+    const int32_t longestUs = static_cast<int32_t>((longestNs
+        + Clock::NS_PER_US - 1) / Clock::NS_PER_US);
+    if (latencyUs_ <= 0) {
+        latencyUs_ = longestUs + DEFAULT_LATENCY_US;
+    } else if (latencyUs_ <= longestUs) {
+        std::cerr << "Error: Latency must exceed the longest target frame of "
+            << longestUs << "us when filtering" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Samples are taken on absolute deadlines, but only level changes are handed
+ * over, the first one being the initial level. If the queue is full, the
+ * level change is handed over with the next sample instead.
+ *
+ * @param queue Queue receiving the edges.
+ * @param isRunning Flag to determine whether to keep capturing.
+ * @param overruns Number of samples the queue has been full at.
+ */
+void Repeater::capture(EdgeQueue & queue, const std::atomic<bool> & isRunning,
+        std::atomic<uint32_t> & overruns) const {
+    int64_t deadlineNs = Clock::now();
+    bool isCaptured = false;
+    bool level = false;
+
+    while (isRunning.load(std::memory_order_relaxed)) {
+        const bool sample = digitalRead(receiverGpioPin_) > 0;
+        const int64_t sampleNs = Clock::now();
+
+        if (!isCaptured || (sample != level)) {
+            if (queue.push({ sampleNs, sample })) {
+                isCaptured = true;
+                level = sample;
+            } else {
+                overruns.fetch_add(1U, std::memory_order_relaxed);
+            }
+        }
+
+        deadlineNs += samplingRateNs_;
+        Clock::sleepUntil(deadlineNs);
+    }
+}
+
+/**
+ * Edges captured right after an edge of the same level has been written are
+ * ignored as its echo, see EchoFilter. A rising edge is dropped with its
+ * falling edge unless airtime is left, and a high level is cut as soon as
+ * the airtime left has been used up.
+ *
+ * @param transmitter Transmitter writing the edges.
+ * @param queue Queue providing the captured edges.
+ * @param endNs Monotonic time to stop repeating at (unit: nanoseconds).
+ * @return Statistics of the repeated signal.
+ */
+Repeater::Statistics Repeater::repeat(Transmitter & transmitter,
+        EdgeQueue & queue, const int64_t endNs) const {
+    Statistics statistics = {};
+    EchoFilter echoFilter(samplingRateNs_);
+    bool isDropping = false;
+    EdgeQueue::Edge edge;
+
+    while ((Clock::now() < endNs) && !statistics.isFailed) {
+        // Cut a high level outlasting the duty cycle budget
+        if ((statistics.risingNs > 0) && !grantAirtime(0, statistics)) {
+            uint32_t missedDeadlines = 0U;
+            const int64_t writtenNs = transmitter.transmitEdge(false,
+                Clock::now(), missedDeadlines);
+            statistics.airtimeNs += writtenNs - statistics.risingNs;
+            statistics.risingNs = 0;
+            isDropping = true;
+        }
+
+        if (!queue.pop(edge)) {
+            Clock::sleepUntil(Clock::now() + samplingRateNs_);
+            continue;
+        }
+
+        // Ignore the echo of the previously repeated edges
+        if (echoFilter.isEcho(edge)) {
+            statistics.echoEdges++;
+            continue;
+        }
+
+        // Drop whole pulses exceeding the duty cycle budget
+        if (edge.level ? !grantAirtime(0, statistics) : isDropping) {
+            statistics.droppedEdges++;
+            isDropping = edge.level;
+            continue;
+        }
+
+        echoFilter.addWritten(edge.level,
+            transmit(transmitter, edge, statistics));
+    }
+
+    return statistics;
+}
+
+/**
+ * Every rising edge after a low level longer than any low pulse of the
+ * targets begins a frame. The frame is compared pulse by pulse to the targets
+ * and discarded as soon as it matches none of them. A frame matching a target
+ * completely is repeated, unless its first edge is already too late.
+ *
+ * @param transmitter Transmitter writing the edges.
+ * @param queue Queue providing the captured edges.
+ * @param endNs Monotonic time to stop repeating at (unit: nanoseconds).
+ * @return Statistics of the repeated signal.
+ */
+Repeater::Statistics Repeater::repeatFrames(Transmitter & transmitter,
+        EdgeQueue & queue, const int64_t endNs) const {
+    const int64_t latencyNs = latencyUs_ * Clock::NS_PER_US;
+    Statistics statistics = {};
+    std::vector<EdgeQueue::Edge> frame;
+    std::vector<bool> candidates(shapes_.size());
+    int64_t previousNs = Clock::now();
+    int64_t echoBeginNs = 0;
+    int64_t echoEndNs = 0;
+    bool isCollecting = false;
+    EdgeQueue::Edge edge;
+
+    while ((Clock::now() < endNs) && !statistics.isFailed) {
+        if (!queue.pop(edge)) {
+            Clock::sleepUntil(Clock::now() + samplingRateNs_);
+            continue;
+        }
+
+        // Ignore the echo of the previously repeated frame
+        const int64_t gapNs = edge.timeNs - previousNs;
+        previousNs = edge.timeNs;
+        if ((edge.timeNs >= echoBeginNs) && (edge.timeNs <= echoEndNs)) {
+            statistics.echoEdges++;
+            isCollecting = false;
+            continue;
+        }
+
+        // Begin a new frame after a gap
+        if (edge.level && (gapNs >= frameGapNs_)) {
+            statistics.rejectedFrames += isCollecting ? 1U : 0U;
+            frame.clear();
+            frame.push_back(edge);
+            candidates.assign(shapes_.size(), true);
+            isCollecting = true;
+            continue;
+        } else if (!isCollecting) {
+            continue;
+        }
+
+        // Compare the completed pulse to all remaining targets
+        frame.push_back(edge);
+        const size_t pulse = frame.size() - 2U;
+        const int64_t pulseNs = edge.timeNs - frame[pulse].timeNs;
+        bool isCandidate = false;
+        bool isComplete = false;
+        for (size_t i = 0U; i < shapes_.size(); i++) {
+            const std::vector<int64_t> & pulsesNs = shapes_[i].pulsesNs;
+            candidates[i] = candidates[i] && (pulse < pulsesNs.size())
+                && isMatching(pulseNs, pulsesNs[pulse]);
+            isCandidate = isCandidate || candidates[i];
+            isComplete = isComplete
+                || (candidates[i] && (pulse + 1U == pulsesNs.size()));
+        }
+
+        if (isComplete) {
+            isCollecting = false;
+            echoBeginNs = frame.front().timeNs + latencyNs;
+            if (echoBeginNs < Clock::now()) {
+                statistics.lateFrames++;
+                continue;
+            }
+
+            // Drop the frame unless the duty cycle budget covers it
+            int64_t airtimeNs = 0;
+            for (size_t i = 0U; i + 1U < frame.size(); i += 2U) {
+                airtimeNs += frame[i + 1U].timeNs - frame[i].timeNs;
+            }
+            if (!grantAirtime(airtimeNs, statistics)) {
+                statistics.droppedFrames++;
+                continue;
+            }
+
+            for (const EdgeQueue::Edge & frameEdge : frame) {
+                transmit(transmitter, frameEdge, statistics);
+            }
+            statistics.frames++;
+            echoEndNs = frame.back().timeNs + latencyNs
+                + Receiver::MAX_LATENCY_NS;
+            Trace::span("repeat", echoBeginNs, Clock::now(), "edges",
+                frame.size());
+        } else if (!isCandidate) {
+            isCollecting = false;
+            statistics.rejectedFrames++;
+        }
+    }
+
+    return statistics;
+}
+
+/**
+ * @param transmitter Transmitter writing the edge.
+ * @param edge Captured edge.
+ * @param statistics Statistics to update.
+ * @return Monotonic time the edge has been written at (unit: nanoseconds).
+ */
+int64_t Repeater::transmit(Transmitter & transmitter,
+        const EdgeQueue::Edge & edge, Statistics & statistics) const {
+    const int64_t writtenNs = transmitter.transmitEdge(edge.level,
+        edge.timeNs + latencyUs_ * Clock::NS_PER_US,
+        statistics.missedDeadlines);
+    const int64_t latencyNs = writtenNs - edge.timeNs;
+
+    if ((statistics.edges == 0U) || (latencyNs < statistics.minLatencyNs)) {
+        statistics.minLatencyNs = latencyNs;
+    }
+    if (latencyNs > statistics.maxLatencyNs) {
+        statistics.maxLatencyNs = latencyNs;
+    }
+    statistics.sumLatencyNs += latencyNs;
+    statistics.edges++;
+
+    if (edge.level && (statistics.risingNs == 0)) {
+        statistics.risingNs = writtenNs;
+    } else if (!edge.level && (statistics.risingNs > 0)) {
+        statistics.airtimeNs += writtenNs - statistics.risingNs;
+        statistics.risingNs = 0;
+    }
+
+    return writtenNs;
+}
+
+/**
+ * @param statistics Statistics of the repeated signal.
+ * @return Duration of all high levels written, including the current one
+ *         (unit: nanoseconds).
+ */
+int64_t Repeater::getAirtime(const Statistics & statistics) const {
+    return statistics.airtimeNs + ((statistics.risingNs > 0)
+        ? Clock::now() - statistics.risingNs : 0);
+}
+
+/**
+ * Airtime is taken from the duty cycle budget in chunks, so its state file is
+ * accessed rarely while repeating. Once the budget does not cover another
+ * chunk, taking airtime is retried only after a delay.
+ *
+ * @param airtimeNs Airtime about to be used (unit: nanoseconds).
+ * @param statistics Statistics of the repeated signal, updated by the airtime
+ *                   taken.
+ * @return True if more airtime than the given one is left, false otherwise.
+ */
+bool Repeater::grantAirtime(const int64_t airtimeNs,
+        Statistics & statistics) const {
+    const int64_t leftNs = statistics.grantedNs - getAirtime(statistics);
+    const int64_t requiredNs = airtimeNs - leftNs + 1;
+    int64_t takenNs;
+
+    if ((dutyCyclePpm_ == Types::INVALID_PARAMETER) || (leftNs > airtimeNs)) {
+        return true;
+    }
+    if (Clock::now() < statistics.retryNs) {
+        return false;
+    }
+
+    if (!takeAirtime((requiredNs > AIRTIME_CHUNK_NS) ? requiredNs
+            : AIRTIME_CHUNK_NS, takenNs)) {
+        statistics.isFailed = true;
+        return false;
+    }
+    statistics.grantedNs += takenNs;
+    if (takenNs == 0) {
+        statistics.retryNs = Clock::now() + AIRTIME_RETRY_NS;
+        return false;
+    }
+
+    return leftNs + takenNs > airtimeNs;
+}
+
+/**
+ * Pulses match within a quarter of their expected length, but at least
+ * within two sampling periods.
+ *
+ * @param pulseNs Received pulse length (unit: nanoseconds).
+ * @param expectedNs Expected pulse length (unit: nanoseconds).
+ * @return True if the pulse length matches, false otherwise.
+ */
+bool Repeater::isMatching(const int64_t pulseNs,
+        const int64_t expectedNs) const {
+    const int64_t toleranceNs = (expectedNs / 4 > 2 * samplingRateNs_)
+        ? expectedNs / 4 : 2 * samplingRateNs_;
+    const int64_t errorNs = pulseNs - expectedNs;
+
+    return (errorNs >= -toleranceNs) && (errorNs <= toleranceNs);
+}
+
+/**
+ * @param statistics Statistics of the repeated signal.
+ * @param overruns Number of samples the queue has been full at.
+ */
+void Repeater::report(const Statistics & statistics,
+        const uint32_t overruns) const {
+    std::cout << "Repeated " << statistics.edges << " edges";
+    if (isFiltered_) {
+        std::cout << " of " << statistics.frames << " frames, "
+            << statistics.rejectedFrames << " frames rejected, "
+            << statistics.lateFrames << " frames too late";
+    }
+    std::cout << ", " << statistics.echoEdges << " echo edges ignored"
+        << std::endl;
+    if (dutyCyclePpm_ != Types::INVALID_PARAMETER) {
+        std::cout << "Duty cycle: " << getAirtime(statistics)
+            / (1000 * Clock::NS_PER_US) << "ms airtime, ";
+        if (isFiltered_) {
+            std::cout << statistics.droppedFrames << " frames dropped";
+        } else {
+            std::cout << statistics.droppedEdges << " edges dropped";
+        }
+        std::cout << std::endl;
+    }
+
+    if (statistics.edges > 0U) {
+        std::cout << "Latency: min " << statistics.minLatencyNs
+            / Clock::NS_PER_US << "us, average " << statistics.sumLatencyNs
+            / statistics.edges / Clock::NS_PER_US << "us, max "
+            << statistics.maxLatencyNs / Clock::NS_PER_US << "us (target "
+            << latencyUs_ << "us)" << std::endl;
+    }
+    std::cout << "Missed deadlines: " << statistics.missedDeadlines
+        << ", queue overruns: " << overruns << std::endl;
+}
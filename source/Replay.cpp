@@ -21,11 +21,14 @@
 #include <fstream>
 #include <iostream>
 #include <string.h>
-#include <unistd.h>
-
-#include <wiringPi.h>
 
+#include "CaptureIndex.h"
+#include "Clock.h"
+#include "FrameArchive.h"
+#include "Metrics.h"
 #include "Replay.h"
+#include "Timings.h"
+#include "Transmitter.h"
 #include "Types.h"
 
 /**
@@ -51,6 +54,7 @@ int Replay::start(void) {
     if (!parameters_->load()) {
         return EXIT_FAILURE;
     }
+    Timings::mark("parameters");
 
     // Get GPIO from the parameters unless overridden from the command line
     if (gpioPin_ == Types::INVALID_GPIO_PIN) {
@@ -61,8 +65,21 @@ int Replay::start(void) {
         return EXIT_FAILURE;
     }
 
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
     // Load the air scan dump
-    if (!deserializeData()) {
+    if (!load()) {
+        return EXIT_FAILURE;
+    }
+    Timings::mark("dump");
+
+    // Wait until the duty cycle budget of the GPIO pin allows transmitting
+    dutyCyclePpm_ = parameters_->getDutyCycle();
+    dutyCycleWindowS_ = parameters_->getDutyCycleWindow();
+    if (!reserveAirtime(Transmitter::getAirtime(data_, samplingRateUs_))) {
         return EXIT_FAILURE;
     }
 
@@ -72,14 +89,12 @@ int Replay::start(void) {
 }
 
 void Replay::airReplay(void) const {
-    pinMode(gpioPin_, OUTPUT);
+    Transmitter transmitter(gpioPin_);
+    const int64_t startNs = Clock::now();
 
-    for (auto i = 0U; i < data_.size(); i++) {
-        digitalWrite(gpioPin_, data_.at(i) ? HIGH : LOW);
-        usleep(samplingRateUs_);
-    }
-
-    pinMode(gpioPin_, INPUT);
+    const uint32_t missedDeadlines = transmitter.transmit(data_,
+        samplingRateUs_);
+    Metrics::addReplay(data_.size(), missedDeadlines, Clock::now() - startNs);
 }
 
 /**
@@ -89,12 +104,24 @@ void Replay::airReplay(void) const {
  * - [4 bytes] Signature
  * - [4 bytes] Sampling rate (unit: microseconds)
  * - [n bytes] Sample data, 1 byte each, 0=low / 1=high
+ *
+ * Dump files given as 'archive:name' are loaded from a frame archive instead,
+ * dump files given as 'file@selection' are partially loaded (see
+ * CaptureIndex).
  */
-bool Replay::deserializeData(void) {
+bool Replay::load(void) {
     std::ifstream dumpFile;
 
     assert(dumpFile_.length() > 0U);
 
+    std::string location;
+    std::string name;
+    if (CaptureIndex::split(dumpFile_, location, name)) {
+        return loadSegment(location, name);
+    } else if (FrameArchive::split(dumpFile_, location, name)) {
+        return loadFrame(location, name);
+    }
+
     // Open dump file
     dumpFile.open(dumpFile_, std::ios::in | std::ios::binary);
     if (!dumpFile.is_open()) {
@@ -165,3 +192,89 @@ bool Replay::deserializeData(void) {
 
     return true;
 }
+
+/**
+ * @return Air scan dump data, a false element indicates a low signal, a true
+ *         element a high signal.
+ */
+const std::vector<bool> & Replay::getData(void) const {
+    return data_;
+}
+
+/// @return Delay between two samples (unit: microseconds).
+int32_t Replay::getSamplingRate(void) const {
+    return samplingRateUs_;
+}
+
+/**
+ * Only the index and the samples of the frame are read from the archive, so
+ * loading does not depend on the number of archived frames.
+ *
+ * @param location Location of the frame archive.
+ * @param name Name of the frame.
+ * @return Status of the operation.
+ */
+bool Replay::loadFrame(const std::string & location,
+        const std::string & name) {
+    FrameArchive archive(location);
+    FrameArchive::Frame frame;
+
+    if (!archive.open()) {
+        return false;
+    }
+    if (!archive.find(name, frame)) {
+        std::cerr << "Error: Frame '" << name << "' not found in frame archive "
+            "'" << location << "'" << std::endl;
+        return false;
+    }
+
+    samplingRateUs_ = frame.samplingRateUs;
+    data_.assign(frame.samples, frame.samples + frame.sampleCount);
+    if (data_.empty()) {
+        std::cerr << "Error: Given frame archive seems corrupted (no data "
+            "elements found)" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * The samples of the selection are read by seeking to them, so loading does
+ * not depend on the size of the dump once it has been indexed.
+ *
+ * @param file File name of the air scan dump.
+ * @param selection Segment number or time range, see CaptureIndex::select().
+ * @return Status of the operation.
+ */
+bool Replay::loadSegment(const std::string & file,
+        const std::string & selection) {
+    CaptureIndex index(file);
+    CaptureIndex::Segment segment;
+
+    if (!index.open() || !index.select(selection, segment)) {
+        return false;
+    }
+
+    std::ifstream dumpFile(file, std::ios::in | std::ios::binary);
+    std::vector<char> samples(segment.sampleCount);
+    dumpFile.seekg(CaptureIndex::SAMPLES_OFFSET + segment.firstSample);
+    if (!dumpFile.read(samples.data(), samples.size())) {
+        std::cerr << "Error: Unable to read segment '" << selection << "' "
+            "from dump file: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    samplingRateUs_ = index.getSamplingRate();
+    data_.reserve(samples.size());
+    for (const char data : samples) {
+        if ((data < 0) || (data > 1)) {
+            std::cerr << "Error: Given air scan dump seems corrupted (invalid "
+                "data value " << +data << ")" << std::endl;
+            return false;
+        }
+        data_.push_back(data == 1);
+    }
+
+    return true;
+}
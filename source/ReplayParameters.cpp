@@ -20,6 +20,7 @@
 #include <cassert>
 #include <iostream>
 
+#include "DutyCycle.h"
 #include "ReplayParameters.h"
 #include "Task.h"
 #include "Types.h"
@@ -27,13 +28,16 @@
 /// @param configuration Configuration data.
 ReplayParameters::ReplayParameters(const Configuration & configuration) :
         configuration_(configuration),
-        gpioPin_(Types::INVALID_GPIO_PIN) {
+        gpioPin_(Types::INVALID_GPIO_PIN),
+        dutyCyclePpm_(Types::INVALID_PARAMETER),
+        dutyCycleWindowS_(DutyCycle::DEFAULT_WINDOW_S) {
     // Do nothing
 }
 
 /// @return Status of the operation.
 bool ReplayParameters::load(void) {
-    return loadGpioPin();
+    return loadGpioPin()
+        && loadDutyCycle();
 }
 
 /// @return GPIO pin.
@@ -42,6 +46,16 @@ uint8_t ReplayParameters::getGpioPin(void) const {
     return gpioPin_;
 }
 
+/// @return Maximum share of airtime on the GPIO pin.
+int32_t ReplayParameters::getDutyCycle(void) const {
+    return dutyCyclePpm_;
+}
+
+/// @return Window the duty cycle is averaged over.
+int32_t ReplayParameters::getDutyCycleWindow(void) const {
+    return dutyCycleWindowS_;
+}
+
 /// @return True if successful, false otherwise.
 bool ReplayParameters::loadGpioPin(void) {
     int32_t value;
@@ -62,3 +76,40 @@ bool ReplayParameters::loadGpioPin(void) {
 
     return true;
 }
+
+/**
+ * The duty cycle is given in percent, like the one of the targets.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool ReplayParameters::loadDutyCycle(void) {
+    const libconfig::Setting * section = configuration_.getSection("replay");
+    if ((section == nullptr) || !section->exists("dutyCycle")) {
+        return true;
+    }
+
+    const libconfig::Setting & setting = (*section)["dutyCycle"];
+    double percent = 0.0;
+    if (setting.isNumber()) {
+        percent = setting;
+    }
+    if (!setting.isNumber() || (percent <= 0.0) || (percent > 100.0)) {
+        std::cerr << "Error: Configuration error (replay): dutyCycle is "
+            "invalid" << std::endl;
+        return false;
+    }
+    dutyCyclePpm_ = static_cast<int32_t>(percent * 10000.0 + 0.5);
+    if (dutyCyclePpm_ < 1) {
+        dutyCyclePpm_ = 1;
+    }
+
+    if (section->exists("dutyCycleWindow")
+            && (!section->lookupValue("dutyCycleWindow", dutyCycleWindowS_)
+            || (dutyCycleWindowS_ <= 0))) {
+        std::cerr << "Error: Configuration error (replay): dutyCycleWindow is "
+            "invalid" << std::endl;
+        return false;
+    }
+
+    return true;
+}
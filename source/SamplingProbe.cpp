@@ -0,0 +1,181 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <wiringPi.h>
+
+#include "Clock.h"
+#include "SamplingProbe.h"
+#include "TimingProfile.h"
+
+const int32_t SamplingProbe::SAMPLING_RATES_US[] = { 10, 20, 50, 100, 200,
+    500, 1000 };
+
+/// @param configuration Reference of the configuration.
+SamplingProbe::SamplingProbe(Configuration & configuration) :
+        Task(configuration) {
+    // Do nothing
+}
+
+/**
+ * The results are written to stdout as tab separated values, one line per
+ * sampling rate, followed by the recommendation.
+ *
+ * @return Program exit code, failure if no sampling rate is sustainable.
+ */
+int SamplingProbe::start(void) {
+    // Get GPIO from the 'scan' section unless overridden from the command
+    // line
+    if (gpioPin_ == Types::INVALID_GPIO_PIN) {
+        int gpioPin;
+        if (!configuration_.getValue("scan", "gpioPin", gpioPin)) {
+            std::cerr << "Error: Configuration error (scan): gpioPin is "
+                "undefined, use parameter '-g'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        gpioPin_ = static_cast<uint8_t>(gpioPin);
+    }
+    if (!isValidGpioPin(gpioPin_)) {
+        std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
+    pinMode(gpioPin_, INPUT);
+    std::cout << "# GPIO read: " << measureRead() << "ns" << std::endl
+        << "# samplingRateUs\tmedianLatenessNs\tp99LatenessNs\t"
+        "maxLatenessNs\tslipped\tsamples" << std::endl;
+
+    int32_t recommendedUs = 0;
+    for (const int32_t samplingRateUs : SAMPLING_RATES_US) {
+        const Result result = measure(samplingRateUs);
+
+        std::cout << samplingRateUs << "\t" << result.medianNs << "\t"
+            << result.p99Ns << "\t" << result.maxNs << "\t" << result.slipped
+            << "\t" << result.samples << std::endl;
+        if ((recommendedUs == 0) && isSustainable(result, samplingRateUs)) {
+            recommendedUs = samplingRateUs;
+        }
+    }
+
+    if (recommendedUs == 0) {
+        std::cerr << "Error: None of the probed sampling rates is sustainable "
+            "on this host" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Recommended: samplingRate = " << recommendedUs << ";"
+        << std::endl;
+
+    // Warn about a configured sampling rate which cannot be sustained
+    int32_t configuredUs;
+    if (configuration_.getValue("scan", "samplingRate", configuredUs)
+            && (configuredUs > 0) && (configuredUs < recommendedUs)) {
+        std::cerr << "Warning: Configured samplingRate of " << configuredUs
+            << "us cannot be sustained on this host" << std::endl;
+    }
+
+    // Store the recommendation, keeping the rest of the timing profile
+    const TimingProfile & profile = TimingProfile::get();
+    if (!TimingProfile(profile.getSleepOvershoot(), profile.getGpioWrite(),
+            profile.getClockRead(), recommendedUs).save()) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Timing profile written to " << TimingProfile::LOCATION
+        << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * The GPIO read duration bounds the sampling rate even without sleeping
+ * between the samples.
+ *
+ * @return Average GPIO read duration (unit: nanoseconds).
+ */
+int64_t SamplingProbe::measureRead(void) const {
+    const int32_t ITERATIONS = 100000;
+
+    const int64_t beginNs = Clock::now();
+    for (auto i = 0; i < ITERATIONS; i++) {
+        digitalRead(gpioPin_);
+    }
+
+    return (Clock::now() - beginNs) / ITERATIONS;
+}
+
+/**
+ * The loop matches the one of Scan, i.e. every sample is read, stored and
+ * followed by sleeping until the deadline of the next sample.
+ *
+ * @param samplingRateUs Delay between two samples (unit: microseconds).
+ * @return Lateness statistics of the samples.
+ */
+SamplingProbe::Result SamplingProbe::measure(
+        const int32_t samplingRateUs) const {
+    const int64_t samplingRateNs = samplingRateUs * Clock::NS_PER_US;
+    const size_t SAMPLES = static_cast<size_t>(PROBE_DURATION_NS
+        / samplingRateNs);
+    std::vector<bool> data;
+    std::vector<int64_t> latenessNs;
+    Result result = {};
+
+    data.reserve(SAMPLES);
+    latenessNs.reserve(SAMPLES);
+    int64_t deadlineNs = Clock::now();
+    while (data.size() < SAMPLES) {
+        latenessNs.push_back(Clock::now() - deadlineNs);
+        data.push_back(digitalRead(gpioPin_) > 0);
+
+        deadlineNs += samplingRateNs;
+        Clock::sleepUntil(deadlineNs);
+    }
+
+    for (const int64_t lateNs : latenessNs) {
+        result.slipped += (lateNs >= samplingRateNs) ? 1U : 0U;
+    }
+    std::sort(latenessNs.begin(), latenessNs.end());
+    result.medianNs = latenessNs.at(SAMPLES / 2U);
+    result.p99Ns = latenessNs.at(SAMPLES * 99U / 100U);
+    result.maxNs = latenessNs.back();
+    result.samples = static_cast<uint32_t>(SAMPLES);
+
+    return result;
+}
+
+/**
+ * A sampling rate is sustainable if 99% of the samples are taken within half
+ * a sampling period, i.e. the headroom absorbs all but rare wake-up outliers.
+ *
+ * @param result Result of probing the sampling rate.
+ * @param samplingRateUs Probed sampling rate (unit: microseconds).
+ * @return True if the sampling rate is sustainable, false otherwise.
+ */
+bool SamplingProbe::isSustainable(const Result & result,
+        const int32_t samplingRateUs) {
+    const int64_t samplingRateNs = samplingRateUs * Clock::NS_PER_US;
+
+    return result.p99Ns <= samplingRateNs / 2;
+}
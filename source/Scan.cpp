@@ -21,23 +21,36 @@
 #include <fstream>
 #include <iostream>
 #include <string.h>
-#include <unistd.h>
 
 #include <wiringPi.h>
 
+#include "CaptureIndex.h"
+#include "Clock.h"
+#include "Metrics.h"
 #include "Scan.h"
+#include "ScanRenderer.h"
+#include "Timings.h"
+#include "Trace.h"
+#include "ValueChangeDump.h"
 
 /**
  * @param configuration Reference of the configuration.
  * @param durationMs Air scan duration (unit: milliseconds).
  * @param dumpFile Reference of the dump file. Can be an empty string to dump
  *                 human readable ASCII output to stdout.
+ * @param scaleUs Duration of a single bar character of the ASCII output
+ *                (unit: microseconds), <=0 to fit the longest run.
+ * @param isSummary True to print a horizontal summary of the terminal width
+ *                  as ASCII output instead of one row per run.
  */
 Scan::Scan(Configuration & configuration, const int32_t durationMs,
-        const std::string & dumpFile) :
+        const std::string & dumpFile, const int32_t scaleUs,
+        const bool isSummary) :
         Task(configuration),
         durationMs_(durationMs),
         dumpFile_(dumpFile),
+        scaleUs_(scaleUs),
+        isSummary_(isSummary),
         parameters_(nullptr),
         data_() {
     // Do nothing
@@ -53,6 +66,7 @@ int Scan::start(void) {
     if (!parameters_->load()) {
         return EXIT_FAILURE;
     }
+    Timings::mark("parameters");
 
     // Get GPIO from the parameters unless overridden from the command line
     if (gpioPin_ == Types::INVALID_GPIO_PIN) {
@@ -63,15 +77,51 @@ int Scan::start(void) {
         return EXIT_FAILURE;
     }
 
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
     // Perform the air scan and process the results
     airScan();
+    writeData();
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * The scan parameters are loaded from the configuration unless loaded before,
+ * they determine the sampling rate of the results.
+ *
+ * @param data Air scan results, a false element indicates a low signal, a true
+ *             element a high signal.
+ * @return True if successful, false if the scan parameters are invalid.
+ */
+bool Scan::setData(const std::vector<bool> & data) {
+    if (parameters_ == nullptr) {
+        auto parameters = std::make_unique<ScanParameters>(
+            ScanParameters(configuration_));
+        if (!parameters->load()) {
+            return false;
+        }
+        parameters_ = std::move(parameters);
+    }
+    data_ = data;
+
+    return true;
+}
+
+/// The output format is given by the dump file name, see Scan().
+void Scan::writeData(void) const {
+    assert(parameters_ != nullptr);
+
     if (dumpFile_.length() == 0U) {
         printData();
+    } else if (ValueChangeDump::isValueChangeDump(dumpFile_)) {
+        exportData();
     } else {
         serializeData();
     }
-
-    return EXIT_SUCCESS;
 }
 
 void Scan::airScan(void) {
@@ -81,32 +131,44 @@ void Scan::airScan(void) {
 
     pinMode(gpioPin_, INPUT);
 
-    // Collect the data
+    // Collect the data, sampling on absolute deadlines
+    const int64_t samplingRateNs = parameters_->getSamplingRate()
+        * Clock::NS_PER_US;
+    uint32_t slipped = 0U;
     data_.clear();
+    data_.reserve(static_cast<size_t>(SAMPLES));
+    Timings::mark("first sample");
+    const int64_t startNs = Clock::now();
+    int64_t deadlineNs = startNs;
     while (data_.size() < static_cast<size_t>(SAMPLES)) {
+        slipped += (Clock::now() - deadlineNs >= samplingRateNs) ? 1U : 0U;
         data_.push_back(digitalRead(gpioPin_) > 0);
-        usleep(parameters_->getSamplingRate());
+
+        deadlineNs += samplingRateNs;
+        Clock::sleepUntil(deadlineNs);
+    }
+    const int64_t endNs = Clock::now();
+    // Rare outliers are expected, more than 1% indicate a too short rate
+    if (slipped * 100U > data_.size()) {
+        std::cerr << "Warning: " << slipped << " of " << data_.size()
+            << " samples were taken a sampling period too late, samplingRate "
+            "of " << parameters_->getSamplingRate() << "us cannot be "
+            "sustained (see parameter '--probe')" << std::endl;
     }
+    Metrics::addScan(data_.size(), endNs - startNs);
+    Trace::span("scan", startNs, endNs, "samples", data_.size());
 }
 
+/// The graph is rendered completely before it is written at once.
 void Scan::printData(void) const {
-    bool previousData = false;
-
-    for (auto i = 0U; i < data_.size(); i++) {
-        if (data_.at(i)) {
-            if (!previousData) {
-                std::cout << "+----+" << std::endl;
-            }
-            std::cout << "     |" << std::endl;
-        } else {
-            if (previousData) {
-                std::cout << "+----+" << std::endl;
-            }
-            std::cout << "|" << std::endl;
-        }
+    const ScanRenderer renderer(data_, parameters_->getSamplingRate());
+    const std::string output = isSummary_
+        ? renderer.renderSummary(ScanRenderer::getTerminalWidth())
+        : renderer.renderRuns(scaleUs_);
 
-        previousData = data_.at(i);
-    }
+    std::cout.write(output.data(), static_cast<std::streamsize>(
+        output.length()));
+    std::cout.flush();
 }
 
 /**
@@ -114,6 +176,9 @@ void Scan::printData(void) const {
  * - [4 bytes] Signature
  * - [4 bytes] Sampling rate (unit: microseconds)
  * - [n bytes] Sample data, 1 byte each, 0=low / 1=high
+ *
+ * The activity segments are indexed alongside (see CaptureIndex), failing to
+ * write the index is silently ignored as it is rebuilt when required.
  */
 void Scan::serializeData(void) const {
     std::ofstream dumpFile;
@@ -156,7 +221,54 @@ void Scan::serializeData(void) const {
         }
     }
 
+    // Index the activity segments of the closed dump file
+    dumpFile.close();
+    CaptureIndex index(dumpFile_);
+    index.begin(samplingRate);
+    for (const bool sample : data_) {
+        index.addSample(sample);
+    }
+    index.end();
+    index.save();
+
     // Clean up
     std::cout << "Air scan results dumped successfully to file '" << dumpFile_
         << "'." << std::endl;
 }
+
+/**
+ * The samples are streamed edge by edge through a large output buffer, so
+ * neither the output is held in memory nor written in small pieces.
+ */
+void Scan::exportData(void) const {
+    std::vector<char> buffer(EXPORT_BUFFER_SIZE);
+    std::ofstream dumpFile;
+
+    assert(dumpFile_.length() > 0U);
+
+    // Open dump file, the buffer must be set before
+    dumpFile.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    dumpFile.open(dumpFile_, std::ios::out | std::ios::trunc);
+    if (!dumpFile.is_open()) {
+        std::cerr << "Error: Dump file '" << dumpFile_ << "' cannot be opened "
+            "for writing: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // Write all edges
+    ValueChangeDump dump(dumpFile, gpioPin_, parameters_->getSamplingRate());
+    dump.writeHeader();
+    for (const bool sample : data_) {
+        dump.writeSample(sample);
+    }
+    dump.writeEnd();
+    if (!dumpFile) {
+        std::cerr << "Error: Unable to write data to dump file: "
+            << strerror(errno) << std::endl;
+        return;
+    }
+
+    // Clean up
+    std::cout << "Air scan results exported successfully to file '"
+        << dumpFile_ << "'." << std::endl;
+}
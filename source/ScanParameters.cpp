@@ -19,9 +19,11 @@
 
 #include <cassert>
 #include <iostream>
+#include <string>
 
 #include "ScanParameters.h"
 #include "Task.h"
+#include "TimingProfile.h"
 #include "Types.h"
 
 /// @param configuration Reference of the configuration.
@@ -71,8 +73,27 @@ bool ScanParameters::loadGpioPin(void) {
     return true;
 }
 
-/// @return True if successful, false otherwise.
+/**
+ * The sampling rate "auto" selects the sampling rate measured by the probe
+ * (see SamplingProbe).
+ *
+ * @return True if successful, false otherwise.
+ */
 bool ScanParameters::loadSamplingRate(void) {
+    std::string value;
+    if (configuration_.getValue("scan", "samplingRate", value)
+            && (value == "auto")) {
+        samplingRateUs_ = TimingProfile::get().getSamplingRate();
+        if (samplingRateUs_ <= 0) {
+            std::cerr << "Error: Configuration error (scan): samplingRate is "
+                "auto, but has not been probed (use parameter '--probe')"
+                << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
     if (!configuration_.getValue("scan", "samplingRate", samplingRateUs_)) {
         std::cerr << "Error: Missing configuration parameter 'samplingRate'."
             << std::endl;
@@ -0,0 +1,202 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include "ScanRenderer.h"
+
+/**
+ * @param samples Samples of the air scan, must outlive the renderer.
+ * @param samplingRateUs Time between two samples (unit: microseconds).
+ */
+ScanRenderer::ScanRenderer(const std::vector<bool> & samples,
+        const int32_t samplingRateUs) :
+        samples_(samples),
+        samplingRateUs_(samplingRateUs) {
+    // Do nothing
+}
+
+/**
+ * Low runs are drawn on the left, high runs on the right, level changes in
+ * between like in the following example:
+ *
+ *     |         1200us  ============
+ *     +----+
+ *          |     350us  ====
+ *     +----+
+ *
+ * Bars exceeding the maximum length are truncated and marked with '>'.
+ *
+ * @param scaleUs Duration of a single bar character (unit: microseconds),
+ *                <=0 to fit the longest run into the maximum bar length.
+ * @return Rendered graph.
+ */
+std::string ScanRenderer::renderRuns(const int32_t scaleUs) const {
+    const std::vector<Run> runs = getRuns();
+    const std::string TRANSITION = "+----+\n";
+    const size_t DURATION_WIDTH = 10U;
+
+    // Determine the scale from the longest run unless given
+    int64_t scale = scaleUs;
+    if (scale <= 0) {
+        size_t longest = 0U;
+        for (const Run & run : runs) {
+            longest = (run.samples > longest) ? run.samples : longest;
+        }
+        const int64_t longestUs = static_cast<int64_t>(longest)
+            * samplingRateUs_;
+        const int64_t maxBar = MAX_BAR_LENGTH;
+        scale = (longestUs + maxBar - 1) / maxBar;
+        scale = (scale < samplingRateUs_) ? samplingRateUs_ : scale;
+    }
+
+    std::string output = "Scale: 1 character = " + formatDuration(scale)
+        + "\n";
+    output.reserve(output.length() + runs.size()
+        * (TRANSITION.length() + 2U * DURATION_WIDTH + MAX_BAR_LENGTH));
+    bool previousLevel = false;
+    for (const Run & run : runs) {
+        if (run.level != previousLevel) {
+            output += TRANSITION;
+        }
+        previousLevel = run.level;
+
+        const int64_t durationUs = static_cast<int64_t>(run.samples)
+            * samplingRateUs_;
+        const std::string duration = formatDuration(durationUs);
+        const int64_t bar = (durationUs + scale - 1) / scale;
+
+        output += run.level ? "     |" : "|     ";
+        output.append((duration.length() < DURATION_WIDTH)
+            ? DURATION_WIDTH - duration.length() : 1U, ' ');
+        output += duration;
+        output += "  ";
+        if (bar > static_cast<int64_t>(MAX_BAR_LENGTH)) {
+            output.append(MAX_BAR_LENGTH - 1U, '=');
+            output += '>';
+        } else {
+            output.append(static_cast<size_t>(bar), '=');
+        }
+        output += '\n';
+    }
+
+    return output;
+}
+
+/**
+ * Every column covers an equal share of the samples and shows '_' if all of
+ * them are low, '#' if all of them are high and '|' if the level changes
+ * within the column. A time axis is rendered below.
+ *
+ * @param columns Number of columns, fewer are used if there are fewer
+ *                samples.
+ * @return Rendered summary.
+ */
+std::string ScanRenderer::renderSummary(const size_t columns) const {
+    const size_t width = (samples_.size() < columns) ? samples_.size()
+        : columns;
+    std::string output;
+
+    if (width == 0U) {
+        return output;
+    }
+
+    output.reserve(2U * (width + 1U));
+    for (size_t column = 0U; column < width; column++) {
+        const size_t begin = column * samples_.size() / width;
+        const size_t end = (column + 1U) * samples_.size() / width;
+        bool low = false;
+        bool high = false;
+
+        for (size_t i = begin; i < end; i++) {
+            high = high || samples_[i];
+            low = low || !samples_[i];
+        }
+        output += (low && high) ? '|' : (high ? '#' : '_');
+    }
+    output += '\n';
+
+    // Time axis with the start on the left and the end on the right
+    const std::string start = "0";
+    const std::string end = formatDuration(
+        static_cast<int64_t>(samples_.size()) * samplingRateUs_);
+    output += start;
+    if (width > start.length() + end.length()) {
+        output.append(width - start.length() - end.length(), ' ');
+    } else {
+        output += ' ';
+    }
+    output += end + '\n';
+
+    return output;
+}
+
+/**
+ * The width is taken from the terminal if stdout is connected to one,
+ * otherwise from the COLUMNS environment variable.
+ *
+ * @return Number of terminal columns.
+ */
+size_t ScanRenderer::getTerminalWidth(void) {
+    struct winsize size;
+
+    if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) && (size.ws_col > 0)) {
+        return size.ws_col;
+    }
+
+    const char * columns = getenv("COLUMNS");
+    if ((columns != nullptr) && (atoi(columns) > 0)) {
+        return static_cast<size_t>(atoi(columns));
+    }
+
+    return DEFAULT_TERMINAL_WIDTH;
+}
+
+/// @return Runs of equal samples in chronological order.
+std::vector<ScanRenderer::Run> ScanRenderer::getRuns(void) const {
+    std::vector<Run> runs;
+
+    for (const bool sample : samples_) {
+        if (runs.empty() || (runs.back().level != sample)) {
+            runs.push_back({ sample, 0U });
+        }
+        runs.back().samples++;
+    }
+
+    return runs;
+}
+
+/**
+ * Durations from 10ms on are given in milliseconds, shorter ones in
+ * microseconds.
+ *
+ * @param durationUs Duration (unit: microseconds).
+ * @return Formatted duration.
+ */
+std::string ScanRenderer::formatDuration(const int64_t durationUs) {
+    const int64_t US_PER_MS = 1000;
+
+    if (durationUs >= 10 * US_PER_MS) {
+        return std::to_string(durationUs / US_PER_MS) + "ms";
+    }
+
+    return std::to_string(durationUs) + "us";
+}
@@ -19,11 +19,15 @@
 
 #include <cassert>
 #include <iostream>
-#include <unistd.h>
-
-#include <wiringPi.h>
 
+#include "Clock.h"
+#include "Embedded.h"
+#include "Metrics.h"
+#include "ScanParameters.h"
 #include "Target.h"
+#include "TargetIndex.h"
+#include "Timings.h"
+#include "Transmitter.h"
 
 /**
  * @param configuration Reference of the configuration.
@@ -32,190 +36,154 @@
 Target::Target(Configuration & configuration, const std::string & name) :
         Task(configuration),
         name_(name),
-        parameters_(nullptr) {
+        pulses_(nullptr),
+        pulseCount_(0U),
+        sendCommand_(Types::INVALID_PARAMETER),
+        sendDelayUs_(Types::INVALID_PARAMETER),
+        frameToleranceUs_(Types::INVALID_PARAMETER),
+        maxRetransmissions_(0),
+        listenBeforeTalkUs_(Types::INVALID_PARAMETER),
+        senseGpioPin_(Types::INVALID_GPIO_PIN) {
     // Do nothing
 }
 
 /// @return Program exit code.
 int Target::start(void) {
-    // Check whether the target exists
-    if (!configuration_.isValidSection(name_)) {
-        std::cerr << "Error: Given target " << name_ << " cannot be found"
-            << std::endl;
-        return EXIT_FAILURE;
-    }
-
-    assert(parameters_ == nullptr);
-    parameters_ = std::make_unique<TargetParameters>(
-        TargetParameters(configuration_, name_));
+    uint8_t gpioPin;
 
-    // Load all parameters from the configuration
-    if (!parameters_->load()) {
+    // Look up the resolved parameters of the target
+    if (!load(gpioPin)) {
         return EXIT_FAILURE;
     }
+    Timings::mark("parameters");
 
     // Get GPIO from the parameters unless overridden from the command line
     if (gpioPin_ == Types::INVALID_GPIO_PIN) {
-        gpioPin_ = parameters_->getGpioPin();
+        gpioPin_ = gpioPin;
     } else if (!isValidGpioPin(gpioPin_)) {
         std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
             << std::endl;
         return EXIT_FAILURE;
     }
 
-    // Send the radio frame to control the target
-    airControl();
-
-    return EXIT_SUCCESS;
-}
-
-void Target::airControl(void) const {
-    void (Target::*sendAirCommand)(void) const = nullptr;
-
-    switch (parameters_->getAirCode()) {
-        case Types::AirCode::MANCHESTER:
-            sendAirCommand = &Target::sendAirCommandManchester;
-            break;
-
-        case Types::AirCode::REMOTE_CONTROLLED_OUTLET:
-            sendAirCommand = &Target::sendAirCommandRemoteControlledOutled;
-            break;
-
-        case Types::AirCode::TORMATIC:
-            sendAirCommand = &Target::sendAirCommandTormatic;
-            break;
-
-        case Types::AirCode::MELITEC:
-            sendAirCommand = &Target::sendAirCommandMelitec;
-            break;
+    // Sense the channel with the air scan receiver if requested
+    if (listenBeforeTalkUs_ != Types::INVALID_PARAMETER) {
+        ScanParameters scanParameters(configuration_);
+        if (!scanParameters.load()) {
+            return EXIT_FAILURE;
+        }
+        senseGpioPin_ = scanParameters.getGpioPin();
+        if (senseGpioPin_ == gpioPin_) {
+            std::cerr << "Error: Transmitter and receiver must not use the "
+                "same GPIO pin " << +gpioPin_ << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
 
-        case Types::AirCode::MAX:
-        default:
-            assert(false);
-            break;
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
     }
 
-    pinMode(gpioPin_, OUTPUT);
+    // Wait until the duty cycle budget of the GPIO pin allows transmitting,
+    // the airtime of all regular frames is reserved upfront
+    const int64_t frameAirtimeNs = Transmitter::getAirtime(pulses_,
+        pulseCount_);
+    if (!reserveAirtime(frameAirtimeNs * sendCommand_)) {
+        return EXIT_FAILURE;
+    }
 
-    for (auto n = 0; n < parameters_->getSendCommand(); n++) {
-        (this->*sendAirCommand)();
+    // Send the radio frame to control the target
+    const uint32_t frames = airControl();
 
-        if (n != parameters_->getSendCommand() - 1) {
-            digitalWrite(gpioPin_, LOW);
-            usleep(parameters_->getSendDelay());
-        }
+    // Account retransmitted or skipped frames
+    if (!adjustAirtime(frameAirtimeNs * (static_cast<int64_t>(frames)
+            - sendCommand_))) {
+        return EXIT_FAILURE;
     }
 
-    pinMode(gpioPin_, INPUT);
+    return EXIT_SUCCESS;
 }
 
-
-void Target::sendAirCommandManchester(void) const {
-    assert(parameters_->getAirCode() == Types::AirCode::MANCHESTER);
-
-    for (auto i = 0U; i < parameters_->getAirCommand().length(); i++) {
-        switch (parameters_->getAirCommand().at(i)) {
-            case 's':
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getSyncLength());
-                break;
-
-            case 'S':
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getSyncLength());
-                break;
-
-            case '0':
-                // Falling edge in the middle of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 2);
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getDataLength() / 2);
-                break;
-
-            case '1':
-                // Rising edge in the middle of the pulse
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getDataLength() / 2);
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 2);
-                break;
-        }
+/**
+ * Embedded targets are preferred, they neither require parsing the
+ * configuration nor any heap allocation.
+ *
+ * @param gpioPin Place to store the configured GPIO pin to.
+ * @return True if the target has been loaded, false otherwise.
+ */
+bool Target::load(uint8_t & gpioPin) {
+    assert(pulses_ == nullptr);
+
+    const Embedded::Target * embedded = Embedded::find(name_);
+    if (embedded != nullptr) {
+        gpioPin = embedded->gpioPin;
+        pulses_ = embedded->pulses;
+        pulseCount_ = embedded->pulseCount;
+        sendCommand_ = embedded->sendCommand;
+        sendDelayUs_ = embedded->sendDelayUs;
+        frameToleranceUs_ = embedded->frameToleranceUs;
+        maxRetransmissions_ = embedded->maxRetransmissions;
+        listenBeforeTalkUs_ = embedded->listenBeforeTalkUs;
+        dutyCyclePpm_ = embedded->dutyCyclePpm;
+        dutyCycleWindowS_ = embedded->dutyCycleWindowS;
+        return true;
     }
-}
 
-void Target::sendAirCommandRemoteControlledOutled(void) const {
-    assert(parameters_->getAirCode()
-        == Types::AirCode::REMOTE_CONTROLLED_OUTLET);
-
-    for (auto i = 0U; i < parameters_->getAirCommand().length(); i++) {
-        switch (parameters_->getAirCommand().at(i)) {
-            case '0':
-                // Falling edge after 25% of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 4);
-                digitalWrite(gpioPin_, LOW);
-                usleep((parameters_->getDataLength() / 4) * 3);
-                break;
-
-            case '1':
-                // Falling edge after 75% of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep((parameters_->getDataLength() / 4) * 3);
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getDataLength() / 4);
-                break;
-        }
+    // Parameters are owned by the target index of the configuration
+    const TargetParameters * parameters =
+        configuration_.getTargetIndex().find(name_);
+    if (parameters == nullptr) {
+        return false;
     }
-}
 
-void Target::sendAirCommandTormatic(void) const {
-    assert(parameters_->getAirCode() == Types::AirCode::TORMATIC);
-
-    for (auto i = 0U; i < parameters_->getAirCommand().length(); i++) {
-        switch (parameters_->getAirCommand().at(i)) {
-            case '0':
-                // Falling edge after 33% of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 3);
-                digitalWrite(gpioPin_, LOW);
-                usleep((parameters_->getDataLength() / 3) * 2);
-                break;
-
-            case '1':
-                // Falling edge after 33% of the pulse, another rising edge
-                // after 66%
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 3);
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getDataLength() / 3);
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 3);
-                break;
-        }
-    }
+    gpioPin = parameters->getGpioPin();
+    pulses_ = parameters->getPulses().data();
+    pulseCount_ = parameters->getPulses().size();
+    sendCommand_ = parameters->getSendCommand();
+    sendDelayUs_ = parameters->getSendDelay();
+    frameToleranceUs_ = parameters->getFrameTolerance();
+    maxRetransmissions_ = parameters->getMaxRetransmissions();
+    listenBeforeTalkUs_ = parameters->getListenBeforeTalk();
+    dutyCyclePpm_ = parameters->getDutyCycle();
+    dutyCycleWindowS_ = parameters->getDutyCycleWindow();
+
+    return true;
 }
 
-void Target::sendAirCommandMelitec(void) const {
-    assert(parameters_->getAirCode() == Types::AirCode::MELITEC);
-
-    for (auto i = 0U; i < parameters_->getAirCommand().length(); i++) {
-        switch (parameters_->getAirCommand().at(i)) {
-            case '0':
-                // Falling edge after 33% of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep(parameters_->getDataLength() / 3);
-                digitalWrite(gpioPin_, LOW);
-                usleep((parameters_->getDataLength() / 3) * 2);
-                break;
-
-            case 'S':
-                // Falling edge after 66% of the pulse
-                digitalWrite(gpioPin_, HIGH);
-                usleep((parameters_->getSyncLength() / 3) * 2);
-                digitalWrite(gpioPin_, LOW);
-                usleep(parameters_->getSyncLength() / 3);
-                break;
-        }
+/**
+ * If a frame tolerance is configured, the frame statistics are reported after
+ * the transmission. The same applies to the channel statistics if the channel
+ * is sensed.
+ *
+ * @return Number of frames sent, including retransmissions.
+ */
+uint32_t Target::airControl(void) const {
+    Transmitter transmitter(gpioPin_);
+    if (senseGpioPin_ != Types::INVALID_GPIO_PIN) {
+        transmitter.setCarrierSense(senseGpioPin_, listenBeforeTalkUs_);
     }
+    const int64_t startNs = Clock::now();
+
+    const bool isChecked = (frameToleranceUs_ != Types::INVALID_PARAMETER);
+    const Transmitter::Statistics statistics = transmitter.transmit(pulses_,
+        pulseCount_, sendCommand_, sendDelayUs_,
+        isChecked ? frameToleranceUs_ * Clock::NS_PER_US : -1,
+        static_cast<uint32_t>(maxRetransmissions_));
+    Metrics::addTransmission(name_, statistics, Clock::now() - startNs);
+
+    if (isChecked) {
+        std::cout << "Frames: " << statistics.frames - statistics.badFrames
+            << " good, " << statistics.badFrames << " bad, "
+            << statistics.retransmissions << " retransmitted, worst edge "
+            "error " << statistics.maxEdgeErrorNs / Clock::NS_PER_US << "us"
+            << std::endl;
+    }
+    if (senseGpioPin_ != Types::INVALID_GPIO_PIN) {
+        std::cout << "Channel: " << statistics.backoffs << " backoffs, "
+            << statistics.busyFrames << " frames sent into a busy channel"
+            << std::endl;
+    }
+
+    return statistics.frames;
 }
@@ -0,0 +1,396 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "TargetCache.h"
+
+const std::string TargetCache::SUFFIX = ".cache";
+
+/// @param configuration Reference of the configuration.
+TargetCache::TargetCache(const Configuration & configuration) :
+        configuration_(configuration),
+        fingerprint_(),
+        data_(nullptr),
+        size_(0U) {
+    // Do nothing
+}
+
+TargetCache::~TargetCache(void) {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t *>(data_), size_);
+    }
+}
+
+/// @return True if an up to date cache file has been mapped, false otherwise.
+bool TargetCache::open(void) {
+    if (data_ != nullptr) {
+        return true;
+    }
+
+    if (!loadFingerprint()) {
+        return false;
+    }
+
+    const int fd = ::open(getLocation().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat status;
+    if ((fstat(fd, &status) != 0)
+            || (static_cast<size_t>(status.st_size) < sizeof(Header))) {
+        close(fd);
+        return false;
+    }
+
+    void * data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd,
+        0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(data);
+    size_ = status.st_size;
+
+    // Check whether the cache file belongs to the configuration file
+    Header header;
+    memcpy(&header, data_, sizeof(header));
+    const uint64_t tableSize = sizeof(Header)
+        + uint64_t(header.bucketCount) * sizeof(uint32_t)
+        + uint64_t(header.recordCount) * sizeof(Record);
+    if ((header.signature != SIGNATURE) || (header.version != VERSION)
+            || (header.modificationTimeS != fingerprint_.modificationTimeS)
+            || (header.modificationTimeNs != fingerprint_.modificationTimeNs)
+            || (header.size != fingerprint_.size)
+            || (header.hash != fingerprint_.hash)
+            || (header.bucketCount == 0U)
+            || ((header.bucketCount & (header.bucketCount - 1U)) != 0U)
+            || !isValidRange(0U, tableSize)) {
+        munmap(data, size_);
+        data_ = nullptr;
+        size_ = 0U;
+        return false;
+    }
+
+    return true;
+}
+
+/// @return True if the cache file has been mapped, false otherwise.
+bool TargetCache::isOpen(void) const {
+    return data_ != nullptr;
+}
+
+/**
+ * @param name Target name.
+ * @param parameters Parameters to be restored, only if the target is valid.
+ * @param error Error message, only if the target is invalid.
+ * @return True if the target has been found, false otherwise.
+ */
+bool TargetCache::find(const std::string & name, TargetParameters & parameters,
+        std::string & error) const {
+    Header header;
+
+    if (data_ == nullptr) {
+        return false;
+    }
+    memcpy(&header, data_, sizeof(header));
+
+    const uint8_t * buckets = data_ + sizeof(Header);
+    const uint8_t * records = buckets
+        + header.bucketCount * sizeof(uint32_t);
+    const uint64_t nameHash = hash(name.data(), name.length());
+
+    // Linear probing, the table always contains empty buckets
+    for (uint32_t probe = 0U; probe < header.bucketCount; probe++) {
+        const uint32_t bucket = (nameHash + probe)
+            & (header.bucketCount - 1U);
+        uint32_t slot;
+        memcpy(&slot, buckets + bucket * sizeof(slot), sizeof(slot));
+        if ((slot == 0U) || (slot > header.recordCount)) {
+            return false;
+        }
+
+        Record record;
+        memcpy(&record, records + (slot - 1U) * sizeof(record),
+            sizeof(record));
+        if ((record.nameHash != nameHash)
+                || (record.nameLength != name.length())
+                || !isValidRange(record.nameOffset, record.nameLength)
+                || (memcmp(data_ + record.nameOffset, name.data(),
+                    name.length()) != 0)) {
+            continue;
+        }
+
+        if (!isValidRange(record.errorOffset, record.errorLength)
+                || !isValidRange(record.encodingOffset,
+                    record.encodingLength)
+                || !isValidRange(record.airCommandOffset,
+                    record.airCommandLength)
+                || !isValidRange(record.pulsesOffset,
+                    uint64_t(record.pulseCount) * sizeof(Types::Pulse))) {
+            return false;
+        }
+
+        if (record.errorLength != 0U) {
+            error.assign(reinterpret_cast<const char *>(data_)
+                + record.errorOffset, record.errorLength);
+            return true;
+        }
+
+        parameters.gpioPin_ = static_cast<uint8_t>(record.gpioPin);
+        parameters.dataLengthUs_ = record.dataLengthUs;
+        parameters.syncLengthUs_ = record.syncLengthUs;
+        parameters.airCode_ = static_cast<Types::AirCode::AirCode_>(
+            record.airCode);
+        parameters.encodingName_.assign(reinterpret_cast<const char *>(data_)
+            + record.encodingOffset, record.encodingLength);
+        parameters.airCommand_.assign(reinterpret_cast<const char *>(data_)
+            + record.airCommandOffset, record.airCommandLength);
+        parameters.sendCommand_ = record.sendCommand;
+        parameters.sendDelayUs_ = record.sendDelayUs;
+        parameters.frameToleranceUs_ = record.frameToleranceUs;
+        parameters.maxRetransmissions_ = record.maxRetransmissions;
+        parameters.listenBeforeTalkUs_ = record.listenBeforeTalkUs;
+        parameters.dutyCyclePpm_ = record.dutyCyclePpm;
+        parameters.dutyCycleWindowS_ = record.dutyCycleWindowS;
+        parameters.pulses_.resize(record.pulseCount);
+        memcpy(parameters.pulses_.data(), data_ + record.pulsesOffset,
+            record.pulseCount * sizeof(Types::Pulse));
+
+        return true;
+    }
+
+    return false;
+}
+
+/// @return Names of all cached targets in no particular order.
+std::vector<std::string> TargetCache::getNames(void) const {
+    std::vector<std::string> names;
+    Header header;
+
+    if (data_ == nullptr) {
+        return names;
+    }
+    memcpy(&header, data_, sizeof(header));
+
+    const uint8_t * records = data_ + sizeof(Header)
+        + header.bucketCount * sizeof(uint32_t);
+    names.reserve(header.recordCount);
+    for (uint32_t i = 0U; i < header.recordCount; i++) {
+        Record record;
+        memcpy(&record, records + i * sizeof(record), sizeof(record));
+        if (isValidRange(record.nameOffset, record.nameLength)) {
+            names.emplace_back(reinterpret_cast<const char *>(data_)
+                + record.nameOffset, record.nameLength);
+        }
+    }
+
+    return names;
+}
+
+/**
+ * The cache file is written to a temporary file first and renamed afterwards,
+ * this way concurrent instances never map a partially written cache file.
+ * Failures are silently ignored, the configuration file will be parsed again.
+ *
+ * @param targets Resolved parameters of all valid targets.
+ * @param errors Error messages of all invalid targets.
+ */
+void TargetCache::write(
+        const std::unordered_map<std::string, TargetParameters> & targets,
+        const std::unordered_map<std::string, std::string> & errors) const {
+    // The fingerprint of the configuration file is unknown
+    if (fingerprint_.signature != SIGNATURE) {
+        return;
+    }
+
+    Header header = fingerprint_;
+    header.recordCount = targets.size() + errors.size();
+    header.bucketCount = 1U;
+    while (header.bucketCount < header.recordCount * 2U) {
+        header.bucketCount *= 2U;
+    }
+
+    std::vector<uint32_t> buckets(header.bucketCount, 0U);
+    std::vector<Record> records;
+    std::string strings;
+    const size_t stringsOffset = sizeof(Header)
+        + header.bucketCount * sizeof(uint32_t)
+        + header.recordCount * sizeof(Record);
+
+    // Append data to the string section, aligned for pulses
+    const auto appendData = [&](const void * data, const size_t length,
+            uint32_t & offset) {
+        strings.resize((strings.length() + alignof(Types::Pulse) - 1U)
+            & ~(alignof(Types::Pulse) - 1U));
+        offset = stringsOffset + strings.length();
+        strings.append(static_cast<const char *>(data), length);
+    };
+
+    const auto insert = [&](const std::string & name, Record & record) {
+        record.nameHash = hash(name.data(), name.length());
+        appendData(name.data(), name.length(), record.nameOffset);
+        record.nameLength = name.length();
+        records.push_back(record);
+
+        uint32_t bucket = record.nameHash & (header.bucketCount - 1U);
+        while (buckets[bucket] != 0U) {
+            bucket = (bucket + 1U) & (header.bucketCount - 1U);
+        }
+        buckets[bucket] = records.size();
+    };
+
+    for (const auto & target : targets) {
+        const TargetParameters & parameters = target.second;
+        Record record = {};
+
+        appendData(parameters.encodingName_.data(),
+            parameters.encodingName_.length(), record.encodingOffset);
+        record.encodingLength = parameters.encodingName_.length();
+        appendData(parameters.airCommand_.data(),
+            parameters.airCommand_.length(), record.airCommandOffset);
+        record.airCommandLength = parameters.airCommand_.length();
+        appendData(parameters.pulses_.data(),
+            parameters.pulses_.size() * sizeof(Types::Pulse),
+            record.pulsesOffset);
+        record.pulseCount = parameters.pulses_.size();
+        record.gpioPin = parameters.gpioPin_;
+        record.airCode = parameters.airCode_;
+        record.dataLengthUs = parameters.dataLengthUs_;
+        record.syncLengthUs = parameters.syncLengthUs_;
+        record.sendCommand = parameters.sendCommand_;
+        record.sendDelayUs = parameters.sendDelayUs_;
+        record.frameToleranceUs = parameters.frameToleranceUs_;
+        record.maxRetransmissions = parameters.maxRetransmissions_;
+        record.listenBeforeTalkUs = parameters.listenBeforeTalkUs_;
+        record.dutyCyclePpm = parameters.dutyCyclePpm_;
+        record.dutyCycleWindowS = parameters.dutyCycleWindowS_;
+        insert(target.first, record);
+    }
+
+    for (const auto & error : errors) {
+        Record record = {};
+
+        appendData(error.second.data(), error.second.length(),
+            record.errorOffset);
+        record.errorLength = error.second.length();
+        insert(error.first, record);
+    }
+
+    // Write the cache file
+    const std::string location = getLocation();
+    const std::string temporaryLocation = location + "."
+        + std::to_string(getpid());
+    std::ofstream cacheFile(temporaryLocation, std::ios::out
+        | std::ios::binary | std::ios::trunc);
+    if (!cacheFile.is_open()) {
+        return;
+    }
+
+    cacheFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    cacheFile.write(reinterpret_cast<const char *>(buckets.data()),
+        buckets.size() * sizeof(uint32_t));
+    cacheFile.write(reinterpret_cast<const char *>(records.data()),
+        records.size() * sizeof(Record));
+    cacheFile.write(strings.data(), strings.length());
+    cacheFile.close();
+
+    if (!cacheFile || (rename(temporaryLocation.c_str(), location.c_str())
+            != 0)) {
+        unlink(temporaryLocation.c_str());
+    }
+}
+
+/// @return Cache file location.
+std::string TargetCache::getLocation(void) const {
+    return configuration_.getLocation() + SUFFIX;
+}
+
+/// @return True if the fingerprint has been determined, false otherwise.
+bool TargetCache::loadFingerprint(void) {
+    const int fd = ::open(configuration_.getLocation().c_str(),
+        O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return false;
+    }
+
+    fingerprint_ = {};
+    fingerprint_.modificationTimeS = status.st_mtim.tv_sec;
+    fingerprint_.modificationTimeNs = status.st_mtim.tv_nsec;
+    fingerprint_.size = status.st_size;
+    fingerprint_.hash = hash(nullptr, 0U);
+
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        fingerprint_.hash = hash(buffer, length, fingerprint_.hash);
+    }
+    close(fd);
+    if (length < 0) {
+        return false;
+    }
+
+    fingerprint_.signature = SIGNATURE;
+    fingerprint_.version = VERSION;
+
+    return true;
+}
+
+/**
+ * @param offset File offset of the range.
+ * @param length Length of the range.
+ * @return True if the range lies within the cache file, false otherwise.
+ */
+bool TargetCache::isValidRange(const uint64_t offset,
+        const uint64_t length) const {
+    return (offset <= size_) && (length <= size_ - offset);
+}
+
+/**
+ * @param data Data to be hashed.
+ * @param length Length of the data.
+ * @param seed Hash of the preceding data or the FNV offset basis.
+ * @return FNV-1a hash.
+ */
+uint64_t TargetCache::hash(const void * data, const size_t length,
+        uint64_t seed) {
+    const uint8_t * bytes = static_cast<const uint8_t *>(data);
+
+    for (size_t i = 0U; i < length; i++) {
+        seed = (seed ^ bytes[i]) * 0x100000001B3U;
+    }
+
+    return seed;
+}
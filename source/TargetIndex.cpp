@@ -0,0 +1,152 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string.h>
+
+#include "TargetIndex.h"
+
+const char * const TargetIndex::RESERVED_SECTIONS[] = { "encodings",
+    "replay", "scan", "target" };
+
+/// @param configuration Reference of the configuration.
+TargetIndex::TargetIndex(const Configuration & configuration) :
+        configuration_(configuration),
+        cache_(configuration),
+        encodings_(configuration),
+        targets_(),
+        errors_() {
+    // Do nothing
+}
+
+/**
+ * @param useCache True to use the target cache, false to always resolve the
+ *                 targets from the configuration without writing the cache.
+ */
+void TargetIndex::build(const bool useCache) {
+    targets_.clear();
+    errors_.clear();
+
+    // Targets are restored on demand from an up to date cache
+    if (useCache && cache_.open()) {
+        return;
+    }
+
+    const libconfig::Setting & root = configuration_.getRoot();
+    const libconfig::Setting * defaults = configuration_.getSection("target");
+
+    encodings_.build();
+    targets_.reserve(root.getLength());
+
+    for (auto i = 0; i < root.getLength(); i++) {
+        const libconfig::Setting & section = root[i];
+
+        if (!section.isGroup() || isReservedSection(section.getName())) {
+            continue;
+        }
+
+        // Errors are only reported when the target is actually used
+        std::ostringstream errors;
+        TargetParameters parameters(configuration_, section.getName());
+        if (parameters.load(&section, defaults, encodings_, errors)) {
+            targets_.emplace(parameters.getName(), parameters);
+        } else {
+            errors_.emplace(parameters.getName(), errors.str());
+        }
+    }
+
+    if (useCache) {
+        cache_.write(targets_, errors_);
+    }
+}
+
+/// @return Names of all targets in no particular order.
+std::vector<std::string> TargetIndex::getNames(void) const {
+    if (cache_.isOpen()) {
+        return cache_.getNames();
+    }
+
+    std::vector<std::string> names;
+    names.reserve(targets_.size() + errors_.size());
+    for (const auto & target : targets_) {
+        names.push_back(target.first);
+    }
+    for (const auto & error : errors_) {
+        names.push_back(error.first);
+    }
+
+    return names;
+}
+
+/**
+ * @param name Target name.
+ * @return Resolved target parameters or nullptr if the target is unknown or
+ *         invalid.
+ */
+const TargetParameters * TargetIndex::find(const std::string & name) const {
+    restore(name);
+
+    const auto target = targets_.find(name);
+    if (target != targets_.end()) {
+        return &target->second;
+    }
+
+    const auto error = errors_.find(name);
+    if (error != errors_.end()) {
+        std::cerr << error->second;
+    } else {
+        std::cerr << "Error: Given target " << name << " cannot be found"
+            << std::endl;
+    }
+
+    return nullptr;
+}
+
+/**
+ * @param name Section name.
+ * @return True if the section does not describe a target, false otherwise.
+ */
+bool TargetIndex::isReservedSection(const char * name) {
+    for (const char * reserved : RESERVED_SECTIONS) {
+        if (strcmp(name, reserved) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @param name Target name.
+void TargetIndex::restore(const std::string & name) const {
+    if (!cache_.isOpen() || (targets_.count(name) != 0U)
+            || (errors_.count(name) != 0U)) {
+        return;
+    }
+
+    std::string error;
+    TargetParameters parameters(configuration_, name);
+    if (cache_.find(name, parameters, error)) {
+        if (error.length() == 0U) {
+            targets_.emplace(name, parameters);
+        } else {
+            errors_.emplace(name, error);
+        }
+    }
+}
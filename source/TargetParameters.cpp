@@ -20,8 +20,12 @@
 #include <cassert>
 #include <iostream>
 
+#include "Clock.h"
+#include "DutyCycle.h"
+#include "Encoder.h"
 #include "TargetParameters.h"
 #include "Task.h"
+#include "Transmitter.h"
 
 /**
  * @param configuration Reference of the configuration.
@@ -31,25 +35,79 @@ TargetParameters::TargetParameters(const Configuration & configuration,
         const std::string & name) :
         configuration_(configuration),
         name_(name),
+        section_(nullptr),
+        defaults_(nullptr),
+        encodings_(nullptr),
+        encoding_(nullptr),
+        errors_(&std::cerr),
         gpioPin_(Types::INVALID_GPIO_PIN),
         dataLengthUs_(Types::INVALID_PARAMETER),
         syncLengthUs_(Types::INVALID_PARAMETER),
         airCode_(Types::AirCode::MAX),
+        encodingName_(),
         airCommand_(),
         sendCommand_(Types::INVALID_PARAMETER),
-        sendDelayUs_(Types::INVALID_PARAMETER) {
+        sendDelayUs_(Types::INVALID_PARAMETER),
+        frameToleranceUs_(Types::INVALID_PARAMETER),
+        maxRetransmissions_(DEFAULT_MAX_RETRANSMISSIONS),
+        listenBeforeTalkUs_(Types::INVALID_PARAMETER),
+        dutyCyclePpm_(Types::INVALID_PARAMETER),
+        dutyCycleWindowS_(DutyCycle::DEFAULT_WINDOW_S),
+        pulses_() {
     // Do nothing
 }
 
 /// @return Status of the operation.
 bool TargetParameters::load(void) {
-    return loadGpioPin()
+    EncodingIndex encodings(configuration_);
+
+    encodings.build();
+    return load(configuration_.getSection(name_),
+        configuration_.getSection("target"), encodings, std::cerr);
+}
+
+/**
+ * @param section Target section, nullptr if it does not exist.
+ * @param defaults Target defaults section, nullptr if it does not exist.
+ * @param encodings Encodings available to the target.
+ * @param errors Stream receiving error messages.
+ * @return Status of the operation.
+ */
+bool TargetParameters::load(const libconfig::Setting * section,
+        const libconfig::Setting * defaults, const EncodingIndex & encodings,
+        std::ostream & errors) {
+    section_ = section;
+    defaults_ = defaults;
+    encodings_ = &encodings;
+    errors_ = &errors;
+
+    const bool status = loadGpioPin()
         && loadDataLength()
         && loadSyncLength()
         && loadAirCode()
         && loadAirCommand()
         && loadSendCommand()
-        && loadSendDelay();
+        && loadSendDelay()
+        && loadFrameTolerance()
+        && loadMaxRetransmissions()
+        && loadListenBeforeTalk()
+        && loadDutyCycle();
+    if (status) {
+        encodeAirCommand();
+    }
+
+    section_ = nullptr;
+    defaults_ = nullptr;
+    encodings_ = nullptr;
+    encoding_ = nullptr;
+    errors_ = &std::cerr;
+
+    return status;
+}
+
+/// @return Target name.
+const std::string & TargetParameters::getName(void) const {
+    return name_;
 }
 
 /// @return GPIO pin.
@@ -70,14 +128,23 @@ int32_t TargetParameters::getSyncLength(void) const {
     return syncLengthUs_;
 }
 
-/// @return Radio frame encoding type to be used.
+/**
+ * @return Radio frame encoding type to be used, Types::AirCode::MAX for
+ *         user-defined encodings.
+ */
 Types::AirCode::AirCode_ TargetParameters::getAirCode(void) const {
-    assert(airCode_ != Types::AirCode::MAX);
+    assert(encodingName_.length() != 0U);
     return airCode_;
 }
 
+/// @return Name of the radio frame encoding to be used.
+const std::string & TargetParameters::getEncoding(void) const {
+    assert(encodingName_.length() != 0U);
+    return encodingName_;
+}
+
 /// @return Sequence string of data and sync elements to be transmitted.
-std::string TargetParameters::getAirCommand(void) const {
+const std::string & TargetParameters::getAirCommand(void) const {
     assert(airCommand_.length() != 0U);
     return airCommand_;
 }
@@ -94,16 +161,56 @@ int32_t TargetParameters::getSendDelay(void) const {
     return sendDelayUs_;
 }
 
+/**
+ * @return Maximum edge error of a frame before it is retransmitted,
+ *         Types::INVALID_PARAMETER if frames are not checked.
+ */
+int32_t TargetParameters::getFrameTolerance(void) const {
+    return frameToleranceUs_;
+}
+
+/// @return Maximum number of retransmitted frames.
+int32_t TargetParameters::getMaxRetransmissions(void) const {
+    return maxRetransmissions_;
+}
+
+/**
+ * @return Time the channel must be idle before every frame,
+ *         Types::INVALID_PARAMETER if the channel is not sensed.
+ */
+int32_t TargetParameters::getListenBeforeTalk(void) const {
+    return listenBeforeTalkUs_;
+}
+
+/**
+ * @return Maximum share of airtime on the GPIO pin in parts per million,
+ *         Types::INVALID_PARAMETER if the airtime is not limited.
+ */
+int32_t TargetParameters::getDutyCycle(void) const {
+    return dutyCyclePpm_;
+}
+
+/// @return Window the duty cycle is averaged over.
+int32_t TargetParameters::getDutyCycleWindow(void) const {
+    return dutyCycleWindowS_;
+}
+
+/// @return Pulse train of a single air command transmission.
+const std::vector<Types::Pulse> & TargetParameters::getPulses(void) const {
+    assert(pulses_.size() != 0U);
+    return pulses_;
+}
+
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadGpioPin(void) {
     int32_t value;
 
-    if (!getValue(name_, "gpioPin", value)) {
+    if (!getValue("gpioPin", value)) {
         return false;
     }
 
     if (!Task::isValidGpioPin(value)) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): gpioPin " << value << " is invalid" << std::endl;
         return false;
     }
@@ -115,16 +222,17 @@ bool TargetParameters::loadGpioPin(void) {
 
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadDataLength(void) {
-    if (!getValue(name_, "dataLength", dataLengthUs_)) {
+    if (!getValue("dataLength", dataLengthUs_)) {
         return false;
     }
 
     if (dataLengthUs_ == Types::INVALID_PARAMETER) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): dataLength is undefined" << std::endl;
         return false;
-    } else if (dataLengthUs_ <= 0) {
-        std::cerr << "Error: Configuration error (target " << name_
+    } else if ((dataLengthUs_ <= 0)
+            || (dataLengthUs_ > Types::MAX_PULSE_LENGTH_US)) {
+        *errors_ << "Error: Configuration error (target " << name_
             << "): dataLength is invalid" << std::endl;
         return false;
     }
@@ -134,16 +242,17 @@ bool TargetParameters::loadDataLength(void) {
 
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadSyncLength(void) {
-    if (!getValue(name_, "syncLength", syncLengthUs_)) {
+    if (!getValue("syncLength", syncLengthUs_)) {
         return false;
     }
 
     if (syncLengthUs_ == Types::INVALID_PARAMETER) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): syncLength is undefined" << std::endl;
         return false;
-    } else if (syncLengthUs_ < 0) {
-        std::cerr << "Error: Configuration error (target " << name_
+    } else if ((syncLengthUs_ < 0)
+            || (syncLengthUs_ > Types::MAX_PULSE_LENGTH_US)) {
+        *errors_ << "Error: Configuration error (target " << name_
             << "): syncLength is invalid" << std::endl;
         return false;
     }
@@ -151,19 +260,53 @@ bool TargetParameters::loadSyncLength(void) {
     return true;
 }
 
-/// @return True if successful, false otherwise.
+/**
+ * The air code is either the number of a built-in encoding type or the name of
+ * a built-in or user-defined encoding.
+ *
+ * @return True if successful, false otherwise.
+ */
 bool TargetParameters::loadAirCode(void) {
-    int32_t airCode;
+    const libconfig::Setting * setting = getSetting("airCode");
 
-    if (!getValue(name_, "airCode", airCode)) {
+    if (setting == nullptr) {
+        *errors_ << "Error: Missing configuration parameter 'airCode'"
+            << std::endl;
         return false;
     }
-    airCode_ = static_cast<Types::AirCode::AirCode_>(airCode);
 
-    if (airCode_ >= Types::AirCode::MAX) {
-        std::cerr << "Error: Configuration error (target " << name_
-            << "): airCode is invalid" << std::endl;
-        return false;
+    if (setting->isString()) {
+        std::string error;
+
+        encoding_ = encodings_->find(setting->c_str(), error);
+        if (encoding_ == nullptr) {
+            *errors_ << "Error: Configuration error (target " << name_
+                << "): airCode is invalid, " << error << std::endl;
+            return false;
+        }
+    } else {
+        int32_t airCode = Types::AirCode::MAX;
+        if (setting->getType() == libconfig::Setting::TypeInt) {
+            airCode = *setting;
+        }
+
+        if ((airCode < 0) || (airCode >= Types::AirCode::MAX)) {
+            *errors_ << "Error: Configuration error (target " << name_
+                << "): airCode is invalid" << std::endl;
+            return false;
+        }
+        encoding_ = &Encoder::getBuiltIn(
+            static_cast<Types::AirCode::AirCode_>(airCode));
+    }
+
+    // Remember the type of built-in encodings
+    encodingName_ = encoding_->name;
+    airCode_ = Types::AirCode::MAX;
+    for (auto airCode = 0; airCode < Types::AirCode::MAX; airCode++) {
+        const auto type = static_cast<Types::AirCode::AirCode_>(airCode);
+        if (encoding_ == &Encoder::getBuiltIn(type)) {
+            airCode_ = type;
+        }
     }
 
     return true;
@@ -171,45 +314,23 @@ bool TargetParameters::loadAirCode(void) {
 
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadAirCommand(void) {
-    if (!getValue(name_, "airCommand", airCommand_)) {
+    if (!getValue("airCommand", airCommand_)) {
         return false;
     }
 
     if (airCommand_.length() == 0U) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): airCommand is undefined" << std::endl;
         return false;
-    } else {
-        std::string elements;
-
-        switch (airCode_) {
-            case Types::AirCode::MANCHESTER:
-                elements = "01sS";
-                break;
-
-            case Types::AirCode::REMOTE_CONTROLLED_OUTLET:
-                // Intentional fall-through
-            case Types::AirCode::TORMATIC:
-                elements = "01";
-                break;
-
-            case Types::AirCode::MELITEC:
-                elements = "0S";
-                break;
-
-            case Types::AirCode::MAX:
-            default:
-                assert(false);
-                break;
-        }
+    }
 
-        const size_t position = airCommand_.find_first_not_of(elements);
-        if (position != std::string::npos) {
-            std::cerr << "Error: Configuration error (target " << name_
-                << "): airCommand contains illegal character at position "
-                << position+1 << std::endl;
-            return false;
-        }
+    const size_t position = airCommand_.find_first_not_of(
+        Encoder::getElements(*encoding_));
+    if (position != std::string::npos) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): airCommand contains illegal character at position "
+            << position+1 << std::endl;
+        return false;
     }
 
     return true;
@@ -217,16 +338,16 @@ bool TargetParameters::loadAirCommand(void) {
 
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadSendCommand(void) {
-    if (!getValue(name_, "sendCommand", sendCommand_)) {
+    if (!getValue("sendCommand", sendCommand_)) {
         return false;
     }
 
     if (sendCommand_ == Types::INVALID_PARAMETER) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): sendCommand is undefined" << std::endl;
         return false;
     } else if (sendCommand_ <= 0) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): sendCommand is invalid" << std::endl;
         return false;
     }
@@ -236,15 +357,150 @@ bool TargetParameters::loadSendCommand(void) {
 
 /// @return True if successful, false otherwise.
 bool TargetParameters::loadSendDelay(void) {
-    if (!getValue(name_, "sendDelay", sendDelayUs_)) {
+    if (!getValue("sendDelay", sendDelayUs_)) {
         return false;
     }
 
     if (sendDelayUs_ == Types::INVALID_PARAMETER) {
-        std::cerr << "Error: Configuration error (target " << name_
+        *errors_ << "Error: Configuration error (target " << name_
             << "): sendDelay is undefined" << std::endl;
         return false;
     }
 
     return true;
 }
+
+/**
+ * Frames are only checked against their deadlines if a tolerance is given.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool TargetParameters::loadFrameTolerance(void) {
+    if (getSetting("frameTolerance") == nullptr) {
+        frameToleranceUs_ = Types::INVALID_PARAMETER;
+        return true;
+    }
+
+    if (!getValue("frameTolerance", frameToleranceUs_)) {
+        return false;
+    }
+
+    if ((frameToleranceUs_ < 0)
+            || (frameToleranceUs_ > Types::MAX_PULSE_LENGTH_US)) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): frameTolerance is invalid" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// @return True if successful, false otherwise.
+bool TargetParameters::loadMaxRetransmissions(void) {
+    if (getSetting("maxRetransmissions") == nullptr) {
+        maxRetransmissions_ = DEFAULT_MAX_RETRANSMISSIONS;
+        return true;
+    }
+
+    if (!getValue("maxRetransmissions", maxRetransmissions_)) {
+        return false;
+    }
+
+    if (maxRetransmissions_ < 0) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): maxRetransmissions is invalid" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * The channel is only sensed before every frame if a listen time is given,
+ * it must be long enough to detect a carrier.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool TargetParameters::loadListenBeforeTalk(void) {
+    const int32_t minListenUs = Transmitter::MIN_CARRIER_NS / Clock::NS_PER_US;
+
+    if (getSetting("listenBeforeTalk") == nullptr) {
+        listenBeforeTalkUs_ = Types::INVALID_PARAMETER;
+        return true;
+    }
+
+    if (!getValue("listenBeforeTalk", listenBeforeTalkUs_)) {
+        return false;
+    }
+
+    if ((listenBeforeTalkUs_ < minListenUs)
+            || (listenBeforeTalkUs_ > Types::MAX_PULSE_LENGTH_US)) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): listenBeforeTalk is invalid (minimum " << minListenUs
+            << "us)" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * The duty cycle is given in percent, either as integer or as floating point
+ * value (e.g. 0.1 for 0.1%), and limits the airtime only if given.
+ *
+ * @return True if successful, false otherwise.
+ */
+bool TargetParameters::loadDutyCycle(void) {
+    const libconfig::Setting * setting = getSetting("dutyCycle");
+    if (setting == nullptr) {
+        dutyCyclePpm_ = Types::INVALID_PARAMETER;
+        dutyCycleWindowS_ = DutyCycle::DEFAULT_WINDOW_S;
+        return true;
+    }
+
+    double percent = 0.0;
+    if (setting->isNumber()) {
+        percent = *setting;
+    }
+    if (!setting->isNumber() || (percent <= 0.0) || (percent > 100.0)) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): dutyCycle is invalid" << std::endl;
+        return false;
+    }
+    dutyCyclePpm_ = static_cast<int32_t>(percent * 10000.0 + 0.5);
+    if (dutyCyclePpm_ < 1) {
+        dutyCyclePpm_ = 1;
+    }
+
+    if (getSetting("dutyCycleWindow") == nullptr) {
+        dutyCycleWindowS_ = DutyCycle::DEFAULT_WINDOW_S;
+    } else if (!getValue("dutyCycleWindow", dutyCycleWindowS_)) {
+        return false;
+    } else if (dutyCycleWindowS_ <= 0) {
+        *errors_ << "Error: Configuration error (target " << name_
+            << "): dutyCycleWindow is invalid" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @param name Configuration name.
+ * @return Setting or nullptr if it exists in neither section.
+ */
+const libconfig::Setting * TargetParameters::getSetting(
+        const char * name) const {
+    if ((section_ != nullptr) && section_->exists(name)) {
+        return &(*section_)[name];
+    } else if ((defaults_ != nullptr) && defaults_->exists(name)) {
+        return &(*defaults_)[name];
+    }
+
+    return nullptr;
+}
+
+void TargetParameters::encodeAirCommand(void) {
+    pulses_ = Encoder::encode(*encoding_, airCommand_, dataLengthUs_,
+        syncLengthUs_);
+}
@@ -17,9 +17,16 @@
  * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <iostream>
+
 #include <wiringPi.h>
 
+#include "Clock.h"
+#include "DutyCycle.h"
+#include "InstanceLock.h"
 #include "Task.h"
+#include "Timings.h"
+#include "Trace.h"
 
 /// @param configuration Reference of the configuration.
 Task::Task(Configuration & configuration) :
@@ -61,3 +68,81 @@ bool Task::isValidGpioPin(const uint8_t gpioPin) {
 void Task::setGpioPin(const uint8_t gpioPin) {
     gpioPin_ = gpioPin;
 }
+
+/// @param instanceLock True to lock the GPIO pin before using it.
+void Task::setInstanceLock(const bool instanceLock) {
+    instanceLock_ = instanceLock;
+}
+
+/// @return True if the GPIO pin is ready to be used, false otherwise.
+bool Task::lockGpioPin(void) const {
+    if (!instanceLock_) {
+        return true;
+    }
+
+    const bool isLocked = InstanceLock::lock(gpioPin_);
+    Timings::mark("lock");
+    return isLocked;
+}
+
+/**
+ * Every transmitting task reserves its airtime before transmitting, this way
+ * all of them share the budget of the GPIO pin, see DutyCycle. Nothing is
+ * reserved unless a duty cycle is set.
+ *
+ * @param airtimeNs Airtime of the transmission (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool Task::reserveAirtime(const int64_t airtimeNs) const {
+    int64_t waitNs;
+
+    if (dutyCyclePpm_ == Types::INVALID_PARAMETER) {
+        return true;
+    }
+    if (!DutyCycle::reserve(gpioPin_, dutyCyclePpm_, dutyCycleWindowS_,
+            airtimeNs, waitNs)) {
+        return false;
+    }
+
+    if (waitNs > 0) {
+        std::cerr << "Duty cycle: waiting " << (waitNs + Clock::NS_PER_S - 1)
+            / Clock::NS_PER_S << "s for airtime budget" << std::endl;
+
+        const int64_t beginNs = Clock::now();
+        Clock::sleepUntil(beginNs + waitNs);
+        Trace::span("duty cycle wait", beginNs, Clock::now());
+    }
+
+    return true;
+}
+
+/**
+ * Tasks not knowing their airtime upfront take it in chunks while
+ * transmitting, and must not transmit beyond the airtime taken. All of it is
+ * taken unless a duty cycle is set.
+ *
+ * @param airtimeNs Airtime to take (unit: nanoseconds).
+ * @param takenNs Place to store the airtime taken to, 0 if the budget is
+ *                insufficient (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool Task::takeAirtime(const int64_t airtimeNs, int64_t & takenNs) const {
+    if (dutyCyclePpm_ == Types::INVALID_PARAMETER) {
+        takenNs = airtimeNs;
+        return true;
+    }
+
+    return DutyCycle::take(gpioPin_, dutyCyclePpm_, dutyCycleWindowS_,
+        airtimeNs, takenNs);
+}
+
+/**
+ * @param deltaNs Actual minus reserved airtime, e.g. of retransmitted or
+ *                skipped frames (unit: nanoseconds).
+ * @return True if successful, false otherwise.
+ */
+bool Task::adjustAirtime(const int64_t deltaNs) const {
+    return (dutyCyclePpm_ == Types::INVALID_PARAMETER)
+        || DutyCycle::adjust(gpioPin_, dutyCyclePpm_, dutyCycleWindowS_,
+            deltaNs);
+}
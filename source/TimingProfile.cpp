@@ -0,0 +1,171 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+
+#include <libconfig.h++>
+#include <wiringPi.h>
+
+#include "TimingProfile.h"
+
+const std::string TimingProfile::LOCATION = "/etc/aircontrol.calibration";
+
+/**
+ * @param sleepOvershootNs Sleep overshoot (unit: nanoseconds).
+ * @param gpioWriteNs GPIO write duration (unit: nanoseconds).
+ * @param clockReadNs Clock read duration (unit: nanoseconds).
+ * @param samplingRateUs Sustainable air scan sampling rate (unit:
+ *                       microseconds), 0 if unknown.
+ */
+TimingProfile::TimingProfile(const int32_t sleepOvershootNs,
+        const int32_t gpioWriteNs, const int32_t clockReadNs,
+        const int32_t samplingRateUs) :
+        sleepOvershootNs_(sleepOvershootNs),
+        gpioWriteNs_(gpioWriteNs),
+        clockReadNs_(clockReadNs),
+        samplingRateUs_(samplingRateUs) {
+    // Do nothing
+}
+
+/**
+ * A missing profile file results in a profile without any compensation.
+ *
+ * @return Profile of this host.
+ */
+const TimingProfile & TimingProfile::get(void) {
+    static TimingProfile profile(0, 0, 0, 0);
+    static bool isLoaded = false;
+
+    if (!isLoaded) {
+        isLoaded = true;
+        if ((access(LOCATION.c_str(), F_OK) == 0) && !profile.load()) {
+            profile = TimingProfile(0, 0, 0, 0);
+        }
+    }
+
+    return profile;
+}
+
+/// @return True if successful, false otherwise.
+bool TimingProfile::save(void) const {
+    std::ofstream file(LOCATION, std::ios::out | std::ios::trunc);
+
+    file << "// Timing profile of this host, generated by 'aircontrol "
+        "--calibrate'. All values" << std::endl
+        << "// are given in nanoseconds." << std::endl
+        << std::endl
+        << "// Board revision the profile has been measured on." << std::endl
+        << "boardRevision = " << piBoardRev() << ";" << std::endl
+        << std::endl
+        << "// Time a sleep ends after its deadline." << std::endl
+        << "sleepOvershoot = " << sleepOvershootNs_ << ";" << std::endl
+        << std::endl
+        << "// Duration of writing a GPIO pin." << std::endl
+        << "gpioWrite = " << gpioWriteNs_ << ";" << std::endl
+        << std::endl
+        << "// Duration of reading the clock (spin loop iteration)."
+        << std::endl
+        << "clockRead = " << clockReadNs_ << ";" << std::endl;
+    if (samplingRateUs_ > 0) {
+        file << std::endl
+            << "// Shortest sustainable air scan sampling rate, generated by "
+            "'aircontrol" << std::endl
+            << "// --probe' (unit: microseconds)." << std::endl
+            << "samplingRate = " << samplingRateUs_ << ";" << std::endl;
+    }
+    file.close();
+
+    if (!file) {
+        std::cerr << "Error: Unable to write timing profile (" << LOCATION
+            << ")" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// @return Sleep overshoot (unit: nanoseconds).
+int32_t TimingProfile::getSleepOvershoot(void) const {
+    return sleepOvershootNs_;
+}
+
+/// @return GPIO write duration (unit: nanoseconds).
+int32_t TimingProfile::getGpioWrite(void) const {
+    return gpioWriteNs_;
+}
+
+/// @return Clock read duration (unit: nanoseconds).
+int32_t TimingProfile::getClockRead(void) const {
+    return clockReadNs_;
+}
+
+/// @return Sustainable sampling rate (unit: microseconds), 0 if unknown.
+int32_t TimingProfile::getSamplingRate(void) const {
+    return samplingRateUs_;
+}
+
+/// @return True if successful, false otherwise.
+bool TimingProfile::load(void) {
+    libconfig::Config profile;
+    int boardRevision;
+
+    try {
+        profile.readFile(LOCATION.c_str());
+    } catch (const libconfig::FileIOException & exception) {
+        std::cerr << "Warning: Timing profile (" << LOCATION << ") cannot be "
+            "read, timing is not compensated" << std::endl;
+        return false;
+    } catch (const libconfig::ParseException & exception) {
+        std::cerr << "Warning: Timing profile (" << exception.getFile() << ":"
+            << exception.getLine() << "): " << exception.getError()
+            << ", timing is not compensated" << std::endl;
+        return false;
+    }
+
+    const libconfig::Setting & root = profile.getRoot();
+    if (!root.lookupValue("boardRevision", boardRevision)
+            || !root.lookupValue("sleepOvershoot", sleepOvershootNs_)
+            || !root.lookupValue("gpioWrite", gpioWriteNs_)
+            || !root.lookupValue("clockRead", clockReadNs_)
+            || (sleepOvershootNs_ < 0) || (gpioWriteNs_ < 0)
+            || (clockReadNs_ < 0)) {
+        std::cerr << "Warning: Timing profile (" << LOCATION << ") is "
+            "invalid, timing is not compensated" << std::endl;
+        return false;
+    }
+
+    // The sampling rate is optional, it is only stored by the probe
+    if (!root.lookupValue("samplingRate", samplingRateUs_)
+            || (samplingRateUs_ < 0)) {
+        samplingRateUs_ = 0;
+    }
+
+    // The profile might have been copied along with the SD card
+    if (boardRevision != piBoardRev()) {
+        std::cerr << "Warning: Timing profile (" << LOCATION << ") has been "
+            "measured on another board revision, timing is not compensated"
+            << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+#include "Clock.h"
+#include "Timings.h"
+
+bool Timings::isEnabled_ = false;
+std::string Timings::file_;
+const char * Timings::phases_[MAX_MARKS];
+int64_t Timings::timesNs_[MAX_MARKS];
+size_t Timings::count_ = 0U;
+
+void Timings::enable(const std::string & file) {
+    isEnabled_ = true;
+    file_ = file;
+}
+
+/**
+ * Marks exceeding the table size are dropped.
+ *
+ * @param phase Phase name, must be a string literal.
+ */
+void Timings::mark(const char * phase) {
+    if (count_ >= MAX_MARKS) {
+        return;
+    }
+
+    timesNs_[count_] = Clock::now();
+    phases_[count_] = phase;
+    count_++;
+}
+
+/**
+ * The report consists of a header line followed by one line per phase with
+ * the phase name, the duration of the phase and the time since the process
+ * has been started, both in milliseconds, separated by tabs.
+ */
+void Timings::report(void) {
+    if (!isEnabled_ || (count_ == 0U)) {
+        return;
+    }
+
+    std::ostringstream report;
+    const int64_t startNs = getStartTime();
+    const double NS_PER_MS = 1000000.0;
+
+    report << std::fixed << std::setprecision(3)
+        << "# phase\tphaseMs\ttotalMs" << std::endl;
+    for (auto i = 0U; i < count_; i++) {
+        const int64_t previousNs = (i == 0U) ? startNs : timesNs_[i - 1U];
+        report << phases_[i] << "\t"
+            << (timesNs_[i] - previousNs) / NS_PER_MS << "\t"
+            << (timesNs_[i] - startNs) / NS_PER_MS << std::endl;
+    }
+
+    if (file_.empty()) {
+        std::cerr << report.str();
+        return;
+    }
+
+    std::ofstream file(file_, std::ios::out | std::ios::app);
+    if (!file.is_open() || !(file << report.str())) {
+        std::cerr << "Error: Timings cannot be written to file '" << file_
+            << "': " << strerror(errno) << std::endl;
+    }
+}
+
+/**
+ * The start time is read from /proc in clock ticks since boot and converted to
+ * the monotonic clock. If it is unavailable the first mark is used instead.
+ *
+ * @return Monotonic time the process has been started at (unit:
+ *         nanoseconds).
+ */
+int64_t Timings::getStartTime(void) {
+    std::ifstream stat("/proc/self/stat");
+    std::string content;
+
+    if (!std::getline(stat, content)) {
+        return timesNs_[0];
+    }
+
+    // Skip the command name which may contain spaces, the start time is the
+    // 20th field following it
+    std::istringstream fields(content.substr(content.rfind(')') + 1U));
+    std::string field;
+    for (auto i = 0; (i < 19) && (fields >> field); i++) {
+        // Do nothing
+    }
+
+    long long startTicks;
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (!(fields >> startTicks) || (ticksPerSecond <= 0)) {
+        return timesNs_[0];
+    }
+
+    // The boot time clock counts from boot, the monotonic clock does not
+    // include suspended periods
+    struct timespec bootTime;
+    clock_gettime(CLOCK_BOOTTIME, &bootTime);
+    const int64_t bootNs = bootTime.tv_sec * Clock::NS_PER_S
+        + bootTime.tv_nsec;
+
+    return Clock::now() - bootNs
+        + (startTicks * Clock::NS_PER_S) / ticksPerSecond;
+}
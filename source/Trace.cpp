@@ -0,0 +1,123 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "Clock.h"
+#include "Trace.h"
+
+bool Trace::isEnabled_ = false;
+std::string Trace::file_;
+std::vector<Trace::Event> Trace::events_;
+uint64_t Trace::droppedEvents_ = 0U;
+
+/// @param file File to write the timeline to.
+void Trace::enable(const std::string & file) {
+    events_.reserve(MAX_EVENTS);
+    file_ = file;
+    isEnabled_ = true;
+}
+
+/**
+ * @param name Span name, must be a string literal.
+ * @param beginNs Monotonic time the span began at (unit: nanoseconds).
+ * @param endNs Monotonic time the span ended at (unit: nanoseconds).
+ * @param argument Name of the argument, must be a string literal or nullptr.
+ * @param value Value of the argument.
+ */
+void Trace::span(const char * name, const int64_t beginNs,
+        const int64_t endNs, const char * argument, const int64_t value) {
+    if (isEnabled_) {
+        record({ name, argument, beginNs, endNs - beginNs, value });
+    }
+}
+
+/**
+ * @param name Counter name, must be a string literal.
+ * @param timeNs Monotonic time of the value (unit: nanoseconds).
+ * @param value Counter value.
+ */
+void Trace::counter(const char * name, const int64_t timeNs,
+        const int64_t value) {
+    if (isEnabled_) {
+        record({ name, nullptr, timeNs, -1, value });
+    }
+}
+
+/**
+ * Timestamps are given in microseconds of the monotonic clock, counters in
+ * nanoseconds. The number of dropped events is stored in the metadata.
+ *
+ * @return True if successful or tracing is disabled, false otherwise.
+ */
+bool Trace::write(void) {
+    if (!isEnabled_) {
+        return true;
+    }
+
+    const double NS_PER_US = Clock::NS_PER_US;
+    const pid_t pid = getpid();
+    std::ofstream file(file_, std::ios::out | std::ios::trunc);
+
+    file << std::fixed << std::setprecision(3)
+        << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":"
+        << droppedEvents_ << "},\"traceEvents\":[" << std::endl
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"tid\":" << pid << ",\"args\":{\"name\":\"aircontrol\"}}";
+    for (const Event & event : events_) {
+        file << "," << std::endl
+            << "{\"name\":\"" << event.name << "\",\"pid\":" << pid
+            << ",\"tid\":" << pid << ",\"ts\":" << event.timeNs / NS_PER_US;
+        if (event.durationNs < 0) {
+            file << ",\"ph\":\"C\",\"args\":{\"ns\":" << event.value << "}}";
+        } else {
+            file << ",\"ph\":\"X\",\"dur\":" << event.durationNs / NS_PER_US;
+            if (event.argument != nullptr) {
+                file << ",\"args\":{\"" << event.argument << "\":"
+                    << event.value << "}";
+            }
+            file << "}";
+        }
+    }
+    file << std::endl << "]}" << std::endl;
+    file.close();
+
+    if (!file) {
+        std::cerr << "Error: Unable to write trace file (" << file_ << "): "
+            << strerror(errno) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// @param event Event to record.
+void Trace::record(const Event & event) {
+    if (events_.size() < events_.capacity()) {
+        events_.push_back(event);
+    } else {
+        droppedEvents_++;
+    }
+}
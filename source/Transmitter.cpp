@@ -0,0 +1,370 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <wiringPi.h>
+
+#include "Clock.h"
+#include "Receiver.h"
+#include "Timings.h"
+#include "Trace.h"
+#include "Transmitter.h"
+
+/**
+ * The timing profile is loaded by the first transmitter.
+ *
+ * @param gpioPin GPIO pin to transmit on.
+ */
+Transmitter::Transmitter(const uint8_t gpioPin) :
+        gpioPin_(gpioPin),
+        profile_(TimingProfile::get()),
+        senseGpioPin_(Types::INVALID_GPIO_PIN),
+        listenNs_(0),
+        random_(static_cast<std::minstd_rand::result_type>(Clock::now())) {
+    // Do nothing
+}
+
+Transmitter::~Transmitter(void) {
+    // Do nothing
+}
+
+/**
+ * Only high pulses are counted, the transmitter is silent during low ones.
+ *
+ * @param pulses Pulse train of a single air command transmission.
+ * @param pulseCount Number of pulses of the pulse train.
+ * @return Airtime of the pulse train (unit: nanoseconds).
+ */
+int64_t Transmitter::getAirtime(const Types::Pulse * pulses,
+        const size_t pulseCount) {
+    int64_t airtimeNs = 0;
+
+    for (size_t i = 0U; i < pulseCount; i++) {
+        if (pulses[i].level != 0U) {
+            airtimeNs += pulses[i].durationNs;
+        }
+    }
+
+    return airtimeNs;
+}
+
+/**
+ * Only high samples are counted, the transmitter is silent during low ones.
+ *
+ * @param samples Air scan samples.
+ * @param samplingRateUs Delay between two samples (unit: microseconds).
+ * @return Airtime of the samples (unit: nanoseconds).
+ */
+int64_t Transmitter::getAirtime(const std::vector<bool> & samples,
+        const int32_t samplingRateUs) {
+    const int64_t highSamples = std::count(samples.begin(), samples.end(),
+        true);
+
+    return highSamples * samplingRateUs * Clock::NS_PER_US;
+}
+
+/**
+ * @param gpioPin GPIO pin connected to a radio receiver.
+ * @param listenUs Time the channel must be idle before every frame (unit:
+ *                 microseconds).
+ */
+void Transmitter::setCarrierSense(const uint8_t gpioPin,
+        const int32_t listenUs) {
+    senseGpioPin_ = gpioPin;
+    listenNs_ = listenUs * Clock::NS_PER_US;
+    pinMode(senseGpioPin_, INPUT);
+}
+
+/**
+ * Edges are scheduled on absolute deadlines, so late wake-ups do not
+ * accumulate over the frame. The pin is driven low between repetitions. A
+ * deadline is missed if a pulse is over before it has been started.
+ *
+ * The edge error of a frame is the latest wake-up of all of its edges,
+ * including the first one. A frame exceeding the frame tolerance is bad: it
+ * is not counted towards the send command and transmitted again, until the
+ * retransmission limit is reached. Derived classes may stop the transmission
+ * after any frame.
+ *
+ * If carrier sensing is enabled, the end of the send delay (and the time
+ * before the first frame) is spent listening, see senseCarrier().
+ *
+ * @param pulses Pulse train of a single air command transmission.
+ * @param pulseCount Number of pulses of the pulse train.
+ * @param sendCommand Number of times the pulse train will be transmitted.
+ * @param sendDelayUs Delay between repeated transmissions (unit:
+ *                    microseconds).
+ * @param frameToleranceNs Maximum edge error of a frame, negative if frames
+ *                         are not checked (unit: nanoseconds).
+ * @param maxRetransmissions Maximum number of retransmitted frames.
+ * @return Statistics of the transmission.
+ */
+Transmitter::Statistics Transmitter::transmit(const Types::Pulse * pulses,
+        const size_t pulseCount, const int32_t sendCommand,
+        const int32_t sendDelayUs, const int64_t frameToleranceNs,
+        const uint32_t maxRetransmissions) {
+    Statistics statistics = { 0U, 0U, 0U, 0U, 0, 0U, 0U };
+
+    begin();
+    Timings::mark("first edge");
+
+    int64_t deadlineNs = Clock::now();
+    int64_t firstEdgeErrorNs = 0;
+    if (senseGpioPin_ != Types::INVALID_GPIO_PIN) {
+        deadlineNs = senseCarrier(deadlineNs, deadlineNs, statistics);
+        firstEdgeErrorNs = waitUntil(deadlineNs, statistics.missedDeadlines);
+    }
+    int32_t sentFrames = 0;
+    while (sentFrames < sendCommand) {
+        const int64_t frameBeginNs = Clock::now();
+        const int64_t frameDeadlineNs = deadlineNs;
+        int64_t edgeErrorNs = firstEdgeErrorNs;
+        for (auto i = 0U; i < pulseCount; i++) {
+            write(pulses[i].level != 0U, deadlineNs);
+            deadlineNs += pulses[i].durationNs;
+            edgeErrorNs = std::max(edgeErrorNs,
+                waitUntil(deadlineNs, statistics.missedDeadlines));
+        }
+        statistics.frames++;
+        statistics.maxEdgeErrorNs = std::max(statistics.maxEdgeErrorNs,
+            edgeErrorNs);
+
+        if ((frameToleranceNs >= 0) && (edgeErrorNs > frameToleranceNs)) {
+            statistics.badFrames++;
+            Trace::span("bad frame", frameBeginNs, Clock::now(), "frame",
+                statistics.frames - 1U);
+            if (statistics.retransmissions < maxRetransmissions) {
+                statistics.retransmissions++;
+            } else {
+                sentFrames++;
+            }
+        } else {
+            Trace::span("frame", frameBeginNs, Clock::now(), "frame",
+                statistics.frames - 1U);
+            sentFrames++;
+        }
+
+        if (!frameSent(frameDeadlineNs, deadlineNs)) {
+            break;
+        }
+
+        if (sentFrames != sendCommand) {
+            const int64_t delayBeginNs = Clock::now();
+            write(false, deadlineNs);
+            const int64_t quietNs = deadlineNs + Receiver::MAX_LATENCY_NS;
+            deadlineNs += sendDelayUs * Clock::NS_PER_US;
+            if (senseGpioPin_ != Types::INVALID_GPIO_PIN) {
+                deadlineNs = senseCarrier(deadlineNs, quietNs, statistics);
+            }
+            firstEdgeErrorNs = waitUntil(deadlineNs,
+                statistics.missedDeadlines);
+            Trace::span("send delay", delayBeginNs, Clock::now());
+        }
+    }
+
+    end(deadlineNs);
+
+    return statistics;
+}
+
+/**
+ * @param samples Air scan samples, a false element indicates a low signal, a
+ *                true element a high signal.
+ * @param samplingRateUs Delay between two samples (unit: microseconds).
+ * @return Number of missed deadlines.
+ */
+uint32_t Transmitter::transmit(const std::vector<bool> & samples,
+        const int32_t samplingRateUs) {
+    uint32_t missedDeadlines = 0U;
+
+    begin();
+    Timings::mark("first edge");
+
+    int64_t deadlineNs = Clock::now();
+    const int64_t beginNs = deadlineNs;
+    for (auto i = 0U; i < samples.size(); i++) {
+        write(samples[i], deadlineNs);
+        deadlineNs += samplingRateUs * Clock::NS_PER_US;
+        waitUntil(deadlineNs, missedDeadlines);
+    }
+    Trace::span("samples", beginNs, Clock::now(), "samples", samples.size());
+
+    end(deadlineNs);
+
+    return missedDeadlines;
+}
+
+/**
+ * Must be called before the first edge of a stream, see transmitEdge().
+ */
+void Transmitter::beginStream(void) {
+    begin();
+    Timings::mark("first edge");
+}
+
+/**
+ * Edges are transmitted as soon as they are known, e.g. while they are still
+ * received. Deadlines must not decrease from edge to edge.
+ *
+ * @param level Signal level, false=low / true=high.
+ * @param deadlineNs Monotonic time the edge is scheduled for (unit:
+ *                   nanoseconds).
+ * @param missedDeadlines Number of missed deadlines, incremented if the
+ *                        deadline has already passed.
+ * @return Monotonic time the GPIO pin has been written at (unit:
+ *         nanoseconds).
+ */
+int64_t Transmitter::transmitEdge(const bool level, const int64_t deadlineNs,
+        uint32_t & missedDeadlines) {
+    waitUntil(deadlineNs, missedDeadlines);
+    write(level, deadlineNs);
+
+    return Clock::now();
+}
+
+void Transmitter::endStream(void) {
+    end(Clock::now());
+}
+
+void Transmitter::begin(void) {
+    pinMode(gpioPin_, OUTPUT);
+}
+
+void Transmitter::write(const bool level, const int64_t) {
+    digitalWrite(gpioPin_, level ? HIGH : LOW);
+}
+
+void Transmitter::end(const int64_t) {
+    pinMode(gpioPin_, INPUT);
+}
+
+bool Transmitter::frameSent(const int64_t, const int64_t) {
+    return true;
+}
+
+/**
+ * The channel must be idle for the listen time right before the frame. If it
+ * is busy, the frame is postponed by a random backoff of up to twice the
+ * previous maximum, starting at the listen time and bounded by
+ * MAX_BACKOFF_NS. After MAX_BACKOFFS backoffs the frame is sent anyway.
+ *
+ * Listening does not start before the given quiet time, so the receiver does
+ * not pick up the tail of the previous frame. Listening ends early enough to
+ * wake up in time for the first edge, but lasts at least MIN_CARRIER_NS. If
+ * the listen time is too short for both, the frame is postponed.
+ *
+ * @param deadlineNs Monotonic time of the first edge of the frame (unit:
+ *                   nanoseconds).
+ * @param quietNs Monotonic time the channel is free of the own signal (unit:
+ *                nanoseconds).
+ * @param statistics Statistics to account backoffs and busy frames in.
+ * @return Monotonic time of the first edge of the frame, postponed by the
+ *         backoffs (unit: nanoseconds).
+ */
+int64_t Transmitter::senseCarrier(const int64_t deadlineNs,
+        const int64_t quietNs, Statistics & statistics) {
+    const int64_t wakeUpNs = profile_.getSleepOvershoot()
+        + 2 * POLL_INTERVAL_NS;
+    int64_t listenBeginNs = std::max(deadlineNs - listenNs_, quietNs);
+    int64_t maxBackoffNs = listenNs_;
+
+    for (auto backoffs = 0U; ; backoffs++) {
+        const int64_t listenEndNs = std::max(listenBeginNs + listenNs_
+            - wakeUpNs, listenBeginNs + MIN_CARRIER_NS);
+        const int64_t frameBeginNs = listenEndNs + wakeUpNs;
+        const int64_t busyNs = listen(listenBeginNs, listenEndNs);
+        if (busyNs < 0) {
+            return frameBeginNs;
+        } else if (backoffs == MAX_BACKOFFS) {
+            statistics.busyFrames++;
+            return std::max(frameBeginNs, Clock::now());
+        }
+
+        maxBackoffNs = (2 * maxBackoffNs < MAX_BACKOFF_NS)
+            ? 2 * maxBackoffNs : MAX_BACKOFF_NS;
+        const int64_t backoffNs = std::uniform_int_distribution<int64_t>(
+            0, maxBackoffNs)(random_);
+        statistics.backoffs++;
+        Trace::span("backoff", busyNs, busyNs + backoffNs);
+        listenBeginNs = Clock::now() + backoffNs;
+    }
+}
+
+/**
+ * High levels shorter than MIN_CARRIER_NS are considered receiver noise.
+ *
+ * @param beginNs Monotonic time to start listening at (unit: nanoseconds).
+ * @param endNs Monotonic time to stop listening at (unit: nanoseconds).
+ * @return Monotonic time a carrier has been detected at (unit: nanoseconds),
+ *         -1 if the channel has been idle.
+ */
+int64_t Transmitter::listen(const int64_t beginNs, const int64_t endNs) const {
+    int64_t highNs = -1;
+
+    Clock::sleepUntil(beginNs);
+    for (int64_t nowNs = Clock::now(); nowNs < endNs; nowNs = Clock::now()) {
+        if (digitalRead(senseGpioPin_) == LOW) {
+            highNs = -1;
+        } else if (highNs < 0) {
+            highNs = nowNs;
+        } else if (nowNs - highNs >= MIN_CARRIER_NS) {
+            return nowNs;
+        }
+        Clock::sleepUntil((nowNs + POLL_INTERVAL_NS < endNs)
+            ? nowNs + POLL_INTERVAL_NS : endNs);
+    }
+
+    return -1;
+}
+
+/**
+ * The next GPIO write starts early by its duration, so the edge happens at the
+ * deadline. The sleep ends early by the sleep overshoot, the remaining time is
+ * spent spinning. The spin loop ends a clock read early, as the read detecting
+ * the wake-up time delays the edge by its duration. When tracing, the lateness
+ * of the wake-up is recorded as counter.
+ *
+ * @param deadlineNs Monotonic time of the next edge (unit: nanoseconds).
+ * @param missedDeadlines Number of missed deadlines, incremented if the
+ *                        deadline has already passed.
+ * @return Lateness of the wake-up, i.e. the error of the next edge (unit:
+ *         nanoseconds).
+ */
+int64_t Transmitter::waitUntil(const int64_t deadlineNs,
+        uint32_t & missedDeadlines) const {
+    const int64_t wakeUpNs = deadlineNs - profile_.getGpioWrite();
+
+    if (Clock::now() > deadlineNs) {
+        missedDeadlines++;
+    }
+
+    Clock::sleepUntil(wakeUpNs - profile_.getSleepOvershoot());
+    const int64_t spinEndNs = wakeUpNs - profile_.getClockRead();
+    while (Clock::now() < spinEndNs) {
+        // Spin until the wake-up time
+    }
+
+    const int64_t latenessNs = Clock::now() - wakeUpNs;
+    if (Trace::isEnabled()) {
+        Trace::counter("wake-up lateness", wakeUpNs, latenessNs);
+    }
+
+    return latenessNs;
+}
@@ -0,0 +1,389 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Clock.h"
+#include "EncodingIndex.h"
+#include "Receiver.h"
+#include "TargetIndex.h"
+#include "Timings.h"
+#include "Transmitter.h"
+#include "Tuning.h"
+#include "Verifier.h"
+
+const int32_t Tuning::LENGTH_PERCENTS[] = { 100, 90, 80, 70, 60, 50 };
+const int32_t Tuning::SEND_DELAY_PERCENTS[] = { 100, 75, 50, 25 };
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param name Target name string, must match a target configuration entry.
+ * @param confirmScript Script confirming the acceptance of a transmission, an
+ *                      empty string to verify frames with the receiver.
+ * @param reliabilityPercent Minimum ratio of accepted transmissions (unit:
+ *                           percent).
+ */
+Tuning::Tuning(Configuration & configuration, const std::string & name,
+        const std::string & confirmScript, const int32_t reliabilityPercent) :
+        Task(configuration),
+        name_(name),
+        confirmScript_(confirmScript),
+        reliabilityPercent_(reliabilityPercent) {
+    // Do nothing
+}
+
+/**
+ * Progress is written to stderr, the proposed configuration snippet to
+ * stdout. The configured send command is the upper limit of all send
+ * commands tried.
+ *
+ * @return Program exit code.
+ */
+int Tuning::start(void) {
+    // Look up the resolved parameters of the target and its encoding
+    const TargetParameters * parameters =
+        configuration_.getTargetIndex().find(name_);
+    if (parameters == nullptr) {
+        return EXIT_FAILURE;
+    }
+    EncodingIndex encodings(configuration_);
+    std::string error;
+    encodings.build();
+    const Encoder::Encoding * encoding =
+        encodings.find(parameters->getEncoding(), error);
+    if (encoding == nullptr) {
+        std::cerr << "Error: Configuration error (target " << name_ << "): "
+            << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    ScanParameters scanParameters(configuration_);
+    if (confirmScript_.empty() && !scanParameters.load()) {
+        return EXIT_FAILURE;
+    } else if (!confirmScript_.empty()
+            && (access(confirmScript_.c_str(), X_OK) != 0)) {
+        std::cerr << "Error: Confirmation script '" << confirmScript_
+            << "' cannot be executed: " << strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    Timings::mark("parameters");
+
+    // Get GPIO from the parameters unless overridden from the command line
+    if (gpioPin_ == Types::INVALID_GPIO_PIN) {
+        gpioPin_ = parameters->getGpioPin();
+    } else if (!isValidGpioPin(gpioPin_)) {
+        std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (confirmScript_.empty() && (gpioPin_ == scanParameters.getGpioPin())) {
+        std::cerr << "Error: Transmitter and receiver must not use the same "
+            "GPIO pin " << +gpioPin_ << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+    dutyCyclePpm_ = parameters->getDutyCycle();
+    dutyCycleWindowS_ = parameters->getDutyCycleWindow();
+
+    const Candidate configured = { parameters->getDataLength(),
+        parameters->getSyncLength(), parameters->getSendCommand(),
+        parameters->getSendDelay(), getAirtime(parameters->getPulses(),
+        parameters->getSendCommand(), parameters->getSendDelay()) };
+    Candidate best = configured;
+    bool isFound = false;
+
+    for (const int32_t lengthPercent : LENGTH_PERCENTS) {
+        Candidate candidate = configured;
+        candidate.dataLengthUs = std::max(
+            configured.dataLengthUs * lengthPercent / 100, 1);
+        candidate.syncLengthUs = std::max(
+            configured.syncLengthUs * lengthPercent / 100, 1);
+
+        const std::vector<Types::Pulse> pulses = Encoder::encode(*encoding,
+            parameters->getAirCommand(), candidate.dataLengthUs,
+            candidate.syncLengthUs);
+        const std::vector<size_t> elementEnds = Verifier::getElementEnds(
+            *encoding, parameters->getAirCommand(), candidate.dataLengthUs,
+            candidate.syncLengthUs);
+
+        // The receiver cannot tell whether the device accepts shorter send
+        // delays, it would decode frames however close they are
+        const size_t sendDelayCount = confirmScript_.empty() ? 1U
+            : sizeof(SEND_DELAY_PERCENTS) / sizeof(SEND_DELAY_PERCENTS[0]);
+        for (auto i = 0U; i < sendDelayCount; i++) {
+            // A single frame does not depend on the send delay
+            const int32_t minSendCommand = (i == 0U) ? 1 : 2;
+
+            candidate.sendDelayUs =
+                configured.sendDelayUs * SEND_DELAY_PERCENTS[i] / 100;
+            candidate.sendCommand = confirmScript_.empty()
+                ? tuneWithReceiver(scanParameters, pulses, elementEnds,
+                    candidate, configured.sendCommand,
+                    isFound ? best.airtimeNs : INT64_MAX)
+                : tuneWithScript(pulses, candidate, minSendCommand,
+                    configured.sendCommand,
+                    isFound ? best.airtimeNs : INT64_MAX);
+            if (candidate.sendCommand == 0) {
+                continue;
+            }
+
+            candidate.airtimeNs = getAirtime(pulses, candidate.sendCommand,
+                candidate.sendDelayUs);
+            if (!isFound || (candidate.airtimeNs < best.airtimeNs)) {
+                best = candidate;
+                isFound = true;
+            }
+        }
+    }
+
+    if (!isFound) {
+        std::cerr << "Error: No timing of target " << name_ << " reaches a "
+            "reliability of " << reliabilityPercent_ << "%" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    printSnippet(best, configured.airtimeNs);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Send commands are tried in ascending order, for every one of them a series
+ * of bursts is transmitted and verified with the receiver. A burst is
+ * received if at least one of its frames is clean. Frames of a burst are not
+ * independent, e.g. interference often lasts longer than a frame, so the
+ * reliability is measured burst by burst. A send command is given up as soon
+ * as too many of its bursts have been lost, send commands not beating the
+ * best airtime found so far are skipped.
+ *
+ * @param scanParameters Parameters of the receiver.
+ * @param pulses Pulse train of a single air command transmission.
+ * @param elementEnds Index of the pulse following each air command element.
+ * @param candidate Timing parameters to try, the send command is ignored.
+ * @param maxSendCommand Maximum send command.
+ * @param maxAirtimeNs Airtime to beat (unit: nanoseconds).
+ * @return Smallest reliable send command, 0 if there is none.
+ */
+int32_t Tuning::tuneWithReceiver(const ScanParameters & scanParameters,
+        const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds,
+        const Candidate & candidate, const int32_t maxSendCommand,
+        const int64_t maxAirtimeNs) const {
+    const int32_t maxLost = RECEIVER_BURSTS
+        - (reliabilityPercent_ * RECEIVER_BURSTS + 99) / 100;
+    Candidate trial = candidate;
+
+    for (trial.sendCommand = 1; trial.sendCommand <= maxSendCommand;
+            trial.sendCommand++) {
+        if (getAirtime(pulses, trial.sendCommand, trial.sendDelayUs)
+                >= maxAirtimeNs) {
+            break;
+        }
+
+        int32_t received = 0;
+        int32_t lost = 0;
+        while ((received + lost < RECEIVER_BURSTS) && (lost <= maxLost)) {
+            if (isBurstReceived(scanParameters, pulses, elementEnds, trial)) {
+                received++;
+            } else {
+                lost++;
+            }
+            Clock::sleepUntil(Clock::now() + BURST_GAP_NS);
+        }
+
+        std::cerr << "dataLength " << trial.dataLengthUs << "us, sendCommand "
+            << trial.sendCommand << ": " << received << " of "
+            << received + lost << " bursts received" << std::endl;
+        if (lost <= maxLost) {
+            return trial.sendCommand;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * The burst stops after the first clean frame, like the device would react
+ * to it. Its airtime is charged to the duty cycle budget of the target.
+ *
+ * @param scanParameters Parameters of the receiver.
+ * @param pulses Pulse train of a single air command transmission.
+ * @param elementEnds Index of the pulse following each air command element.
+ * @param candidate Timing parameters of the burst.
+ * @return True if at least one frame has been received clean, false
+ *         otherwise.
+ */
+bool Tuning::isBurstReceived(const ScanParameters & scanParameters,
+        const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds,
+        const Candidate & candidate) const {
+    const int64_t frameAirtimeNs = Transmitter::getAirtime(pulses.data(),
+        pulses.size());
+    if (!reserveAirtime(frameAirtimeNs * candidate.sendCommand)) {
+        return false;
+    }
+
+    Receiver receiver(scanParameters.getGpioPin(),
+        scanParameters.getSamplingRate(), Receiver::getCapacity(
+        getAirtime(pulses, candidate.sendCommand, candidate.sendDelayUs),
+        scanParameters.getSamplingRate()));
+    Verifier verifier(gpioPin_, receiver, pulses, elementEnds, 1,
+        candidate.sendCommand);
+
+    receiver.start();
+    receiver.waitUntilCaptured(Clock::now());
+    const Transmitter::Statistics statistics = verifier.transmit(
+        pulses.data(), pulses.size(), candidate.sendCommand,
+        candidate.sendDelayUs);
+    receiver.stop();
+
+    return adjustAirtime(frameAirtimeNs * (static_cast<int64_t>(
+        statistics.frames) - candidate.sendCommand))
+        && (verifier.cleanFrames > 0);
+}
+
+/**
+ * Send commands are tried in ascending order, every one of them is
+ * transmitted and confirmed several times. Send commands not beating the
+ * best airtime found so far are skipped. Every transmission is charged to the
+ * duty cycle budget of the target.
+ *
+ * @param pulses Pulse train of a single air command transmission.
+ * @param candidate Timing parameters to try, the send command is ignored.
+ * @param minSendCommand Minimum send command.
+ * @param maxSendCommand Maximum send command.
+ * @param maxAirtimeNs Airtime to beat (unit: nanoseconds).
+ * @return Smallest reliable send command, 0 if there is none.
+ */
+int32_t Tuning::tuneWithScript(const std::vector<Types::Pulse> & pulses,
+        const Candidate & candidate, const int32_t minSendCommand,
+        const int32_t maxSendCommand, const int64_t maxAirtimeNs) const {
+    const int64_t frameAirtimeNs = Transmitter::getAirtime(pulses.data(),
+        pulses.size());
+    Transmitter transmitter(gpioPin_);
+    Candidate trial = candidate;
+
+    for (trial.sendCommand = minSendCommand;
+            trial.sendCommand <= maxSendCommand;
+            trial.sendCommand++) {
+        if (getAirtime(pulses, trial.sendCommand, trial.sendDelayUs)
+                >= maxAirtimeNs) {
+            break;
+        }
+
+        int32_t accepted = 0;
+        for (auto i = 0; i < CONFIRM_TRIALS; i++) {
+            if (!reserveAirtime(frameAirtimeNs * trial.sendCommand)) {
+                return 0;
+            }
+            transmitter.transmit(pulses.data(), pulses.size(),
+                trial.sendCommand, trial.sendDelayUs);
+            if (confirm(trial)) {
+                accepted++;
+            }
+        }
+
+        std::cerr << "dataLength " << trial.dataLengthUs << "us, sendDelay "
+            << trial.sendDelayUs << "us, sendCommand " << trial.sendCommand
+            << ": " << accepted << " of " << CONFIRM_TRIALS << " accepted"
+            << std::endl;
+        if (accepted * 100 >= reliabilityPercent_ * CONFIRM_TRIALS) {
+            return trial.sendCommand;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * The script is called with the target name, data length, send command and
+ * send delay as arguments. It inherits stdin, so it may ask the user.
+ *
+ * @param candidate Timing parameters of the transmission.
+ * @return True if the script exits with 0, false otherwise.
+ */
+bool Tuning::confirm(const Candidate & candidate) const {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Error: Unable to run confirmation script: "
+            << strerror(errno) << std::endl;
+        return false;
+    } else if (pid == 0) {
+        execl(confirmScript_.c_str(), confirmScript_.c_str(), name_.c_str(),
+            std::to_string(candidate.dataLengthUs).c_str(),
+            std::to_string(candidate.sendCommand).c_str(),
+            std::to_string(candidate.sendDelayUs).c_str(), nullptr);
+        std::cerr << "Error: Unable to run confirmation script '"
+            << confirmScript_ << "': " << strerror(errno) << std::endl;
+        _exit(EXIT_FAILURE);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+/**
+ * @param candidate Proposed timing parameters.
+ * @param configuredAirtimeNs Airtime of the configured parameters (unit:
+ *                            nanoseconds).
+ */
+void Tuning::printSnippet(const Candidate & candidate,
+        const int64_t configuredAirtimeNs) const {
+    std::cout << "// Tuned for a reliability of " << reliabilityPercent_
+        << "%, airtime " << candidate.airtimeNs / Clock::NS_PER_US
+        << "us instead of " << configuredAirtimeNs / Clock::NS_PER_US << "us"
+        << std::endl
+        << name_ << ":" << std::endl
+        << "{" << std::endl
+        << "    dataLength = " << candidate.dataLengthUs << ";" << std::endl
+        << "    syncLength = " << candidate.syncLengthUs << ";" << std::endl
+        << "    sendCommand = " << candidate.sendCommand << ";" << std::endl
+        << "    sendDelay = " << candidate.sendDelayUs << ";" << std::endl
+        << "};" << std::endl;
+}
+
+/**
+ * @param pulses Pulse train of a single air command transmission.
+ * @param sendCommand Number of times the pulse train will be transmitted.
+ * @param sendDelayUs Delay between repeated transmissions (unit:
+ *                    microseconds).
+ * @return Duration of the transmission (unit: nanoseconds).
+ */
+int64_t Tuning::getAirtime(const std::vector<Types::Pulse> & pulses,
+        const int32_t sendCommand, const int32_t sendDelayUs) {
+    int64_t frameNs = 0;
+    for (const Types::Pulse & pulse : pulses) {
+        frameNs += pulse.durationNs;
+    }
+
+    return sendCommand * frameNs
+        + (sendCommand - 1) * sendDelayUs * Clock::NS_PER_US;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ValueChangeDump.h"
+
+const std::string ValueChangeDump::EXTENSION = ".vcd";
+
+/**
+ * @param stream Stream receiving the dump, should be buffered.
+ * @param gpioPin GPIO pin the samples have been captured from.
+ * @param samplingRateUs Time between two samples (unit: microseconds).
+ */
+ValueChangeDump::ValueChangeDump(std::ostream & stream, const uint8_t gpioPin,
+        const int32_t samplingRateUs) :
+        stream_(stream),
+        gpioPin_(gpioPin),
+        samplingRateUs_(samplingRateUs),
+        sample_(0U),
+        level_(false) {
+    // Do nothing
+}
+
+/**
+ * @param file File name.
+ * @return True if the file name ends with '.vcd', false otherwise.
+ */
+bool ValueChangeDump::isValueChangeDump(const std::string & file) {
+    return (file.length() > EXTENSION.length())
+        && (file.compare(file.length() - EXTENSION.length(),
+            EXTENSION.length(), EXTENSION) == 0);
+}
+
+/**
+ * The timescale is one microsecond, so timestamps are the sample index
+ * multiplied by the sampling rate.
+ */
+void ValueChangeDump::writeHeader(void) {
+    stream_ << "$comment aircontrol air scan, sampling rate "
+        << samplingRateUs_ << "us $end\n"
+        << "$timescale 1 us $end\n"
+        << "$scope module aircontrol $end\n"
+        << "$var wire 1 ! gpio" << +gpioPin_ << " $end\n"
+        << "$upscope $end\n"
+        << "$enddefinitions $end\n";
+}
+
+void ValueChangeDump::writeEnd(void) {
+    stream_ << '#' << sample_ * samplingRateUs_ << '\n';
+    stream_.flush();
+}
+
+/// @param level Level of the next sample.
+void ValueChangeDump::writeEdge(const bool level) {
+    if (sample_ == 0U) {
+        stream_ << "#0\n$dumpvars\n" << (level ? '1' : '0') << "!\n$end\n";
+    } else {
+        stream_ << '#' << sample_ * samplingRateUs_ << '\n'
+            << (level ? '1' : '0') << "!\n";
+    }
+    level_ = level;
+}
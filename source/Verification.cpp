@@ -0,0 +1,190 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "Clock.h"
+#include "EncodingIndex.h"
+#include "Metrics.h"
+#include "Receiver.h"
+#include "ScanParameters.h"
+#include "TargetIndex.h"
+#include "Timings.h"
+#include "Transmitter.h"
+#include "Verification.h"
+
+/**
+ * @param configuration Reference of the configuration.
+ * @param name Target name string, must match a target configuration entry.
+ * @param copies Number of clean frames to stop the transmission after, <=0
+ *               to transmit all frames.
+ */
+Verification::Verification(Configuration & configuration,
+        const std::string & name, const int32_t copies) :
+        Task(configuration),
+        name_(name),
+        copies_(copies) {
+    // Do nothing
+}
+
+/**
+ * The GPIO pin of the target is used for transmitting, the GPIO pin of the
+ * 'scan' section for receiving. Only the transmitting GPIO pin is locked.
+ *
+ * @return Program exit code, failure if fewer clean frames than requested (or
+ *         none at all) have been received.
+ */
+int Verification::start(void) {
+    // Look up the resolved parameters of the target
+    const TargetParameters * parameters =
+        configuration_.getTargetIndex().find(name_);
+    if (parameters == nullptr) {
+        return EXIT_FAILURE;
+    }
+    ScanParameters scanParameters(configuration_);
+    if (!scanParameters.load()) {
+        return EXIT_FAILURE;
+    }
+    std::vector<size_t> elementEnds;
+    if (!getElementEnds(*parameters, elementEnds)) {
+        return EXIT_FAILURE;
+    }
+    Timings::mark("parameters");
+
+    // Get GPIO from the parameters unless overridden from the command line
+    if (gpioPin_ == Types::INVALID_GPIO_PIN) {
+        gpioPin_ = parameters->getGpioPin();
+    } else if (!isValidGpioPin(gpioPin_)) {
+        std::cerr << "Error: Given GPIO pin " << +gpioPin_ << " is invalid"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (gpioPin_ == scanParameters.getGpioPin()) {
+        std::cerr << "Error: Transmitter and receiver must not use the same "
+            "GPIO pin " << +gpioPin_ << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Wait until no other instance is using the GPIO pin
+    if (!lockGpioPin()) {
+        return EXIT_FAILURE;
+    }
+
+    // Wait until the duty cycle budget of the GPIO pin allows transmitting
+    const std::vector<Types::Pulse> & pulses = parameters->getPulses();
+    const int64_t frameAirtimeNs = Transmitter::getAirtime(pulses.data(),
+        pulses.size());
+    dutyCyclePpm_ = parameters->getDutyCycle();
+    dutyCycleWindowS_ = parameters->getDutyCycleWindow();
+    if (!reserveAirtime(frameAirtimeNs * parameters->getSendCommand())) {
+        return EXIT_FAILURE;
+    }
+
+    // Reserve capacity for an edge per sample of the whole transmission
+    const size_t maxFrames = static_cast<size_t>(parameters->getSendCommand()
+        + std::max(parameters->getMaxRetransmissions(), 0));
+    int64_t frameNs = parameters->getSendDelay() * Clock::NS_PER_US;
+    for (const Types::Pulse & pulse : pulses) {
+        frameNs += pulse.durationNs;
+    }
+
+    Receiver receiver(scanParameters.getGpioPin(),
+        scanParameters.getSamplingRate(), Receiver::getCapacity(
+        maxFrames * frameNs, scanParameters.getSamplingRate()));
+    Verifier verifier(gpioPin_, receiver, pulses, elementEnds, copies_,
+        maxFrames);
+
+    // Capture the initial level before the first edge
+    receiver.start();
+    receiver.waitUntilCaptured(Clock::now());
+    const int64_t startNs = Clock::now();
+    const int32_t frameToleranceUs = parameters->getFrameTolerance();
+    const Transmitter::Statistics statistics = verifier.transmit(
+        pulses.data(), pulses.size(), parameters->getSendCommand(),
+        parameters->getSendDelay(),
+        (frameToleranceUs != Types::INVALID_PARAMETER)
+        ? frameToleranceUs * Clock::NS_PER_US : -1,
+        static_cast<uint32_t>(parameters->getMaxRetransmissions()));
+    Metrics::addTransmission(name_, statistics, Clock::now() - startNs);
+    receiver.stop();
+
+    // Account retransmitted frames or frames skipped after enough copies
+    if (!adjustAirtime(frameAirtimeNs * (static_cast<int64_t>(
+            statistics.frames) - parameters->getSendCommand()))) {
+        return EXIT_FAILURE;
+    }
+
+    report(verifier, elementEnds.size());
+
+    const int32_t required = (copies_ > 0) ? copies_ : 1;
+    return (verifier.cleanFrames >= required) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @param parameters Resolved parameters of the target.
+ * @param elementEnds Place to store the index of the pulse following each
+ *                    air command element to.
+ * @return True if successful, false otherwise.
+ */
+bool Verification::getElementEnds(const TargetParameters & parameters,
+        std::vector<size_t> & elementEnds) const {
+    EncodingIndex encodings(configuration_);
+    std::string error;
+
+    encodings.build();
+    const Encoder::Encoding * encoding =
+        encodings.find(parameters.getEncoding(), error);
+    if (encoding == nullptr) {
+        std::cerr << "Error: Configuration error (target " << name_ << "): "
+            << error << std::endl;
+        return false;
+    }
+
+    elementEnds = Verifier::getElementEnds(*encoding,
+        parameters.getAirCommand(), parameters.getDataLength(),
+        parameters.getSyncLength());
+
+    return true;
+}
+
+/**
+ * @param verifier Verifier holding the results of all frames.
+ * @param elements Number of air command elements per frame.
+ */
+void Verification::report(const Verifier & verifier, const size_t elements) {
+    for (auto i = 0U; i < verifier.frames.size(); i++) {
+        const Verifier::Frame & frame = verifier.frames[i];
+
+        std::cout << "Frame " << i + 1U << ": " << frame.errors << " of "
+            << elements << " elements wrong (bit error rate "
+            << std::fixed << std::setprecision(3)
+            << ((elements > 0U) ? double(frame.errors) / elements : 0.0)
+            << "), ";
+        if (frame.latencyNs < 0) {
+            std::cout << "no signal received" << std::endl;
+        } else {
+            std::cout << "receiver latency "
+                << frame.latencyNs / Clock::NS_PER_US << "us" << std::endl;
+        }
+    }
+
+    std::cout << "Received " << verifier.cleanFrames << " clean frames of "
+        << verifier.frames.size() << " transmitted" << std::endl;
+}
@@ -0,0 +1,150 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+
+#include "Clock.h"
+#include "Verifier.h"
+
+/**
+ * Capacity for the results of all frames is reserved upfront, so verifying a
+ * frame does not allocate memory.
+ *
+ * @param gpioPin GPIO pin to transmit on.
+ * @param receiver Receiver capturing the transmitted signal.
+ * @param pulses Pulse train of a single air command transmission.
+ * @param elementEnds Index of the pulse following each air command element.
+ * @param copies Number of clean frames to stop after, <=0 to never stop
+ *               early.
+ * @param frameCapacity Maximum number of transmitted frames.
+ */
+Verifier::Verifier(const uint8_t gpioPin,
+        const Receiver & receiver, const std::vector<Types::Pulse> & pulses,
+        const std::vector<size_t> & elementEnds, const int32_t copies,
+        const size_t frameCapacity) :
+        Transmitter(gpioPin),
+        frames(),
+        cleanFrames(0),
+        receiver_(receiver),
+        pulses_(pulses),
+        elementEnds_(elementEnds),
+        copies_(copies) {
+    frames.reserve(frameCapacity);
+}
+
+/**
+ * The elements are encoded again the same way as the pulse train of the
+ * target, so the element boundaries match the pulses exactly.
+ *
+ * @param encoding Radio frame encoding.
+ * @param airCommand Air command.
+ * @param dataLengthUs Pulse length of a single data element (unit:
+ *                     microseconds).
+ * @param syncLengthUs Pulse length of a single sync element (unit:
+ *                     microseconds).
+ * @return Index of the pulse following each air command element.
+ */
+std::vector<size_t> Verifier::getElementEnds(
+        const Encoder::Encoding & encoding, const std::string & airCommand,
+        const int32_t dataLengthUs, const int32_t syncLengthUs) {
+    std::vector<size_t> elementEnds;
+    double carryNs = 0.0;
+    size_t pulseCount = 0U;
+
+    elementEnds.reserve(airCommand.length());
+    for (const char element : airCommand) {
+        pulseCount += Encoder::encodeElement(encoding, element, dataLengthUs,
+            syncLengthUs, carryNs).count;
+        elementEnds.push_back(pulseCount);
+    }
+
+    return elementEnds;
+}
+
+/**
+ * Waits for the receiver to catch up with the end of the frame, this time is
+ * taken from the delay before the next frame. Each pulse is sampled in its
+ * middle, shifted by the estimated receiver latency.
+ *
+ * @param beginNs Monotonic time the frame was scheduled to begin at (unit:
+ *                nanoseconds).
+ * @param endNs Monotonic time the frame was scheduled to end at (unit:
+ *              nanoseconds).
+ * @return True to continue the transmission, false if enough clean frames
+ *         have been received.
+ */
+bool Verifier::frameSent(const int64_t beginNs,
+        const int64_t endNs) {
+    Frame frame = { 0U, -1 };
+
+    if (receiver_.waitUntilCaptured(endNs + Receiver::MAX_LATENCY_NS)) {
+        frame.latencyNs = estimateLatency(beginNs);
+    }
+
+    int64_t pulseBeginNs = beginNs + std::max(frame.latencyNs, int64_t(0));
+    size_t pulse = 0U;
+    for (const size_t elementEnd : elementEnds_) {
+        bool isCorrect = (frame.latencyNs >= 0);
+        for (; pulse < elementEnd; pulse++) {
+            const int64_t durationNs = pulses_[pulse].durationNs;
+            if (receiver_.getLevel(pulseBeginNs + durationNs / 2)
+                    != (pulses_[pulse].level != 0U)) {
+                isCorrect = false;
+            }
+            pulseBeginNs += durationNs;
+        }
+        if (!isCorrect) {
+            frame.errors++;
+        }
+    }
+
+    if (frames.size() < frames.capacity()) {
+        frames.push_back(frame);
+    }
+    if (frame.errors == 0U) {
+        cleanFrames++;
+    }
+
+    return (copies_ <= 0) || (cleanFrames < copies_);
+}
+
+/**
+ * The latency is the delay of the first received edge behind the first
+ * transmitted edge of the frame. The pin is low before every frame, so the
+ * first transmitted edge is the first high pulse.
+ *
+ * @param beginNs Monotonic time the frame was scheduled to begin at (unit:
+ *                nanoseconds).
+ * @return Estimated latency (unit: nanoseconds), -1 if no edge has been
+ *         received.
+ */
+int64_t Verifier::estimateLatency(const int64_t beginNs) const {
+    int64_t edgeNs = beginNs;
+
+    for (const Types::Pulse & pulse : pulses_) {
+        if (pulse.level != 0U) {
+            const int64_t receivedNs = receiver_.findEdge(true, edgeNs,
+                edgeNs + Receiver::MAX_LATENCY_NS);
+            return (receivedNs < 0) ? -1 : std::max(receivedNs - edgeNs,
+                int64_t(0));
+        }
+        edgeNs += pulse.durationNs;
+    }
+
+    return -1;
+}
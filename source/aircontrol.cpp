@@ -18,39 +18,106 @@
  */
 
 #include <cstdint>
+#include <getopt.h>
 #include <iostream>
 #include <memory>
 #include <unistd.h>
 
 #include <wiringPi.h>
 
+#include "ArchiveBuilder.h"
+#include "Benchmark.h"
+#include "Calibration.h"
+#include "CaptureSegments.h"
+#include "CommandStream.h"
 #include "Configuration.h"
-#include "InstanceLock.h"
+#include "Metrics.h"
+#include "PulseAnalysis.h"
+#include "Repeater.h"
 #include "Replay.h"
+#include "SamplingProbe.h"
 #include "Scan.h"
 #include "Target.h"
 #include "Task.h"
+#include "Timings.h"
+#include "Trace.h"
+#include "Tuning.h"
 #include "Types.h"
+#include "Verification.h"
 #include "Version.h"
 
+/// Default minimum ratio of accepted tuning transmissions (unit: percent).
+static const int32_t DEFAULT_RELIABILITY = 90;
+
 /// @brief Display the program usage.
 static void printUsage(void) {
     std::cout << std::endl
         << "aircontrol " << VERSION << std::endl
         << std::endl
-        << "Usage: aircontrol [options] <command>" << std::endl
+        << "Usage: aircontrol [options] <command> [<dump>...]" << std::endl
         << std::endl
         << "Available options:" << std::endl
         << "  -c <file>\tConfiguration file ["
         << Configuration::DEFAULT_LOCATION << "]" << std::endl
         << "  -d <file>\tDump air scan results to file" << std::endl
+        << "  --filter\tRepeat only frames matching a target" << std::endl
         << "  -g <pin>\tOverride GPIO pin from configuration" << std::endl
-        << "  -l\t\tPrevent multiple program instances" << std::endl
+        << "  -l\t\tPrevent multiple instances using the same GPIO pin"
+        << std::endl
+        << "  --latency=<us>\tLatency of repeated edges" << std::endl
+        << "  --confirm=<script>" << std::endl
+        << "\t\tConfirm tuning transmissions by script instead of receiver"
+        << std::endl
+        << "  -n <copies>\tStop verification after given number of clean "
+        "frames" << std::endl
+        << "  --metrics=<file>" << std::endl
+        << "\t\tExport metrics of all runs to file (Prometheus text format)"
+        << std::endl
+        << "  --reliability=<percent>" << std::endl
+        << "\t\tMinimum ratio of accepted tuning transmissions ["
+        << DEFAULT_RELIABILITY << "]" << std::endl
+        << "  --scale=<us>\tDuration of a bar character of the air scan graph"
+        << std::endl
+        << "  --summary\tPrint air scan as summary of the terminal width"
+        << std::endl
+        << "  --timings[=<file>]" << std::endl
+        << "\t\tReport startup phase timing to stderr or append it to file"
+        << std::endl
+        << "  --trace=<file>\tWrite timeline to file (Chrome trace format)"
+        << std::endl
         << std::endl
         << "Available commands:" << std::endl
-        << "  -r <file>\tReplay given air scan dump" << std::endl
+        << "  --archive=<file>" << std::endl
+        << "\t\tAdd given air scan dumps ([name=]file) to frame archive"
+        << std::endl
+        << "  --calibrate\tMeasure timing of this host and store it as profile"
+        << std::endl
+        << "  --probe\tMeasure shortest sustainable air scan sampling rate"
+        << std::endl
+        << "  -a <file>\tAnalyze pulse widths of given air scan dump"
+        << std::endl
+        << "  -b <target>\tBenchmark transmit timing of target ('"
+        << Benchmark::ALL_TARGETS << "' for all, '" << Benchmark::SYNTHETIC
+        << "' for" << std::endl
+        << "\t\tsynthetic frames)" << std::endl
+        << "  -i\t\tExecute commands read from stdin ('t <target>', "
+        "'r <file>'," << std::endl
+        << "\t\t'sleep <us>')" << std::endl
+        << "  -r <file>\tReplay given air scan dump (or 'archive:name', "
+        "'file@<segment>'," << std::endl
+        << "\t\t'file@<from ms>-<to ms>')" << std::endl
+        << "  --repeat=<ms>\tRepeat air scan receiver signal live for given "
+        "period" << std::endl
         << "  -s <ms>\tAir scan for given period" << std::endl
+        << "  --segments=<file>[@<segment>]" << std::endl
+        << "\t\tList activity segments of air scan dump or extract one to "
+        "'-d'" << std::endl
         << "  -t <target>\tExecute target configuration" << std::endl
+        << "  --tune=<target>" << std::endl
+        << "\t\tPropose the shortest reliable timing of target" << std::endl
+        << "  -v <target>\tExecute target configuration and verify it with "
+        "the air" << std::endl
+        << "\t\tscan receiver" << std::endl
         << std::endl
         << "Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>"
         << std::endl << std::endl;
@@ -63,16 +130,114 @@ static void printUsage(void) {
  * @return Exit code.
  */
 int main(int argc, char **argv) {
+    // Loading the program up to here is reported as first phase
+    Timings::mark("exec");
+
     Configuration configuration;
     std::unique_ptr<Task> task;
     uint8_t gpio = Types::INVALID_GPIO_PIN;
     std::string dumpFile;
+    bool instanceLock = false;
+    int32_t copies = 0;
+    std::string confirmScript;
+    int32_t reliability = DEFAULT_RELIABILITY;
+    int32_t scale = 0;
+    bool isSummary = false;
+    int32_t latency = 0;
+    bool isFiltered = false;
+    ArchiveBuilder * archiveBuilder = nullptr;
+
+    // Long options without short equivalent
+    const int OPTION_METRICS = 256;
+    const int OPTION_TIMINGS = 257;
+    const int OPTION_TRACE = 258;
+    const int OPTION_CALIBRATE = 259;
+    const int OPTION_TUNE = 260;
+    const int OPTION_CONFIRM = 261;
+    const int OPTION_RELIABILITY = 262;
+    const int OPTION_SCALE = 263;
+    const int OPTION_SUMMARY = 264;
+    const int OPTION_PROBE = 265;
+    const int OPTION_REPEAT = 266;
+    const int OPTION_LATENCY = 267;
+    const int OPTION_FILTER = 268;
+    const int OPTION_ARCHIVE = 269;
+    const int OPTION_SEGMENTS = 270;
+    const struct option LONG_OPTIONS[] = {
+        { "metrics", required_argument, nullptr, OPTION_METRICS },
+        { "timings", optional_argument, nullptr, OPTION_TIMINGS },
+        { "trace", required_argument, nullptr, OPTION_TRACE },
+        { "calibrate", no_argument, nullptr, OPTION_CALIBRATE },
+        { "tune", required_argument, nullptr, OPTION_TUNE },
+        { "confirm", required_argument, nullptr, OPTION_CONFIRM },
+        { "reliability", required_argument, nullptr, OPTION_RELIABILITY },
+        { "scale", required_argument, nullptr, OPTION_SCALE },
+        { "summary", no_argument, nullptr, OPTION_SUMMARY },
+        { "probe", no_argument, nullptr, OPTION_PROBE },
+        { "repeat", required_argument, nullptr, OPTION_REPEAT },
+        { "latency", required_argument, nullptr, OPTION_LATENCY },
+        { "filter", no_argument, nullptr, OPTION_FILTER },
+        { "archive", required_argument, nullptr, OPTION_ARCHIVE },
+        { "segments", required_argument, nullptr, OPTION_SEGMENTS },
+        { nullptr, 0, nullptr, 0 }
+    };
 
     // Parse command line arguments
     int option;
     opterr = 0;
-    while ((option = getopt(argc, argv, "c:d:g:lr:s:t:")) != -1) {
+    while ((option = getopt_long(argc, argv, "a:b:c:d:g:iln:r:s:t:v:",
+            LONG_OPTIONS, nullptr)) != -1) {
         switch (option) {
+            case 'a':
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '-a')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<PulseAnalysis>(PulseAnalysis(
+                    configuration, std::string(optarg)));
+                break;
+
+            case OPTION_ARCHIVE:
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--archive')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<ArchiveBuilder>(ArchiveBuilder(
+                    configuration, std::string(optarg)));
+                archiveBuilder = static_cast<ArchiveBuilder *>(task.get());
+                break;
+
+            case 'b':
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '-b')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<Benchmark>(Benchmark(configuration,
+                    std::string(optarg)));
+                break;
+
+            case OPTION_CALIBRATE:
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--calibrate')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<Calibration>(Calibration(
+                    configuration));
+                break;
+
+            case OPTION_CONFIRM:
+                if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--confirm' is an option "
+                        "and must be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                confirmScript = std::string(optarg);
+                break;
+
             case 'c':
                 configuration.setLocation(std::string(optarg));
                 break;
@@ -86,12 +251,79 @@ int main(int argc, char **argv) {
                 dumpFile = std::string(optarg);
                 break;
 
+            case OPTION_FILTER:
+                if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--filter' is an option "
+                        "and must be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                isFiltered = true;
+                break;
+
             case 'g':
                 gpio = static_cast<uint8_t>(atoi(optarg));
                 break;
 
+            case 'i':
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '-i')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<CommandStream>(CommandStream(
+                    configuration, std::cin));
+                break;
+
             case 'l':
-                InstanceLock::lock();
+                instanceLock = true;
+                break;
+
+            case OPTION_LATENCY:
+                if (atoi(optarg) <= 0) {
+                    std::cerr << "Error: Latency must be >0us" << std::endl;
+                    return EXIT_FAILURE;
+                } else if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--latency' is an option "
+                        "and must be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                latency = atoi(optarg);
+                break;
+
+            case 'n':
+                if (atoi(optarg) <= 0) {
+                    std::cerr << "Error: Number of clean frames must be >0"
+                        << std::endl;
+                    return EXIT_FAILURE;
+                } else if (task != nullptr) {
+                    std::cerr << "Error: Parameter '-n' is an option and must "
+                        "be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                copies = atoi(optarg);
+                break;
+
+            case OPTION_METRICS:
+                Metrics::enable(std::string(optarg));
+                break;
+
+            case OPTION_TIMINGS:
+                Timings::enable((optarg == nullptr) ? std::string()
+                    : std::string(optarg));
+                break;
+
+            case OPTION_TRACE:
+                Trace::enable(std::string(optarg));
+                break;
+
+            case OPTION_PROBE:
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--probe')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<SamplingProbe>(SamplingProbe(
+                    configuration));
                 break;
 
             case 'r':
@@ -104,6 +336,55 @@ int main(int argc, char **argv) {
                     std::string(optarg)));
                 break;
 
+            case OPTION_REPEAT:
+                if (atoi(optarg) <= 0) {
+                    std::cerr << "Error: Repeating duration must be >0ms"
+                        << std::endl;
+                    return EXIT_FAILURE;
+                } else if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--repeat')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<Repeater>(Repeater(configuration,
+                    atoi(optarg), latency, isFiltered));
+                break;
+
+            case OPTION_RELIABILITY:
+                if ((atoi(optarg) <= 0) || (atoi(optarg) > 100)) {
+                    std::cerr << "Error: Reliability must be 1-100%"
+                        << std::endl;
+                    return EXIT_FAILURE;
+                } else if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--reliability' is an "
+                        "option and must be placed before the command"
+                        << std::endl;
+                    return EXIT_FAILURE;
+                }
+                reliability = atoi(optarg);
+                break;
+
+            case OPTION_SCALE:
+                if (atoi(optarg) <= 0) {
+                    std::cerr << "Error: Scale must be >0us" << std::endl;
+                    return EXIT_FAILURE;
+                } else if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--scale' is an option "
+                        "and must be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                scale = atoi(optarg);
+                break;
+
+            case OPTION_SUMMARY:
+                if (task != nullptr) {
+                    std::cerr << "Error: Parameter '--summary' is an option "
+                        "and must be placed before the command" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                isSummary = true;
+                break;
+
             case 's':
                 if (atoi(optarg) == 0) {
                     std::cerr << "Error: Air scan duration must be >0ms"
@@ -115,7 +396,17 @@ int main(int argc, char **argv) {
                     return EXIT_FAILURE;
                 }
                 task = std::make_unique<Scan>(Scan(configuration,
-                    atoi(optarg), dumpFile));
+                    atoi(optarg), dumpFile, scale, isSummary));
+                break;
+
+            case OPTION_SEGMENTS:
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--segments')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<CaptureSegments>(CaptureSegments(
+                    configuration, std::string(optarg), dumpFile));
                 break;
 
             case 't':
@@ -128,14 +419,48 @@ int main(int argc, char **argv) {
                     std::string(optarg)));
                 break;
 
+            case OPTION_TUNE:
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '--tune')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<Tuning>(Tuning(configuration,
+                    std::string(optarg), confirmScript, reliability));
+                break;
+
+            case 'v':
+                if (task != nullptr) {
+                    std::cerr << "Error: Multiple commands are not supported "
+                        "(maybe omit parameter '-v')" << std::endl;
+                    return EXIT_FAILURE;
+                }
+                task = std::make_unique<Verification>(Verification(
+                    configuration, std::string(optarg), copies));
+                break;
+
             default:
                 printUsage();
                 return EXIT_FAILURE;
         }
     }
+    Timings::mark("options");
     if (task == nullptr) {
-        std::cerr << "Error: Either parameter '-r', '-s' or '-t' is mandatory"
-            << std::endl;
+        std::cerr << "Error: Either parameter '--archive', '--calibrate', "
+            "'--probe', '--repeat', '--segments', '--tune', '-a', '-b', '-i', "
+            "'-r', '-s', '-t' or '-v' is mandatory" << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Air scan dumps to be archived follow the options
+    if (archiveBuilder != nullptr) {
+        for (auto i = optind; i < argc; i++) {
+            archiveBuilder->addDumpFile(std::string(argv[i]));
+        }
+    } else if (optind < argc) {
+        std::cerr << "Error: Unexpected argument '" << argv[optind] << "' "
+            "(options must precede the command)" << std::endl;
         printUsage();
         return EXIT_FAILURE;
     }
@@ -144,10 +469,17 @@ int main(int argc, char **argv) {
     if (!configuration.load()) {
         return EXIT_FAILURE;
     }
+    Timings::mark("configuration");
 
     // Setup wiringPi (no port re-mapping, use Broadcom GPIO numbers)
     task->setGpioPin(gpio);
+    task->setInstanceLock(instanceLock);
     wiringPiSetupGpio();
+    Timings::mark("wiringPi");
 
-    return task->start();
+    const int exitCode = task->start();
+    Timings::report();
+    Metrics::write();
+    Trace::write();
+    return exitCode;
 }
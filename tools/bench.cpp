@@ -0,0 +1,455 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "CaptureIndex.h"
+#include "Clock.h"
+#include "Configuration.h"
+#include "EchoFilter.h"
+#include "Encoder.h"
+#include "Replay.h"
+#include "Scan.h"
+#include "TargetIndex.h"
+#include "TargetParameters.h"
+
+/// Number of heap allocations since program start.
+static uint64_t allocations = 0U;
+
+/**
+ * @brief Allocate memory, counting the allocations.
+ * @param size Number of bytes to allocate.
+ * @return Allocated memory.
+ */
+void * operator new(std::size_t size) {
+    allocations++;
+
+    void * memory = std::malloc((size > 0U) ? size : 1U);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+/// @param memory Memory to release.
+void operator delete(void * memory) noexcept {
+    std::free(memory);
+}
+
+/// @param memory Memory to release.
+void operator delete(void * memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+/**
+ * @brief Class running the micro-benchmarks of the hot paths.
+ *
+ * Every benchmark is repeated until it ran for at least MIN_DURATION_NS, the
+ * average duration and number of heap allocations per operation are written
+ * to stdout as tab separated values. Checks of the hot paths are run first,
+ * failing checks are written to stderr.
+ */
+class MicroBenchmark {
+public:
+    /// Class constructor.
+    MicroBenchmark(Configuration & configuration);
+
+    /// Run all checks and micro-benchmarks.
+    bool run(void);
+
+private:
+    /**
+     * @brief Minimum duration of a single benchmark.
+     * @note Unit: nanoseconds
+     */
+    static const int64_t MIN_DURATION_NS = 200000000;
+
+    /// Number of air scan samples used for the dump and rendering benchmarks.
+    static const size_t SCAN_SAMPLES = 100000U;
+
+    /// Number of edges of the pulse trains used for the echo filter check.
+    static const uint32_t ECHO_EDGES = 200U;
+
+    /// Dump file used for the dump benchmarks.
+    static const char * const DUMP_FILE;
+
+    /// Value Change Dump file used for the export benchmark.
+    static const char * const EXPORT_FILE;
+
+    /// Reference of the configuration.
+    Configuration & configuration_;
+
+    /// Stream buffer discarding all output.
+    class NullBuffer : public std::streambuf {
+    protected:
+        /// Discard a single character.
+        int overflow(int character) final {
+            return character;
+        }
+
+        /// Discard a sequence of characters.
+        std::streamsize xsputn(const char *, std::streamsize count) final {
+            return count;
+        }
+    };
+
+    /// Measure the given operation and print the result.
+    template<typename Operation>
+    static void measure(const std::string & name, Operation operation);
+
+    /// Benchmark encoding all built-in encodings.
+    void benchmarkEncoding(void) const;
+
+    /// Benchmark air scan dump serialization, deserialization and export.
+    void benchmarkDump(void) const;
+
+    /// Benchmark the ASCII rendering of air scans.
+    void benchmarkRendering(void) const;
+
+    /// Benchmark loading the configured targets.
+    void benchmarkTargets(void) const;
+
+    /// Check the echo filter of the live repeater.
+    static bool checkEchoFilter(void);
+
+    /// Count the edges of a repeated pulse train ignored as echo.
+    static uint32_t countEchoEdges(const int64_t highNs, const int64_t lowNs,
+        const bool isEchoed);
+
+    /// Generate air scan samples with pulses of varying lengths.
+    static std::vector<bool> generateSamples(const size_t count);
+};
+
+const char * const MicroBenchmark::DUMP_FILE = "/tmp/aircontrol-bench.asd";
+const char * const MicroBenchmark::EXPORT_FILE =
+    "/tmp/aircontrol-bench.vcd";
+
+/// @param configuration Reference of the loaded configuration.
+MicroBenchmark::MicroBenchmark(Configuration & configuration) :
+        configuration_(configuration) {
+    // Do nothing
+}
+
+/// @return True if all checks have passed, false otherwise.
+bool MicroBenchmark::run(void) {
+    if (!checkEchoFilter()) {
+        return false;
+    }
+
+    std::cout << "# name\tnsPerOp\tallocsPerOp\titerations" << std::endl;
+
+    benchmarkEncoding();
+    benchmarkDump();
+    benchmarkRendering();
+    benchmarkTargets();
+
+    return true;
+}
+
+/**
+ * The operation is run once for warming up, then the number of iterations is
+ * doubled until the benchmark takes at least MIN_DURATION_NS. Output of the
+ * operation to stdout is discarded, output to stderr is only shown for the
+ * warm-up run.
+ *
+ * @param name Benchmark name.
+ * @param operation Operation to measure.
+ */
+template<typename Operation>
+void MicroBenchmark::measure(const std::string & name, Operation operation) {
+    NullBuffer nullBuffer;
+    std::streambuf * const stdoutBuffer = std::cout.rdbuf(&nullBuffer);
+
+    operation();
+    std::streambuf * const stderrBuffer = std::cerr.rdbuf(&nullBuffer);
+
+    uint64_t iterations = 1U;
+    int64_t durationNs;
+    uint64_t operationAllocations;
+    for (;;) {
+        const uint64_t startAllocations = allocations;
+        const int64_t startNs = Clock::now();
+        for (auto i = 0U; i < iterations; i++) {
+            operation();
+        }
+        durationNs = Clock::now() - startNs;
+        operationAllocations = allocations - startAllocations;
+
+        if (durationNs >= MIN_DURATION_NS) {
+            break;
+        }
+        iterations *= 2U;
+    }
+
+    std::cerr.rdbuf(stderrBuffer);
+    std::cout.rdbuf(stdoutBuffer);
+    std::cout << name << "\t" << (durationNs / iterations) << "\t"
+        << (static_cast<double>(operationAllocations) / iterations) << "\t"
+        << iterations << std::endl;
+}
+
+void MicroBenchmark::benchmarkEncoding(void) const {
+    const int32_t DATA_LENGTH_US = 1780;
+    const int32_t SYNC_LENGTH_US = 5000;
+    const size_t AIR_COMMAND_LENGTH = 64U;
+
+    for (auto airCode = 0; airCode < Types::AirCode::MAX; airCode++) {
+        const Encoder::Encoding & encoding = Encoder::getBuiltIn(
+            static_cast<Types::AirCode::AirCode_>(airCode));
+        const std::string elements = Encoder::getElements(encoding);
+
+        std::string airCommand;
+        for (auto i = 0U; i < AIR_COMMAND_LENGTH; i++) {
+            airCommand += elements.at(i % elements.length());
+        }
+
+        measure(std::string("encode/") + encoding.name, [&]() {
+            Encoder::encode(encoding, airCommand, DATA_LENGTH_US,
+                SYNC_LENGTH_US);
+        });
+    }
+}
+
+void MicroBenchmark::benchmarkDump(void) const {
+    const std::vector<bool> samples = generateSamples(SCAN_SAMPLES);
+
+    Scan scan(configuration_, 0, DUMP_FILE, 0, false);
+    if (!scan.setData(samples)) {
+        std::cerr << "Warning: Skipping dump benchmarks, no valid 'scan' "
+            "section" << std::endl;
+        return;
+    }
+
+    measure("dump/serialize", [&]() {
+        scan.writeData();
+    });
+
+    measure("dump/deserialize", [&]() {
+        Replay replay(configuration_, DUMP_FILE);
+        replay.load();
+    });
+
+    std::remove(DUMP_FILE);
+    std::remove((DUMP_FILE + CaptureIndex::SUFFIX).c_str());
+
+    Scan exportScan(configuration_, 0, EXPORT_FILE, 0, false);
+    exportScan.setData(samples);
+
+    measure("dump/export", [&]() {
+        exportScan.writeData();
+    });
+
+    std::remove(EXPORT_FILE);
+}
+
+void MicroBenchmark::benchmarkRendering(void) const {
+    const std::vector<bool> samples = generateSamples(SCAN_SAMPLES);
+
+    Scan scan(configuration_, 0, "", 0, false);
+    if (!scan.setData(samples)) {
+        std::cerr << "Warning: Skipping rendering benchmarks, no valid 'scan' "
+            "section" << std::endl;
+        return;
+    }
+
+    measure("scan/print", [&]() {
+        scan.writeData();
+    });
+
+    Scan summaryScan(configuration_, 0, "", 0, true);
+    summaryScan.setData(samples);
+
+    measure("scan/summary", [&]() {
+        summaryScan.writeData();
+    });
+}
+
+/**
+ * Targets are loaded individually from the configuration as well as all at
+ * once into a target index, followed by looking them up in the index. The
+ * target cache is not used.
+ */
+void MicroBenchmark::benchmarkTargets(void) const {
+    TargetIndex index(configuration_);
+    index.build(false);
+    const std::vector<std::string> names = index.getNames();
+
+    measure("targets/load", [&]() {
+        for (const std::string & name : names) {
+            TargetParameters parameters(configuration_, name);
+            parameters.load();
+        }
+    });
+
+    measure("targets/index", [&]() {
+        TargetIndex targetIndex(configuration_);
+        targetIndex.build(false);
+    });
+
+    measure("targets/find", [&]() {
+        for (const std::string & name : names) {
+            index.find(name);
+        }
+    });
+}
+
+/**
+ * Pulse trains without echo must be repeated completely, the echo of every
+ * repeated edge must be ignored. The pulse trains include the default data
+ * length of the configuration and do not have a period within a sampling
+ * period above the latency.
+ *
+ * @return True if the check has passed, false otherwise.
+ */
+bool MicroBenchmark::checkEchoFilter(void) {
+    const int64_t PULSES_US[][2] = { { 445, 1335 }, { 300, 900 },
+        { 150, 450 }, { 1780, 1780 }, { 5000, 1000 } };
+    bool isPassed = true;
+
+    for (const auto & pulses : PULSES_US) {
+        const int64_t highNs = pulses[0] * Clock::NS_PER_US;
+        const int64_t lowNs = pulses[1] * Clock::NS_PER_US;
+        const uint32_t echoFree = countEchoEdges(highNs, lowNs, false);
+        const uint32_t echoed = countEchoEdges(highNs, lowNs, true);
+
+        if ((echoFree != 0U) || (echoed != ECHO_EDGES)) {
+            std::cerr << "Error: Echo filter ignored " << echoFree << " of "
+                << ECHO_EDGES << " edges without echo and " << echoed << " of "
+                << ECHO_EDGES << " echo edges of the pulse train " << pulses[0]
+                << "us/" << pulses[1] << "us" << std::endl;
+            isPassed = false;
+        }
+    }
+
+    return isPassed;
+}
+
+/**
+ * The edges are captured on a grid of 100us and written 1ms plus 50us of
+ * wake-up jitter later. Echoes are captured by the first sample after an edge
+ * has been written, they are merged with the edges of the pulse train.
+ *
+ * @param highNs Length of the high pulses (unit: nanoseconds).
+ * @param lowNs Length of the low pulses (unit: nanoseconds).
+ * @param isEchoed True to capture the echo of every written edge.
+ * @return Number of edges ignored as echo.
+ */
+uint32_t MicroBenchmark::countEchoEdges(const int64_t highNs,
+        const int64_t lowNs, const bool isEchoed) {
+    const int64_t SAMPLING_RATE_NS = 100000;
+    const int64_t LATENCY_NS = 1000000;
+    const int64_t JITTER_NS = 50000;
+
+    // Edges of the pulse train, rounded up to the next sample
+    std::vector<EdgeQueue::Edge> captured;
+    int64_t timeNs = 0;
+    for (auto i = 0U; i < ECHO_EDGES; i++) {
+        const int64_t sampleNs = (timeNs + SAMPLING_RATE_NS - 1)
+            / SAMPLING_RATE_NS * SAMPLING_RATE_NS;
+        captured.push_back({ sampleNs, (i % 2U) == 0U });
+        timeNs += ((i % 2U) == 0U) ? highNs : lowNs;
+    }
+    if (isEchoed) {
+        for (auto i = 0U; i < ECHO_EDGES; i++) {
+            const int64_t writtenNs = captured[i].timeNs + LATENCY_NS
+                + JITTER_NS;
+            captured.push_back({ (writtenNs / SAMPLING_RATE_NS + 1)
+                * SAMPLING_RATE_NS, captured[i].level });
+        }
+        std::stable_sort(captured.begin(), captured.end(),
+            [](const EdgeQueue::Edge & a, const EdgeQueue::Edge & b) {
+                return a.timeNs < b.timeNs;
+            });
+    }
+
+    // Repeat the captured edges like the repeater without filter
+    EchoFilter echoFilter(SAMPLING_RATE_NS);
+    uint32_t echoEdges = 0U;
+    for (const EdgeQueue::Edge & edge : captured) {
+        if (echoFilter.isEcho(edge)) {
+            echoEdges++;
+        } else {
+            echoFilter.addWritten(edge.level, edge.timeNs + LATENCY_NS
+                + JITTER_NS);
+        }
+    }
+
+    return echoEdges;
+}
+
+/**
+ * @param count Number of samples to generate.
+ * @return Reproducible samples alternating between low and high with run
+ *         lengths of 1 to 16 samples.
+ */
+std::vector<bool> MicroBenchmark::generateSamples(const size_t count) {
+    std::vector<bool> samples;
+    uint32_t random = 1U;
+    bool level = false;
+
+    samples.reserve(count);
+    while (samples.size() < count) {
+        random = random * 1103515245U + 12345U;
+        for (auto i = 0U; (i <= ((random >> 16) & 0xFU))
+                && (samples.size() < count); i++) {
+            samples.push_back(level);
+        }
+        level = !level;
+    }
+
+    return samples;
+}
+
+/**
+ * @brief Run the micro-benchmarks.
+ *
+ * Target related benchmarks use the targets of the given configuration file.
+ * Invalid targets are reported by the warm-up runs and included in the
+ * measurements.
+ *
+ * @param argc Number of elements in argv.
+ * @param argv Program name and configuration file.
+ * @return Exit code.
+ */
+int main(int argc, char **argv) {
+    Configuration configuration;
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <configuration file>"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    configuration.setLocation(argv[1]);
+    if (!configuration.load()) {
+        return EXIT_FAILURE;
+    }
+
+    MicroBenchmark benchmark(configuration);
+
+    return benchmark.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
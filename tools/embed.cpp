@@ -0,0 +1,149 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Configuration.h"
+#include "TargetIndex.h"
+#include "TargetParameters.h"
+
+/**
+ * @brief Generate the embedded targets header.
+ *
+ * All valid targets of the given configuration file are written to stdout as
+ * constant pulse tables encoded at compile time, see Embedded. Invalid targets
+ * are reported and skipped.
+ *
+ * @param argc Number of elements in argv.
+ * @param argv Program name and configuration file.
+ * @return Exit code.
+ */
+int main(int argc, char **argv) {
+    Configuration configuration;
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <configuration file>"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    configuration.setLocation(argv[1]);
+    if (!configuration.load()) {
+        return EXIT_FAILURE;
+    }
+
+    TargetIndex index(configuration);
+    index.build(false);
+
+    // Sort the targets by name, this allows a binary search at run time
+    std::vector<std::string> names = index.getNames();
+    std::sort(names.begin(), names.end());
+
+    std::vector<const TargetParameters *> targets;
+    for (const std::string & name : names) {
+        const TargetParameters * parameters = index.find(name);
+        if (parameters == nullptr) {
+            std::cerr << "Warning: Target " << name << " will not be embedded"
+                << std::endl;
+        } else {
+            targets.push_back(parameters);
+        }
+    }
+    if (targets.size() == 0U) {
+        std::cerr << "Error: No valid targets found in " << argv[1]
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "// This file will be generated by 'make embed'. Do not edit, "
+        "any changes will" << std::endl
+        << "// be lost. See 'tools/embed.cpp'." << std::endl
+        << std::endl
+        << "#pragma once" << std::endl
+        << std::endl
+        << "#include \"Embedded.h\"" << std::endl
+        << std::endl
+        << "/// Namespace for the generated embedded targets." << std::endl
+        << "namespace EmbeddedTargets {" << std::endl;
+
+    for (auto i = 0U; i < targets.size(); i++) {
+        const TargetParameters & parameters = *targets.at(i);
+        const std::string airCode = "static_cast<Types::AirCode::AirCode_>("
+            + std::to_string(parameters.getAirCode()) + ")";
+
+        // User-defined encodings are unknown at compile time
+        if (parameters.getAirCode() == Types::AirCode::MAX) {
+            const std::vector<Types::Pulse> & pulses = parameters.getPulses();
+
+            std::cout << std::endl
+                << "// Target '" << parameters.getName() << "' (encoding '"
+                << parameters.getEncoding() << "')" << std::endl
+                << "constexpr Embedded::PulseTable<" << pulses.size()
+                << "> PULSES_" << i << " = { {";
+            for (auto pulse = 0U; pulse < pulses.size(); pulse++) {
+                std::cout << ((pulse % 4U == 0U) ? "\n    " : " ") << "{ "
+                    << pulses.at(pulse).level << "U, "
+                    << pulses.at(pulse).durationNs << "U },";
+            }
+            std::cout << std::endl << "} };" << std::endl;
+            continue;
+        }
+
+        std::cout << std::endl
+            << "// Target '" << parameters.getName() << "'" << std::endl
+            << "constexpr char AIR_COMMAND_" << i << "[] = \""
+            << parameters.getAirCommand() << "\";" << std::endl
+            << "constexpr auto PULSES_" << i << " = Embedded::encode<"
+            << std::endl
+            << "    Embedded::countPulses(" << airCode << ", AIR_COMMAND_" << i
+            << ")>(" << std::endl
+            << "    " << airCode << ", AIR_COMMAND_" << i << ", "
+            << parameters.getDataLength() << ", "
+            << parameters.getSyncLength() << ");" << std::endl;
+    }
+
+    std::cout << std::endl
+        << "/// All embedded targets, sorted by name." << std::endl
+        << "constexpr Embedded::Target TARGETS[] = {" << std::endl;
+    for (auto i = 0U; i < targets.size(); i++) {
+        const TargetParameters & parameters = *targets.at(i);
+
+        std::cout << "    { \"" << parameters.getName() << "\", "
+            << +parameters.getGpioPin() << ", "
+            << parameters.getSendCommand() << ", "
+            << parameters.getSendDelay() << ", "
+            << parameters.getFrameTolerance() << ", "
+            << parameters.getMaxRetransmissions() << ", "
+            << parameters.getListenBeforeTalk() << ", "
+            << parameters.getDutyCycle() << ", "
+            << parameters.getDutyCycleWindow() << ", PULSES_" << i
+            << ".pulses, "
+            << "sizeof(PULSES_" << i << ".pulses) / sizeof(Types::Pulse) },"
+            << std::endl;
+    }
+    std::cout << "};" << std::endl
+        << std::endl
+        << "} // namespace EmbeddedTargets" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "InstanceLock.h"
+
+/**
+ * @brief Class testing the FIFO ordering of the instance lock.
+ *
+ * Every instance is a child process holding the lock of the same GPIO pin,
+ * it reports acquiring the lock through a pipe and keeps it until it is
+ * terminated.
+ */
+class LockTest {
+public:
+    /// Run all tests.
+    bool run(void);
+
+private:
+    /// GPIO pin unlikely to be used by a real transmitter.
+    static const uint8_t GPIO_PIN = 250U;
+
+    /**
+     * @brief Time to wait for an instance not expected to acquire the lock.
+     * @note Unit: milliseconds
+     */
+    static const int IDLE_TIMEOUT_MS = 500;
+
+    /**
+     * @brief Time to wait for an instance expected to acquire the lock.
+     * @note Unit: milliseconds
+     */
+    static const int ACQUIRE_TIMEOUT_MS = 5000;
+
+    /// Program instance holding the lock.
+    struct Instance {
+        /// Process ID.
+        pid_t pid;
+
+        /// Pipe the instance reports acquiring the lock to.
+        int acquired;
+    };
+
+    /// Start an instance trying to acquire the lock.
+    static bool start(Instance & instance);
+
+    /// Wait until the instance acquired the lock.
+    static bool isAcquired(const Instance & instance, const int timeoutMs);
+
+    /// Wait until the instance drew a ticket.
+    static void waitForTicket(const uint64_t ticket);
+
+    /// Terminate the instance, releasing the lock.
+    static void stop(const Instance & instance);
+
+    /// Print the result of a check.
+    static bool check(const std::string & name, const bool isPassed);
+
+    /// Test that a terminated waiter does not let its successor through.
+    bool testTerminatedWaiter(void);
+};
+
+bool LockTest::run(void) {
+    return testTerminatedWaiter();
+}
+
+/**
+ * @param instance Instance to be set.
+ * @return True if the instance has been started, false otherwise.
+ */
+bool LockTest::start(Instance & instance) {
+    int acquired[2];
+
+    if (pipe(acquired) != 0) {
+        return false;
+    }
+
+    instance.pid = fork();
+    if (instance.pid < 0) {
+        return false;
+    }
+    if (instance.pid == 0) {
+        const char ACQUIRED = 'a';
+
+        close(acquired[0]);
+        if (!InstanceLock::lock(GPIO_PIN)
+                || (write(acquired[1], &ACQUIRED, 1) != 1)) {
+            _exit(EXIT_FAILURE);
+        }
+        for (;;) {
+            // Keep the lock until terminated
+            pause();
+        }
+    }
+
+    close(acquired[1]);
+    instance.acquired = acquired[0];
+
+    return true;
+}
+
+/**
+ * @param instance Instance to be checked.
+ * @param timeoutMs Time to wait at most (unit: milliseconds).
+ * @return True if the instance acquired the lock, false otherwise.
+ */
+bool LockTest::isAcquired(const Instance & instance, const int timeoutMs) {
+    struct pollfd descriptor = { instance.acquired, POLLIN, 0 };
+    char acquired;
+
+    return (poll(&descriptor, 1, timeoutMs) == 1)
+        && (read(instance.acquired, &acquired, 1) == 1);
+}
+
+/**
+ * The ticket counter is stored at the beginning of the lock file, see
+ * InstanceLock.
+ *
+ * @param ticket Number of tickets to be drawn.
+ */
+void LockTest::waitForTicket(const uint64_t ticket) {
+    const std::string lockFile = "/tmp/aircontrol-gpio"
+        + std::to_string(GPIO_PIN) + ".lock";
+
+    for (auto i = 0; i < ACQUIRE_TIMEOUT_MS; i++) {
+        FILE * file = fopen(lockFile.c_str(), "rb");
+        uint64_t counter = 0U;
+        if (file != nullptr) {
+            if (fread(&counter, sizeof(counter), 1, file) != 1) {
+                counter = 0U;
+            }
+            fclose(file);
+        }
+        if (counter >= ticket) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+/// @param instance Instance to be stopped.
+void LockTest::stop(const Instance & instance) {
+    kill(instance.pid, SIGTERM);
+    close(instance.acquired);
+    waitpid(instance.pid, nullptr, 0);
+}
+
+/**
+ * @param name Name of the check.
+ * @param isPassed Result of the check.
+ * @return Result of the check.
+ */
+bool LockTest::check(const std::string & name, const bool isPassed) {
+    std::cout << (isPassed ? "PASS" : "FAIL") << "\t" << name << std::endl;
+
+    return isPassed;
+}
+
+/**
+ * Instance A holds the lock while B and C are waiting in this order. B is
+ * killed, C must keep waiting until A released the lock.
+ *
+ * @return True if the test passed, false otherwise.
+ */
+bool LockTest::testTerminatedWaiter(void) {
+    Instance a;
+    Instance b;
+    Instance c;
+    bool isPassed = true;
+
+    // Start counting tickets from zero
+    unlink(("/tmp/aircontrol-gpio" + std::to_string(GPIO_PIN)
+        + ".lock").c_str());
+
+    if (!start(a) || !isAcquired(a, ACQUIRE_TIMEOUT_MS)) {
+        return check("first instance acquires the lock", false);
+    }
+    if (!start(b)) {
+        stop(a);
+        return false;
+    }
+    waitForTicket(2U);
+    if (!start(c)) {
+        stop(a);
+        stop(b);
+        return false;
+    }
+    waitForTicket(3U);
+
+    kill(b.pid, SIGKILL);
+    stop(b);
+
+    isPassed &= check("successor of a killed waiter keeps waiting",
+        !isAcquired(c, IDLE_TIMEOUT_MS));
+    stop(a);
+    isPassed &= check("successor acquires the lock after release",
+        isAcquired(c, ACQUIRE_TIMEOUT_MS));
+    stop(c);
+
+    return isPassed;
+}
+
+/**
+ * @brief Run the instance lock tests.
+ * @return Exit code.
+ */
+int main(void) {
+    LockTest test;
+
+    return test.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of aircontrol.
+ *
+ * Copyright (C) 2014-2022 Ralf Dauberschmidt <ralf@dauberschmidt.de>
+ *
+ * aircontrol is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * aircontrol is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with aircontrol.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * @brief Minimal wiringPi replacement for building on hosts without wiringPi.
+ *
+ * Provides the subset of the wiringPi API used by aircontrol without touching
+ * any hardware. GPIO pins read low and writes are discarded. Only used by the
+ * micro-benchmarks, see tools/bench.cpp.
+ */
+
+#pragma once
+
+#define LOW 0
+#define HIGH 1
+
+#define INPUT 0
+#define OUTPUT 1
+
+/// Set up the GPIO access, always succeeds.
+inline int wiringPiSetupGpio(void) {
+    return 0;
+}
+
+/// Get the board revision, always a revision 2 board.
+inline int piBoardRev(void) {
+    return 2;
+}
+
+/// Set the mode of a GPIO pin, has no effect.
+inline void pinMode(int, int) {
+    // Do nothing
+}
+
+/// Write a GPIO pin, the value is discarded.
+inline void digitalWrite(int, int) {
+    // Do nothing
+}
+
+/// Read a GPIO pin, always low.
+inline int digitalRead(int) {
+    return LOW;
+}